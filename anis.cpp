@@ -9,6 +9,8 @@
 #include "core/lang/parser.h"
 #include "core/lang/interpreter.h"
 #include "core/lang/debugger.h"
+#include "core/lang/module_cache.h"
+#include "core/lang/profiler.h"
 #include "lib/gui/minigui.h"
 #include "lib/gui/layout.h"
 #include "lib/register.h"
@@ -20,8 +22,18 @@
 #include <chrono>
 #ifdef __linux__
 #include <execinfo.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
 #endif
 #include <unistd.h>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
 
 // crash handler
 void crash_handler(int sig) {
@@ -66,14 +78,101 @@ AppState appState;
 
 // Static member now defined inline in debugger.h
 
+// Execution engine selected with --interp
+bool g_useBytecode = true;
+
+// Call depth limit (--max-depth) and size of the stack scripts run on (--stack-size, in MB)
+int g_maxCallDepth = 100000;
+size_t g_stackMB = sizeof(void*) >= 8 ? 1024 : 256;
+
+// Runs the interpreter on a large heap-allocated stack, on the calling thread (GUI toolkits need
+// the main thread), and registers it with the interpreter. Deep non-tail recursion then reaches
+// the depth limit and raises a RangeError instead of overflowing the default 1-8 MB stack.
+static std::function<int()> g_stackTask;
+static int g_stackResult = 0;
+
+#if defined(__linux__)
+static ucontext_t g_callerContext;
+static void stackEntry() { g_stackResult = g_stackTask(); } // uc_link switches back when done
+#elif defined(_WIN32)
+static LPVOID g_callerFiber = nullptr;
+static void CALLBACK stackEntry(LPVOID size) {
+    char marker;
+    Interpreter::setNativeStack(&marker - reinterpret_cast<size_t>(size) + 64 * 1024, reinterpret_cast<size_t>(size) - 64 * 1024);
+    g_stackResult = g_stackTask();
+    SwitchToFiber(g_callerFiber);
+}
+#endif
+
+int runOnLargeStack(std::function<int()> task) {
+    size_t size = g_stackMB * 1024 * 1024;
+    g_stackTask = std::move(task);
+#if defined(__linux__)
+    // Reserved, not committed: pages are only backed once recursion reaches them
+    char* stack = static_cast<char*>(mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0));
+    if (stack == MAP_FAILED) return g_stackTask();
+    mprotect(stack, 4096, PROT_NONE); // Guard page
+    ucontext_t context;
+    getcontext(&context);
+    context.uc_stack.ss_sp = stack;
+    context.uc_stack.ss_size = size;
+    context.uc_link = &g_callerContext;
+    makecontext(&context, stackEntry, 0);
+    Interpreter::setNativeStack(stack + 4096, size - 4096);
+    swapcontext(&g_callerContext, &context);
+    Interpreter::setNativeStack(nullptr, 0);
+    munmap(stack, size);
+    return g_stackResult;
+#elif defined(_WIN32)
+    g_callerFiber = ConvertThreadToFiber(nullptr);
+    LPVOID fiber = g_callerFiber ? CreateFiberEx(64 * 1024, size, FIBER_FLAG_FLOAT_SWITCH, stackEntry, reinterpret_cast<LPVOID>(size)) : nullptr;
+    if (!fiber) return g_stackTask();
+    SwitchToFiber(fiber);
+    DeleteFiber(fiber);
+    ConvertFiberToThread();
+    Interpreter::setNativeStack(nullptr, 0);
+    return g_stackResult;
+#elif defined(__APPLE__)
+    // No stack switching here: guard the main thread's own stack instead
+    pthread_t self = pthread_self();
+    size_t mainSize = pthread_get_stacksize_np(self);
+    Interpreter::setNativeStack(static_cast<char*>(pthread_get_stackaddr_np(self)) - mainSize, mainSize);
+    return g_stackTask();
+#else
+    return g_stackTask();
+#endif
+}
+
+// "RangeError: message" for error objects, the plain value otherwise
+static std::string describeThrown(const Value& thrown) {
+    if (auto* fields = thrown.mapVal()) {
+        std::string message = fields->count("message") ? fields->at("message").toString() : thrown.toString();
+        return fields->count("name") ? fields->at("name").toString() + ": " + message : message;
+    }
+    return thrown.toString();
+}
+
 void printHelp() {
     std::cout << COLOR_CYAN << "Anis Programming Language" << COLOR_RESET << std::endl;
     std::cout << std::endl;
     std::cout << COLOR_GREEN << "USAGE:" << COLOR_RESET << std::endl;
     std::cout << "  anis                        Enter REPL mode" << std::endl;
-    std::cout << "  anis <file.anis>              Run an Anis script" << std::endl;
+    std::cout << "  anis [options] <file.anis>  Run an Anis script" << std::endl;
     std::cout << "  anis --help                 Show this help message" << std::endl;
     std::cout << std::endl;
+    std::cout << COLOR_GREEN << "OPTIONS:" << COLOR_RESET << std::endl;
+    std::cout << "  --dump-tokens               Print the token stream and exit" << std::endl;
+    std::cout << "  --interp=vm|ast             Execution engine (default: vm bytecode, ast: tree-walker)" << std::endl;
+    std::cout << "  --no-cache                  Parse every module from source; skip .anisc files" << std::endl;
+    std::cout << "  --rebuild-cache             Parse every module and rewrite its .anisc file" << std::endl;
+    std::cout << "  --startup-timing            Report module load times, time to first statement and lazy parsing" << std::endl;
+    std::cout << "  --profile[=HZ]              Sample script call stacks (default 1000 Hz of CPU time);" << std::endl;
+    std::cout << "                              folded stacks to anis.folded, summary on exit or SIGUSR1" << std::endl;
+    std::cout << "  --profile-out=FILE          Where --profile writes folded stacks" << std::endl;
+    std::cout << "  --max-depth=N               Call depth before a RangeError (default: 100000)" << std::endl;
+    std::cout << "  --stack-size=MB             Stack reserved for scripts (default: 1024)" << std::endl;
+    std::cout << std::endl;
     std::cout << COLOR_GREEN << "EXAMPLES:" << COLOR_RESET << std::endl;
     std::cout << "  anis                        Start interactive shell" << std::endl;
     std::cout << "  anis examples/hello.anis      Run hello.anis" << std::endl;
@@ -92,6 +191,8 @@ void printHelp() {
 void runREPL() {
     Debugger::isReplMode = true;
     Interpreter interpreter;
+    interpreter.useBytecode = g_useBytecode;
+    interpreter.maxCallDepth = g_maxCallDepth;
     register_std_libs(interpreter);
 
     std::cout << COLOR_CYAN << "Anis REPL (v1.0.0)" << COLOR_RESET << std::endl;
@@ -109,7 +210,7 @@ void runREPL() {
             std::vector<Token> tokens = lexer.tokenize();
 
             // 2. Parse
-            Parser parser(tokens);
+            Parser parser(std::move(tokens));
             std::vector<std::shared_ptr<Stmt>> statements = parser.parse();
 
             // 3. Interpret
@@ -120,6 +221,10 @@ void runREPL() {
             if (interpreter.hasLastExpressionValue) {
                 std::cout << COLOR_BLUE << "=> " << COLOR_RESET << interpreter.lastExpressionValue.toString() << std::endl;
             }
+        } catch (const RuntimeError& e) {
+            Debugger::restoreThrownStack();
+            Debugger::runtimeError("Uncaught " + describeThrown(e.value));
+            Debugger::clearCallStack();
         } catch (const std::exception& e) {
             // Error already printed by Debugger if it didn't exit
         } catch (...) {
@@ -147,35 +252,43 @@ int runFile(std::string filePath, bool dumpTokens) {
         g_basePath = filePath.substr(0, lastSlash + 1);
     }
 
-    try {
-        // 1. Lex
+    if (dumpTokens) {
         Lexer lexer(source);
-        std::vector<Token> tokens = lexer.tokenize();
-        
-        if (dumpTokens) {
-            std::cout << "TOKENS:" << std::endl;
-            for (const auto& t : tokens) {
-                std::cout << "Line " << t.line << ": " << t.type << " '" << t.text << "'" << std::endl;
-            }
-            return 0;
+        std::cout << "TOKENS:" << std::endl;
+        for (const auto& t : lexer.tokenize()) {
+            std::cout << "Line " << t.line << ": " << t.type << " '" << t.text << "'" << std::endl;
         }
+        return 0;
+    }
 
-        // 2. Parse
-        Parser parser(tokens);
-        std::vector<std::shared_ptr<Stmt>> statements = parser.parse();
+    try {
+        // 1. Lex and parse, or load the cached AST
+        std::vector<std::shared_ptr<Stmt>> statements = ModuleCache::parse(filePath, source);
 
         // 3. Interpret
         Interpreter interpreter;
         interpreter.sourceCode = source;
         interpreter.currentFile = filePath;
+        Module& main = interpreter.modules.addMain(filePath, source);
+        interpreter.useBytecode = g_useBytecode;
+        interpreter.maxCallDepth = g_maxCallDepth;
         
         register_std_libs(interpreter);
+        interpreter.modules.prefetch(main, statements);
+        ModuleCache::noteScriptStart();
+        Profiler::start(filePath);
         interpreter.interpret(statements);
+        Profiler::stop();
+    } catch (const RuntimeError& e) {
+        Debugger::restoreThrownStack(); // Unwinding emptied the live stack
+        Debugger::runtimeError("Uncaught " + describeThrown(e.value));
+        return 1;
     } catch (...) {
         // Errors handled by Debugger
         return 1;
     }
 
+    ModuleCache::reportTiming();
     return 0;
 }
 
@@ -185,26 +298,53 @@ int main(int argc, char* argv[]) {
     curl_global_init(CURL_GLOBAL_ALL);
 
     int result = 0;
-    if (argc < 2) {
-        runREPL();
-    } else {
-        bool dumpTokens = false;
-        std::string filePath;
-        
-        if (std::string(argv[1]) == "--help") {
-            printHelp();
-        } else if (std::string(argv[1]) == "--dump-tokens") {
+    bool dumpTokens = false;
+    bool showHelp = false;
+    std::string filePath;
+    
+    // Options come before the script path; everything after it belongs to the script
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help") {
+            showHelp = true;
+        } else if (arg == "--dump-tokens") {
             dumpTokens = true;
-            if (argc > 2) filePath = argv[2];
+        } else if (arg == "--interp=ast") {
+            g_useBytecode = false;
+        } else if (arg == "--interp=vm") {
+            g_useBytecode = true;
+        } else if (arg == "--no-cache") {
+            ModuleCache::mode = ModuleCache::Mode::Off;
+        } else if (arg == "--rebuild-cache") {
+            ModuleCache::mode = ModuleCache::Mode::Rebuild;
+        } else if (arg == "--startup-timing") {
+            ModuleCache::timing = true;
+        } else if (arg == "--profile") {
+            Profiler::hz = 1000;
+        } else if (arg.rfind("--profile=", 0) == 0) {
+            Profiler::hz = std::clamp(std::atoi(arg.c_str() + 10), 1, 10000);
+        } else if (arg.rfind("--profile-out=", 0) == 0) {
+            Profiler::outputPath = arg.substr(14);
+        } else if (arg.rfind("--max-depth=", 0) == 0) {
+            g_maxCallDepth = std::max(1, std::atoi(arg.c_str() + 12));
+        } else if (arg.rfind("--stack-size=", 0) == 0) {
+            g_stackMB = std::max(8, std::atoi(arg.c_str() + 13));
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
         } else {
-            filePath = argv[1];
-            if (argc > 2 && std::string(argv[2]) == "--dump-tokens") dumpTokens = true;
-        }
-
-        if (!filePath.empty()) {
-            result = runFile(filePath, dumpTokens);
+            filePath = arg;
+            break;
         }
     }
+    
+    if (showHelp) {
+        printHelp();
+    } else if (filePath.empty()) {
+        runOnLargeStack([] { runREPL(); return 0; });
+    } else {
+        result = runOnLargeStack([&] { return runFile(filePath, dumpTokens); });
+    }
 
     curl_global_cleanup();
     return result;
@@ -0,0 +1,373 @@
+// Benchmark suite: C++ microbenchmarks of the interpreter and library layers, then the
+// bench/*.anis scripts run with the real interpreter. Prints one JSON document, stable in key
+// order and one result per line, so two runs diff cleanly:
+//
+//   make bench                                   (writes build/bench/results.json)
+//   micro_bench [--anis=PATH] [--filter=TEXT] [script.anis...]
+//
+// Each microbenchmark reports the best of several timed rounds, in nanoseconds per item processed
+// (a token, a loop iteration, a byte of JSON, a row...) and in items per second. Scripts report
+// every "name: N ms" line they print. They run with ScriptFlags, recorded in the JSON: without
+// the module cache, so every run compiles its source and none writes .anisc files into bench/.
+#include "core/lang/interpreter.h"
+#include "core/lang/lexer.h"
+#include "lib/json/json_lib.h"
+#include "lib/webserver/http_parser.h"
+#include "lib/database/drivers/sqlite_driver.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <sstream>
+
+// Normally defined by the GUI layer, which the suite does not link
+std::string g_basePath;
+
+namespace {
+
+struct Result {
+    std::string name;
+    std::string per; // What one item is
+    double nsPerItem;
+};
+
+std::vector<Result> results;
+std::string filter;
+
+double nowNs() {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Runs `op` (which processes `items` items) in batches of at least 50 ms, five times, and keeps
+// the fastest batch: the least disturbed by the rest of the machine
+void bench(const std::string& name, const std::string& per, size_t items, const std::function<void()>& op) {
+    if (!filter.empty() && name.find(filter) == std::string::npos) return;
+    op(); // Warm up caches and lazy state
+    size_t reps = 1;
+    for (;;) {
+        double start = nowNs();
+        for (size_t i = 0; i < reps; i++) op();
+        if (nowNs() - start >= 50e6 || reps >= (1u << 30)) break;
+        reps *= 2;
+    }
+    double best = 1e300;
+    for (int round = 0; round < 5; round++) {
+        double start = nowNs();
+        for (size_t i = 0; i < reps; i++) op();
+        best = std::min(best, (nowNs() - start) / (double)(reps * items));
+    }
+    results.push_back({name, per, best});
+    std::cerr << "  " << name << ": " << best << " ns/" << per << std::endl;
+}
+
+// Something the optimizer cannot prove unused
+volatile size_t sink;
+
+// A program using most of the syntax, `copies` times over with distinct names
+std::string sampleProgram(int copies) {
+    std::string out;
+    for (int i = 0; i < copies; i++) {
+        std::string n = std::to_string(i);
+        out += "// Section " + n + "\n"
+               "function area" + n + "(w, h = 2, ...rest) {\n"
+               "    var label = \"area \" + w + 'x' + h;\n"
+               "    if (w > 10 && h <= 3.5) { return w * h; } else { return w / h - 1; }\n"
+               "}\n"
+               "var shape" + n + " = { name: `box`, size: [1, 2, 3], nested: { deep: true } };\n"
+               "const scale" + n + " = (x) => x * 1.5e2;\n"
+               "class Point" + n + " {\n"
+               "    constructor(x, y) { this.x = x; this.y = y; }\n"
+               "    length() { return this.x * this.x + this.y * this.y; }\n"
+               "}\n"
+               "var k" + n + " = 0;\n"
+               "while (k" + n + " < 10) { k" + n + " = k" + n + " + 1; if (k" + n + " == 5) continue; }\n"
+               "var p" + n + " = new Point" + n + "(3, 4);\n"
+               "println(area" + n + "(p" + n + ".length(), 2) + shape" + n + ".size[1] + scale" + n + "(k" + n + "));\n";
+    }
+    return out;
+}
+
+// One object literal of `entries` nested records, as in a generated config or fixture file
+std::string configTable(int entries) {
+    std::string out = "var config = {\n";
+    for (int i = 0; i < entries; i++) {
+        std::string n = std::to_string(i);
+        out += "    service" + n + ": { name: \"svc-" + n + "\", port: " + std::to_string(8000 + i) +
+               ", weight: 0.25, enabled: true, tags: [\"a\", \"b\", \"c\"], limits: { cpu: 2, memory: 512 } },\n";
+    }
+    return out + "};\n";
+}
+
+// A component returning one JSX tree of `rows` rows of widgets
+std::string jsxTree(int rows) {
+    std::string out = "function App() {\n    return (\n        <Column width=\"100%\" height=\"100%\">\n";
+    for (int i = 0; i < rows; i++) {
+        std::string n = std::to_string(i);
+        out += "            <Row height=\"40px\" alignItems=\"center\">\n"
+               "                <Text fontSize=\"14px\" color=\"#2c3e50\">Item " + n + "</Text>\n"
+               "                <View width=\"10px\" />\n"
+               "                <Button width=\"80px\" onClick={() => select(" + n + ")}>Open</Button>\n"
+               "            </Row>\n";
+    }
+    return out + "        </Column>\n    );\n}\n";
+}
+
+// `components` components of a view module, each with a handler and a small JSX tree
+std::string viewModule(int components) {
+    std::string out;
+    for (int i = 0; i < components; i++) {
+        std::string n = std::to_string(i);
+        out += "function Card" + n + "(props) {\n"
+               "    const title = props.title + \" #" + n + "\";\n"
+               "    var count = 0;\n"
+               "    const onClick = () => { count = count + 1; println(\"clicked " + n + " \" + count); };\n"
+               "    if (props.compact) {\n"
+               "        return <Row padding={4}><Text value={title} /></Row>;\n"
+               "    }\n"
+               "    return <Column padding={8} gap={4}>\n"
+               "        <Text value={title} size={18} />\n"
+               "        <Button label=\"Increment\" onClick={onClick} />\n"
+               "    </Column>;\n"
+               "}\n";
+    }
+    return out;
+}
+
+void parseGenerated(const std::string& name, const std::string& source) {
+    std::vector<Token> tokens = Lexer(source).tokenize();
+    bench(name, "token", tokens.size(), [&] {
+        Parser parser(tokens);
+        sink = parser.parse().size();
+    });
+}
+
+void lexerAndParser() {
+    std::string source = sampleProgram(200);
+    size_t tokenCount = Lexer(source).tokenize().size();
+    bench("lexer", "token", tokenCount, [&] {
+        Lexer lexer(source);
+        sink = lexer.tokenize().size();
+    });
+    std::vector<Token> tokens = Lexer(source).tokenize();
+    bench("parser", "token", tokenCount, [&] {
+        Parser parser(tokens);
+        sink = parser.parse().size();
+    });
+
+    // A generated file of about 15 MB: throughput once the source no longer fits in cache
+    std::string large = sampleProgram(20000);
+    size_t largeCount = Lexer(large).tokenize().size();
+    bench("lexer/large file", "token", largeCount, [&] {
+        Lexer lexer(large);
+        sink = lexer.tokenize().size();
+    });
+
+    std::string config = configTable(5000);
+    parseGenerated("parser/config table", config);
+    std::string jsx = jsxTree(2000);
+    parseGenerated("parser/jsx tree", jsx);
+
+    // The same module as a run reads it: function bodies are only brace-matched
+    std::string view = viewModule(2000);
+    parseGenerated("parser/view module", view);
+    auto viewSource = std::make_shared<const std::string>(view);
+    std::vector<Token> viewTokens = Lexer(view).tokenize();
+    bench("parser/view module (lazy)", "token", viewTokens.size(), [&] {
+        Parser parser(viewTokens, viewSource);
+        sink = parser.parse().size();
+    });
+}
+
+// Whole-script runs, normalized per loop iteration (or call)
+void evaluate(const std::string& name, const std::string& per, size_t items, const std::string& source, bool bytecode) {
+    std::vector<Token> tokens = Lexer(source).tokenize();
+    auto statements = Parser(tokens).parse();
+    bench(name + (bytecode ? " (vm)" : " (ast)"), per, items, [&] {
+        Interpreter interpreter;
+        interpreter.useBytecode = bytecode;
+        interpreter.interpret(statements);
+        sink = interpreter.getGlobal("sum").isInt();
+    });
+}
+
+void interpreterLoops() {
+    const std::string counting =
+        "var sum = 0; var i = 0;\n"
+        "while (i < 100000) { sum = sum + i * 3 - i / 2; i = i + 1; }\n";
+    const std::string calls =
+        "function add(a, b) { return a + b; }\n"
+        "var sum = 0; var i = 0;\n"
+        "while (i < 50000) { sum = add(sum, i); i = i + 1; }\n";
+    const std::string members =
+        "var point = { x: 1, y: 2 }; var sum = 0; var i = 0;\n"
+        "while (i < 50000) { point.x = point.x + point.y; sum = sum + point.x; i = i + 1; }\n";
+    const std::string strings =
+        "var sum = 0; var s = \"\"; var i = 0;\n"
+        "while (i < 20000) { s = s + \"ab\"; i = i + 1; }\n"
+        "sum = s.length;\n";
+    for (bool bytecode : {true, false}) {
+        evaluate("eval/loop", "iteration", 100000, counting, bytecode);
+        evaluate("eval/call", "call", 50000, calls, bytecode);
+        evaluate("eval/member", "iteration", 50000, members, bytecode);
+        evaluate("eval/concat", "iteration", 20000, strings, bytecode);
+    }
+}
+
+void valueCopies() {
+    std::vector<Value> values;
+    for (int i = 0; i < 100000; i++) {
+        if (i % 4 == 0) values.push_back(Value::number(i));
+        else if (i % 4 == 1) values.push_back(Value::real(i * 0.5));
+        else if (i % 4 == 2) values.push_back(Value("item" + std::to_string(i), 0, false));
+        else values.push_back(Value(std::vector<Value>{Value::number(i)}));
+    }
+    bench("value/copy", "value", values.size(), [&] {
+        std::vector<Value> copy = values;
+        sink = copy.size();
+    });
+}
+
+void json() {
+    std::string document = "[";
+    for (int i = 0; i < 2000; i++) {
+        if (i) document += ",";
+        document += "{\"id\": " + std::to_string(i) + ", \"name\": \"user " + std::to_string(i) +
+                    "\", \"score\": " + std::to_string(i * 1.25) + ", \"tags\": [\"a\", \"b\\n\"], \"active\": true}";
+    }
+    document += "]";
+    bench("json/parse", "byte", document.size(), [&] {
+        JSONLib::JsonParser parser(document);
+        sink = parser.parse().listVal()->size();
+    });
+}
+
+void http() {
+    std::string body = "{\"title\": \"hello\", \"done\": false}";
+    std::string request =
+        "POST /api/todos/42?verbose=1 HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+        "Accept: application/json\r\n"
+        "Accept-Encoding: gzip, deflate\r\n"
+        "Connection: keep-alive\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "\r\n" + body;
+    bench("http/parse", "request", 1, [&] {
+        sink = WebServer::HTTPParser::parse(request).headers.size();
+    });
+    bench("http/match_route", "match", 1, [&] {
+        std::map<std::string, std::string> params;
+        sink = WebServer::HTTPParser::match_route("/users/:id/posts/:post", "/users/42/posts/7", params);
+    });
+}
+
+void sqlite() {
+    Database::SQLiteDriver db;
+    if (!db.connect("sqlite://:memory:")) {
+        std::cerr << "  sqlite: " << db.getLastError() << std::endl;
+        return;
+    }
+    db.execute("CREATE TABLE users (id INTEGER PRIMARY KEY, name TEXT, score REAL, bio TEXT)", {});
+    db.execute("BEGIN", {});
+    for (int i = 0; i < 1000; i++) {
+        db.execute("INSERT INTO users (name, score, bio) VALUES (?, ?, ?)",
+                   {Value("user" + std::to_string(i), 0, false), Value::real(i * 0.75), Value(std::string(64, 'x'), 0, false)});
+    }
+    db.execute("COMMIT", {});
+    bench("sqlite/query", "row", 1000, [&] {
+        sink = db.query("SELECT id, name, score, bio FROM users", {}).size();
+    });
+    db.close();
+}
+
+// Script macrobenchmarks: every "name: N ms" line the script prints becomes a result
+struct ScriptResult {
+    std::string script;
+    std::string name;
+    double ms;
+};
+
+const char* const ScriptFlags = "--no-cache";
+
+std::vector<ScriptResult> runScripts(const std::string& anis, const std::vector<std::string>& scripts) {
+    std::vector<ScriptResult> out;
+    std::regex timing("^(.+): ([0-9.]+) ms");
+    for (auto& script : scripts) {
+        if (!filter.empty() && script.find(filter) == std::string::npos) continue;
+        std::string command = "\"" + anis + "\" " + ScriptFlags + " \"" + script + "\"";
+        double start = nowNs();
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe) continue;
+        std::string output;
+        char buffer[4096];
+        while (size_t n = fread(buffer, 1, sizeof(buffer), pipe)) output.append(buffer, n);
+        int status = pclose(pipe);
+        double totalMs = (nowNs() - start) / 1e6;
+
+        std::istringstream lines(output);
+        std::string line;
+        std::smatch match;
+        while (std::getline(lines, line)) {
+            if (std::regex_search(line, match, timing)) out.push_back({script, match[1].str(), std::stod(match[2].str())});
+        }
+        out.push_back({script, status == 0 ? "(process)" : "(process, failed)", totalMs});
+        std::cerr << "  " << script << ": " << totalMs << " ms" << std::endl;
+    }
+    return out;
+}
+
+std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) continue;
+        out += c;
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string anis;
+    std::vector<std::string> scripts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--anis=", 0) == 0) anis = arg.substr(7);
+        else if (arg.rfind("--filter=", 0) == 0) filter = arg.substr(9);
+        else scripts.push_back(arg);
+    }
+
+    std::cerr << "Microbenchmarks" << std::endl;
+    lexerAndParser();
+    interpreterLoops();
+    valueCopies();
+    json();
+    http();
+    sqlite();
+
+    std::vector<ScriptResult> scriptResults;
+    if (!anis.empty() && !scripts.empty()) {
+        std::cerr << "Scripts" << std::endl;
+        scriptResults = runScripts(anis, scripts);
+    }
+
+    char number[64];
+    std::cout << "{\n  \"micro\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        std::snprintf(number, sizeof(number), "%.2f", results[i].nsPerItem);
+        std::cout << "    {\"name\": " << quoted(results[i].name) << ", \"per\": " << quoted(results[i].per) << ", \"ns\": " << number;
+        std::snprintf(number, sizeof(number), "%.0f", 1e9 / results[i].nsPerItem);
+        std::cout << ", \"per_second\": " << number << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ],\n  \"script_flags\": " << quoted(ScriptFlags) << ",\n  \"scripts\": [\n";
+    for (size_t i = 0; i < scriptResults.size(); i++) {
+        std::snprintf(number, sizeof(number), "%.1f", scriptResults[i].ms);
+        std::cout << "    {\"script\": " << quoted(scriptResults[i].script) << ", \"name\": " << quoted(scriptResults[i].name)
+                  << ", \"ms\": " << number << "}" << (i + 1 < scriptResults.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}" << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Value layout benchmark: memory and copy cost of a 1M-element list,
+// compact tagged Value vs. the previous all-fields-inline layout.
+//
+//   make bench-value
+//
+#include "core/lang/interpreter.h"
+#include <chrono>
+#include <iostream>
+
+// Replica of the Value struct before the tagged layout, kept here for comparison only
+struct LegacyValue {
+    std::string strVal;
+    int intVal;
+    bool isInt;
+    bool isClosure = false;
+    std::shared_ptr<Stmt> closureBody;
+    std::shared_ptr<Environment> closureEnv;
+    std::vector<std::string> closureParams;
+    std::shared_ptr<std::vector<LegacyValue>> listVal;
+    bool isList = false;
+    std::shared_ptr<std::map<std::string, LegacyValue>> mapVal;
+    bool isMap = false;
+    std::function<LegacyValue(std::vector<LegacyValue>)> nativeFunc;
+    bool isNative = false;
+    bool isGetter = false;
+    bool isSetter = false;
+    std::shared_ptr<Class> classVal;
+    bool isClass = false;
+    std::shared_ptr<Instance> instanceVal;
+    bool isInstance = false;
+    std::string nativeId;
+
+    LegacyValue(std::string s, int i, bool isI) : strVal(s), intVal(i), isInt(isI) {}
+};
+
+static const size_t N = 1000000;
+
+template<typename F>
+static double timeMs(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename V, typename Make>
+static void run(const char* name, Make make) {
+    std::vector<V> list;
+    double buildMs = timeMs([&] {
+        list.reserve(N);
+        for (size_t i = 0; i < N; i++) list.push_back(make((int)i));
+    });
+
+    long long sum = 0;
+    double copyMs = timeMs([&] {
+        std::vector<V> copy = list;
+        sum += copy.size();
+    });
+
+    std::cout << name << ": sizeof=" << sizeof(V) << " B"
+              << ", elements=" << (sizeof(V) * N) / (1024 * 1024) << " MiB"
+              << ", build=" << buildMs << " ms"
+              << ", copy=" << copyMs << " ms" << std::endl;
+    if (sum != (long long)N) std::cerr << "unexpected copy size" << std::endl;
+}
+
+int main() {
+    std::cout << "1M-element list of numbers" << std::endl;
+    run<LegacyValue>("  legacy ", [](int i) { return LegacyValue("", i, true); });
+    run<Value>("  tagged ", [](int i) { return Value::number(i); });
+
+    std::cout << "1M-element list of strings" << std::endl;
+    run<LegacyValue>("  legacy ", [](int i) { return LegacyValue("item" + std::to_string(i), 0, false); });
+    run<Value>("  tagged ", [](int i) { return Value("item" + std::to_string(i), 0, false); });
+    return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef ANIS_AST_ARENA_H
+#define ANIS_AST_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bump allocator behind the AST nodes of one module, so parsing a module does not call malloc
+// once per node and the nodes of a function sit next to each other. Nodes are still
+// shared_ptrs (allocate_shared with ArenaAllocator, which puts the control block in the arena
+// too), and each counts as a reference to its arena: the blocks are freed when the parser or
+// cache reader that filled it and the last node still in use are all gone. Nodes never move.
+// One thread at a time allocates from it: the parser, then the interpreter thread for function
+// bodies parsed on first call (LazyBody). Nodes may be released on any thread.
+class AstArena {
+    static const size_t BlockBytes = 32 * 1024;
+
+    std::atomic<size_t> references{1}; // The creator's
+    std::vector<char*> blocks;
+    char* next = nullptr;
+    size_t left = 0;
+
+    AstArena() = default;
+    ~AstArena() {
+        for (char* block : blocks) ::operator delete(block);
+    }
+
+public:
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    static AstArena* create() { return new AstArena(); }
+
+    void retain() { references.fetch_add(1, std::memory_order_relaxed); }
+    void release() {
+        if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    void* allocate(size_t bytes, size_t align) {
+        size_t padding = (align - reinterpret_cast<uintptr_t>(next) % align) % align;
+        if (left < bytes + padding) {
+            // Oversized requests get a block of their own; the tail of the old one is dropped
+            size_t size = bytes + align > BlockBytes ? bytes + align : BlockBytes;
+            next = static_cast<char*>(::operator new(size));
+            left = size;
+            blocks.push_back(next);
+            padding = (align - reinterpret_cast<uintptr_t>(next) % align) % align;
+        }
+        void* p = next + padding;
+        next += padding + bytes;
+        left -= padding + bytes;
+        return p;
+    }
+};
+
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+    AstArena* arena;
+
+    explicit ArenaAllocator(AstArena* a) : arena(a) {}
+    template <class U> ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        arena->retain();
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) { arena->release(); }
+
+    template <class U> bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <class U> bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <class T, class... Args>
+std::shared_ptr<T> makeNode(AstArena* arena, Args&&... args) {
+    return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#include "atom.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    // Function-local tables so atoms can be created during static initialization
+    std::unordered_map<std::string, Atom>& atomIds() {
+        static std::unordered_map<std::string, Atom> ids;
+        return ids;
+    }
+    
+    std::vector<const std::string*>& atomNames() {
+        static std::vector<const std::string*> names; // Keys of atomIds(); node keys never move
+        return names;
+    }
+    
+    bool concurrent = false; // Only changed while no other thread runs
+    std::mutex tableMutex;
+    
+    std::unique_lock<std::mutex> lockTable() {
+        return concurrent ? std::unique_lock<std::mutex>(tableMutex) : std::unique_lock<std::mutex>();
+    }
+}
+
+void setAtomsConcurrent(bool value) {
+    concurrent = value;
+}
+
+Atom intern(const std::string& name) {
+    auto lock = lockTable();
+    auto& ids = atomIds();
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+    
+    auto& names = atomNames();
+    Atom atom = (Atom)names.size();
+    auto inserted = ids.emplace(name, atom).first;
+    names.push_back(&inserted->first);
+    return atom;
+}
+
+Atom lookupAtom(const std::string& name) {
+    auto lock = lockTable();
+    auto& ids = atomIds();
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : NoAtom;
+}
+
+const std::string& atomName(Atom atom) {
+    auto lock = lockTable();
+    return *atomNames()[atom];
+}
@@ -0,0 +1,21 @@
+#ifndef ANIS_ATOM_H
+#define ANIS_ATOM_H
+
+#include <string>
+#include <cstdint>
+
+// Interned name. Identifiers, property keys and class member names are mapped to a small
+// integer once (by the parser, resolver or at class creation), so scopes and member tables
+// compare ids instead of strings. Atoms are never freed; the table only grows with distinct names.
+using Atom = uint32_t;
+const Atom NoAtom = UINT32_MAX;
+
+Atom intern(const std::string& name);
+Atom lookupAtom(const std::string& name); // NoAtom if the name was never interned
+const std::string& atomName(Atom atom);
+
+// While modules are parsed on several threads (ModuleRegistry::prefetch) the table is locked;
+// the rest of the time only the interpreter thread uses it and no lock is taken
+void setAtomsConcurrent(bool concurrent);
+
+#endif
@@ -0,0 +1,73 @@
+#include "builtins.h"
+#include "interpreter.h"
+
+namespace {
+
+struct BuiltinEntry {
+    Atom name;
+    BuiltinMethod method;
+};
+
+Value listPush(Interpreter&, const Value& self, NativeArgs args) {
+    for (auto& a : args) self.listVal()->push_back(a);
+    return Value::number((int)self.listVal()->size());
+}
+
+Value listPop(Interpreter&, const Value& self, NativeArgs) {
+    auto* list = self.listVal();
+    if (list->empty()) return {"undefined", 0, false};
+    Value v = list->back();
+    list->pop_back();
+    return v;
+}
+
+Value listMap(Interpreter& interp, const Value& self, NativeArgs args) {
+    if (args.empty() || !args[0].isClosure()) return Value(std::vector<Value>{});
+    // The callback may push to or pop from the list: index it afresh on every step,
+    // over the items it had when the call began
+    auto* list = self.listVal();
+    size_t count = list->size();
+    std::vector<Value> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count && i < list->size(); i++) {
+        Value item = (*list)[i];
+        result.push_back(interp.callClosure(args[0], {item}));
+    }
+    return Value(result);
+}
+
+Value listFilter(Interpreter& interp, const Value& self, NativeArgs args) {
+    if (args.empty() || !args[0].isClosure()) return Value(std::vector<Value>{});
+    auto* list = self.listVal(); // Indexed afresh on every step, as in listMap
+    size_t count = list->size();
+    std::vector<Value> result;
+    for (size_t i = 0; i < count && i < list->size(); i++) {
+        Value item = (*list)[i];
+        Value ret = interp.callClosure(args[0], {item});
+        bool keep = (ret.isNumber() && ret.isTruthy()) || (!ret.isNumber() && !ret.strVal().empty());
+        if (keep) result.push_back(item);
+    }
+    return Value(result);
+}
+
+const std::vector<BuiltinEntry>& listMethods() {
+    static const std::vector<BuiltinEntry> table = {
+        {intern("push"), listPush},
+        {intern("pop"), listPop},
+        {intern("map"), listMap},
+        {intern("filter"), listFilter},
+    };
+    return table;
+}
+
+} // namespace
+
+BuiltinMethod findBuiltinMethod(const Value& receiver, Atom name) {
+    // Strings and maps have no methods: string operations are free natives (lib/string)
+    // and a map's members are its keys
+    if (!receiver.isList()) return nullptr;
+    for (auto& entry : listMethods()) {
+        if (entry.name == name) return entry.method;
+    }
+    return nullptr;
+}
@@ -0,0 +1,17 @@
+#ifndef ANIS_BUILTINS_H
+#define ANIS_BUILTINS_H
+
+#include "value.h"
+#include "atom.h"
+
+class Interpreter;
+
+// Methods of built-in receivers, e.g. `list.push(x)`. A call `recv.name(args)` looks the
+// method up by receiver type and atom and calls it directly, so no bound closure is made;
+// only reading `recv.name` as a value (getMember) wraps it in a native function.
+using BuiltinMethod = Value (*)(Interpreter& interp, const Value& self, NativeArgs args);
+
+// nullptr if `receiver` has no built-in method called `name`
+BuiltinMethod findBuiltinMethod(const Value& receiver, Atom name);
+
+#endif
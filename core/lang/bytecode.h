@@ -0,0 +1,173 @@
+#ifndef ANIS_BYTECODE_H
+#define ANIS_BYTECODE_H
+
+#include "interpreter.h"
+#include <vector>
+#include <string>
+#include <memory>
+
+// Stack machine instruction set.
+// Operands: `a` indexes into one of the chunk tables (or is a count / jump target), `b` is a second operand.
+enum OpCode : uint8_t {
+    OP_CONST,           // push constants[a]
+    OP_GET_VAR,         // push names[a]
+    OP_SET_VAR,         // assign names[a] = top (value stays on the stack)
+    OP_DEFINE_VAR,      // define names[a] = pop in the current scope
+    OP_ADD_ASSIGN,      // names[a] += pop (numbers only), push result
+    OP_GET_LOCAL,       // push slot a of the frame b scopes up (resolved by resolver.cpp)
+    OP_SET_LOCAL,       // slot a, b scopes up = top (value stays on the stack)
+    OP_DEFINE_LOCAL,    // slot a of the current frame = pop
+    OP_ADD_ASSIGN_LOCAL, // slot a, b scopes up += pop (numbers only), push result
+    OP_GET_GLOBAL,      // push names[a] from the globals, skipping every frame
+    OP_SET_GLOBAL,      // assign names[a] = top in the globals (value stays on the stack)
+    OP_ADD_ASSIGN_GLOBAL, // names[a] in the globals += pop (numbers only), push result
+    OP_POP,
+    
+    // Operators (pop r, pop l, push result)
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV,
+    OP_EQ, OP_NE, OP_LT, OP_GT, OP_LE, OP_GE,
+    OP_NOT, OP_NEG,     // unary: pop v, push result
+    
+    // Control flow (a = target instruction)
+    OP_JUMP,
+    OP_JUMP_IF_FALSE,   // pop condition
+    OP_AND,             // && : jump keeping top if falsy, else pop
+    OP_OR,              // || : jump keeping top if truthy, else pop
+    
+    // Objects
+    OP_GET_MEMBER,      // pop obj, push obj.key for the MemberExpr exprs[a] (uses its inline cache)
+    OP_GET_INDEX,       // pop key, pop obj, push obj[key]
+    OP_SET_MEMBER,      // pop obj, pop val, obj.key = val for the MemberExpr exprs[a], push val
+    OP_SET_INDEX,       // pop key, pop obj, pop val, obj[key] = val, push val
+    OP_ARRAY,           // pop a values, push list
+    OP_OBJECT,          // pop b values, keys are names[a .. a+b), push map
+    OP_CLOSURE,         // push closure for FunctionExpr exprs[a]
+    
+    // Calls (a = argc, b = names index of callee for error messages or -1)
+    OP_CALL,
+    OP_GET_METHOD,      // pop obj for the callee MemberExpr exprs[a]; push obj, true if it has a built-in
+                        // method of that name, else push obj.key, undefined
+    OP_INVOKE,          // a = argc, b = exprs index of the MemberExpr: call what OP_GET_METHOD pushed
+    OP_TAIL_CALL,       // OP_CALL for `return f(...)`: a closure callee is left pending for callClosure
+                        // and the chunk ends; anything else is called as usual (an OP_RETURN follows)
+    OP_TAIL_INVOKE,     // likewise for OP_INVOKE
+    OP_RETURN,          // pop return value, leave chunk
+    OP_BREAK,           // leave the chunk with a Break completion for a loop outside it
+                        // (b = names index of the label or -1); loops inside it are plain jumps
+    OP_CONTINUE,        // likewise, Continue
+    
+    // Scopes
+    OP_PUSH_SCOPE,      // enter a frame for the BlockStmt stmts[a]
+    OP_POP_SCOPE,
+    
+    // Statement results (REPL echo)
+    OP_EXPR_RESULT,     // pop into lastExpressionValue
+    
+    // Tree-walker fallback for nodes without a dedicated instruction
+    OP_EVAL,            // push evaluate(exprs[a])
+    OP_EXEC             // execute(stmts[a]); inside a loop, b = 1 + index into execSites
+};
+
+// Int (op) Int without leaving int64. False when the result needs binaryOp: on overflow
+// (which promotes to double) and for division by zero.
+inline bool intBinaryOp(OpCode op, int64_t a, int64_t b, Value& out) {
+    int64_t res;
+    switch (op) {
+        case OP_ADD: if (__builtin_add_overflow(a, b, &res)) return false; break;
+        case OP_SUB: if (__builtin_sub_overflow(a, b, &res)) return false; break;
+        case OP_MUL: if (__builtin_mul_overflow(a, b, &res)) return false; break;
+        case OP_DIV: if (b == 0 || (b == -1 && a == INT64_MIN)) return false; res = a / b; break;
+        case OP_EQ: res = a == b; break;
+        case OP_NE: res = a != b; break;
+        case OP_LT: res = a < b; break;
+        case OP_GT: res = a > b; break;
+        case OP_LE: res = a <= b; break;
+        case OP_GE: res = a >= b; break;
+        default: return false;
+    }
+    out = Value::number(res);
+    return true;
+}
+
+// Instruction for an arithmetic or comparison operator
+inline OpCode opCodeFor(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::Add: return OP_ADD;
+        case BinaryOp::Sub: return OP_SUB;
+        case BinaryOp::Mul: return OP_MUL;
+        case BinaryOp::Div: return OP_DIV;
+        case BinaryOp::Eq: return OP_EQ;
+        case BinaryOp::Ne: return OP_NE;
+        case BinaryOp::Lt: return OP_LT;
+        case BinaryOp::Gt: return OP_GT;
+        case BinaryOp::Le: return OP_LE;
+        case BinaryOp::Ge: return OP_GE;
+        default: return OP_ADD; // Assignment and logical operators have their own instructions
+    }
+}
+
+struct Instruction {
+    OpCode op;
+    int32_t a = 0;
+    int32_t b = 0;
+    int line = 0;
+};
+
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<Value> constants;
+    std::vector<Atom> names;
+    std::vector<Expr*> exprs;   // Non-owning: the AST outlives its compiled chunks
+    std::vector<Stmt*> stmts;
+    
+    // Loops compiled into this chunk. break/continue in compiled code are jumps; these let a
+    // statement run on the tree-walker (OP_EXEC) hand its break/continue back to them.
+    struct Loop {
+        Atom label;
+        int enclosing;      // Index of the enclosing loop in this chunk, or -1
+        int depth;          // Scopes open at the loop
+        int continueTarget;
+        int breakTarget;
+    };
+    struct ExecSite {
+        int loop;           // Innermost loop around the OP_EXEC
+        int depth;          // Scopes open at the OP_EXEC
+    };
+    std::vector<Loop> loops;
+    std::vector<ExecSite> execSites;
+    
+    // Innermost loop from `loop` outwards that a break/continue with `label` targets, or -1
+    int findLoop(int loop, Atom label) const {
+        while (loop >= 0 && label != NoAtom && loops[loop].label != label) loop = loops[loop].enclosing;
+        return loop;
+    }
+};
+
+// Compiles parsed statements into a flat Chunk.
+// Blocks are inlined with PUSH_SCOPE/POP_SCOPE; function bodies are compiled lazily on first call.
+class Compiler {
+public:
+    std::shared_ptr<Chunk> compile(const std::vector<std::shared_ptr<Stmt>>& statements);
+    
+private:
+    std::shared_ptr<Chunk> chunk;
+    int scopeDepth = 0;  // PUSH_SCOPEs open at the current instruction
+    int currentLoop = -1; // Index into chunk->loops
+    std::vector<std::vector<int>> breakJumps; // Per loop, jumps patched to its end
+    
+    void statement(Stmt* stmt);
+    void jump(JumpStmt* stmt);
+    void expression(Expr* expr);
+    void fallback(Expr* expr);
+    void fallback(Stmt* stmt);
+    
+    int emit(OpCode op, int a = 0, int b = 0, int line = 0);
+    void patch(int jump);
+    int constant(const Value& v);
+    int name(Atom n);
+};
+
+// Compiled form of a block, cached on the node after the first run
+std::shared_ptr<Chunk> compileBlock(BlockStmt* block);
+
+#endif
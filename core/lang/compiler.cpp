@@ -0,0 +1,322 @@
+#include "bytecode.h"
+#include <string>
+
+std::shared_ptr<Chunk> compileBlock(BlockStmt* block) {
+    if (!block->compiled) {
+        block->compiled = Compiler().compile(block->statements);
+    }
+    return block->compiled;
+}
+
+std::shared_ptr<Chunk> Compiler::compile(const std::vector<std::shared_ptr<Stmt>>& statements) {
+    chunk = std::make_shared<Chunk>();
+    for (auto& s : statements) {
+        if (s) statement(s.get());
+    }
+    return chunk;
+}
+
+int Compiler::emit(OpCode op, int a, int b, int line) {
+    Instruction in;
+    in.op = op;
+    in.a = a;
+    in.b = b;
+    in.line = line;
+    chunk->code.push_back(in);
+    return (int)chunk->code.size() - 1;
+}
+
+void Compiler::patch(int jump) {
+    chunk->code[jump].a = (int)chunk->code.size();
+}
+
+int Compiler::constant(const Value& v) {
+    chunk->constants.push_back(v);
+    return (int)chunk->constants.size() - 1;
+}
+
+int Compiler::name(Atom n) {
+    for (size_t i = 0; i < chunk->names.size(); i++) {
+        if (chunk->names[i] == n) return (int)i;
+    }
+    chunk->names.push_back(n);
+    return (int)chunk->names.size() - 1;
+}
+
+void Compiler::fallback(Expr* expr) {
+    chunk->exprs.push_back(expr);
+    emit(OP_EVAL, (int)chunk->exprs.size() - 1, 0, expr->line);
+}
+
+void Compiler::fallback(Stmt* stmt) {
+    chunk->stmts.push_back(stmt);
+    int site = 0;
+    if (currentLoop >= 0) {
+        chunk->execSites.push_back({currentLoop, scopeDepth});
+        site = (int)chunk->execSites.size();
+    }
+    emit(OP_EXEC, (int)chunk->stmts.size() - 1, site, stmt->line);
+}
+
+// A jump to a loop in this chunk closes the scopes opened since the loop; one whose loop
+// encloses the chunk ends it with a completion instead
+void Compiler::jump(JumpStmt* stmt) {
+    bool isBreak = stmt->kind == StmtKind::Break;
+    int loop = chunk->findLoop(currentLoop, stmt->label);
+    if (loop < 0) {
+        emit(isBreak ? OP_BREAK : OP_CONTINUE, 0, stmt->label == NoAtom ? -1 : name(stmt->label), stmt->line);
+        return;
+    }
+    for (int depth = scopeDepth; depth > chunk->loops[loop].depth; depth--) emit(OP_POP_SCOPE);
+    if (isBreak) breakJumps[loop].push_back(emit(OP_JUMP));
+    else emit(OP_JUMP, chunk->loops[loop].continueTarget);
+}
+
+void Compiler::statement(Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::Expr: {
+            auto* exprStmt = static_cast<ExprStmt*>(stmt);
+            expression(exprStmt->expr.get());
+            emit(OP_EXPR_RESULT);
+            break;
+        }
+        case StmtKind::VarDecl: {
+            auto* varDecl = static_cast<VarDeclStmt*>(stmt);
+            if (varDecl->initializer) expression(varDecl->initializer.get());
+            else emit(OP_CONST, constant(Value::number(0)));
+            if (varDecl->slot >= 0) emit(OP_DEFINE_LOCAL, varDecl->slot);
+            else emit(OP_DEFINE_VAR, name(varDecl->atom));
+            break;
+        }
+        case StmtKind::Return: {
+            auto* ret = static_cast<ReturnStmt*>(stmt);
+            if (ret->value) expression(ret->value.get());
+            else emit(OP_CONST, constant(Value::number(0)));
+            if (ret->tailCall) {
+                Instruction& call = chunk->code.back();
+                if (call.op == OP_CALL) call.op = OP_TAIL_CALL;
+                else if (call.op == OP_INVOKE) call.op = OP_TAIL_INVOKE;
+            }
+            emit(OP_RETURN);
+            break;
+        }
+        case StmtKind::Block: {
+            auto* block = static_cast<BlockStmt*>(stmt);
+            chunk->stmts.push_back(block);
+            emit(OP_PUSH_SCOPE, (int)chunk->stmts.size() - 1);
+            scopeDepth++;
+            for (auto& s : block->statements) {
+                if (s) statement(s.get());
+            }
+            scopeDepth--;
+            emit(OP_POP_SCOPE);
+            break;
+        }
+        case StmtKind::If: {
+            auto* ifStmt = static_cast<IfStmt*>(stmt);
+            expression(ifStmt->condition.get());
+            int elseJump = emit(OP_JUMP_IF_FALSE);
+            statement(ifStmt->thenBranch.get());
+            if (ifStmt->elseBranch) {
+                int endJump = emit(OP_JUMP);
+                patch(elseJump);
+                statement(ifStmt->elseBranch.get());
+                patch(endJump);
+            } else {
+                patch(elseJump);
+            }
+            break;
+        }
+        case StmtKind::While: {
+            auto* whileStmt = static_cast<WhileStmt*>(stmt);
+            int loopStart = (int)chunk->code.size();
+            int loop = (int)chunk->loops.size();
+            chunk->loops.push_back({whileStmt->label, currentLoop, scopeDepth, loopStart, -1});
+            breakJumps.emplace_back();
+            currentLoop = loop;
+            expression(whileStmt->condition.get());
+            int exitJump = emit(OP_JUMP_IF_FALSE);
+            statement(whileStmt->body.get());
+            emit(OP_JUMP, loopStart);
+            patch(exitJump);
+            for (int j : breakJumps[loop]) patch(j);
+            chunk->loops[loop].breakTarget = (int)chunk->code.size();
+            currentLoop = chunk->loops[loop].enclosing;
+            break;
+        }
+        case StmtKind::Break:
+        case StmtKind::Continue:
+            jump(static_cast<JumpStmt*>(stmt));
+            break;
+        default:
+            // Declarations, imports, switch, try/catch, classes: run on the tree-walker
+            fallback(stmt);
+            break;
+    }
+}
+
+void Compiler::expression(Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::Literal: {
+            auto* lit = static_cast<LiteralExpr*>(expr);
+            if (lit->decoded) {
+                emit(OP_CONST, constant(lit->constant));
+                return;
+            }
+            if (lit->isString) {
+                emit(OP_CONST, constant(Value(lit->value, 0, false)));
+                return;
+            }
+            emit(OP_CONST, constant(Value::parseNumber(lit->value)));
+            return;
+        }
+        case ExprKind::Var: {
+            auto* var = static_cast<VarExpr*>(expr);
+            if (var->slot >= 0) emit(OP_GET_LOCAL, var->slot, var->depth, var->line);
+            else if (var->depth == VarExpr::Global) emit(OP_GET_GLOBAL, name(var->atom), 0, var->line);
+            else emit(OP_GET_VAR, name(var->atom), 0, var->line);
+            return;
+        }
+        case ExprKind::This:
+            emit(OP_GET_VAR, name(intern("this")), 0, expr->line);
+            return;
+        case ExprKind::Unary: {
+            auto* unary = static_cast<UnaryExpr*>(expr);
+            expression(unary->right.get());
+            emit(unary->op == UnaryOp::Not ? OP_NOT : OP_NEG);
+            return;
+        }
+        case ExprKind::Ternary: {
+            auto* ternary = static_cast<TernaryExpr*>(expr);
+            expression(ternary->condition.get());
+            int elseJump = emit(OP_JUMP_IF_FALSE);
+            expression(ternary->trueExpr.get());
+            int endJump = emit(OP_JUMP);
+            patch(elseJump);
+            expression(ternary->falseExpr.get());
+            patch(endJump);
+            return;
+        }
+        case ExprKind::Binary: {
+            auto* bin = static_cast<BinaryExpr*>(expr);
+            BinaryOp op = bin->op;
+            if (op == BinaryOp::Assign) {
+                if (bin->left->kind == ExprKind::Var) {
+                    auto* var = static_cast<VarExpr*>(bin->left.get());
+                    expression(bin->right.get());
+                    if (var->slot >= 0) emit(OP_SET_LOCAL, var->slot, var->depth, bin->line);
+                    else if (var->depth == VarExpr::Global) emit(OP_SET_GLOBAL, name(var->atom), 0, bin->line);
+                    else emit(OP_SET_VAR, name(var->atom), 0, bin->line);
+                    return;
+                }
+                if (bin->left->kind == ExprKind::Member) {
+                    auto* mem = static_cast<MemberExpr*>(bin->left.get());
+                    if (mem->computed) {
+                        expression(bin->right.get());
+                        expression(mem->object.get());
+                        expression(mem->property.get());
+                        emit(OP_SET_INDEX, 0, 0, bin->line);
+                        return;
+                    }
+                    expression(bin->right.get());
+                    expression(mem->object.get());
+                    chunk->exprs.push_back(mem);
+                    emit(OP_SET_MEMBER, (int)chunk->exprs.size() - 1, 0, bin->line);
+                    return;
+                }
+                fallback(expr);
+                return;
+            }
+            if (op == BinaryOp::AddAssign) {
+                if (bin->left->kind != ExprKind::Var) {
+                    fallback(expr);
+                    return;
+                }
+                auto* var = static_cast<VarExpr*>(bin->left.get());
+                expression(bin->right.get());
+                if (var->slot >= 0) emit(OP_ADD_ASSIGN_LOCAL, var->slot, var->depth, bin->line);
+                else if (var->depth == VarExpr::Global) emit(OP_ADD_ASSIGN_GLOBAL, name(var->atom), 0, bin->line);
+                else emit(OP_ADD_ASSIGN, name(var->atom), 0, bin->line);
+                return;
+            }
+            if (op == BinaryOp::And || op == BinaryOp::Or) {
+                expression(bin->left.get());
+                int jump = emit(op == BinaryOp::And ? OP_AND : OP_OR);
+                expression(bin->right.get());
+                patch(jump);
+                return;
+            }
+            
+            expression(bin->left.get());
+            expression(bin->right.get());
+            emit(opCodeFor(op), 0, 0, bin->line);
+            return;
+        }
+        case ExprKind::Call: {
+            auto* call = static_cast<CallExpr*>(expr);
+            if (call->callee->kind == ExprKind::Member && !static_cast<MemberExpr*>(call->callee.get())->computed) {
+                auto* mem = static_cast<MemberExpr*>(call->callee.get());
+                expression(mem->object.get());
+                chunk->exprs.push_back(mem);
+                int site = (int)chunk->exprs.size() - 1;
+                emit(OP_GET_METHOD, site, 0, mem->line);
+                for (auto& arg : call->args) expression(arg.get());
+                emit(OP_INVOKE, (int)call->args.size(), site, call->line);
+                return;
+            }
+            expression(call->callee.get());
+            for (auto& arg : call->args) expression(arg.get());
+            int calleeName = -1;
+            if (call->callee->kind == ExprKind::Var) calleeName = name(static_cast<VarExpr*>(call->callee.get())->atom);
+            emit(OP_CALL, (int)call->args.size(), calleeName, call->line);
+            return;
+        }
+        case ExprKind::Member: {
+            auto* mem = static_cast<MemberExpr*>(expr);
+            expression(mem->object.get());
+            if (mem->computed) {
+                expression(mem->property.get());
+                emit(OP_GET_INDEX, 0, 0, mem->line);
+            } else {
+                chunk->exprs.push_back(mem);
+                emit(OP_GET_MEMBER, (int)chunk->exprs.size() - 1, 0, mem->line);
+            }
+            return;
+        }
+        case ExprKind::Array: {
+            auto* arr = static_cast<ArrayExpr*>(expr);
+            for (auto& e : arr->elements) {
+                if (e->kind == ExprKind::Spread) {
+                    fallback(expr);
+                    return;
+                }
+            }
+            for (auto& e : arr->elements) expression(e.get());
+            emit(OP_ARRAY, (int)arr->elements.size(), 0, arr->line);
+            return;
+        }
+        case ExprKind::Object: {
+            auto* obj = static_cast<ObjectExpr*>(expr);
+            for (auto& prop : obj->properties) {
+                if (prop.spread) {
+                    fallback(expr);
+                    return;
+                }
+            }
+            // Keys are laid out contiguously in the name table
+            int firstKey = (int)chunk->names.size();
+            for (auto& prop : obj->properties) chunk->names.push_back(prop.key);
+            for (auto& prop : obj->properties) expression(prop.value.get());
+            emit(OP_OBJECT, firstKey, (int)obj->properties.size(), obj->line);
+            return;
+        }
+        case ExprKind::Function:
+            chunk->exprs.push_back(expr);
+            emit(OP_CLOSURE, (int)chunk->exprs.size() - 1, 0, expr->line);
+            return;
+        default:
+            // new, super, JSX: run on the tree-walker
+            fallback(expr);
+            return;
+    }
+}
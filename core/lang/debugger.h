@@ -2,9 +2,12 @@
 #define ANIS_DEBUGGER_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <unordered_map>
+#include <algorithm>
 
 // ANSI color codes
 #define COLOR_RESET   "\033[0m"
@@ -19,28 +22,91 @@
 class Debugger {
 public:
     static bool isReplMode;
-    static std::vector<std::string> callStack;
     
-    // Stack trace management
-    static void pushCall(const std::string& name, int line) {
-        callStack.push_back(name + " (line " + std::to_string(line) + ")");
+    // Set on the module prefetch threads (module_registry.cpp): parse errors are only counted
+    // there, and the import parses the module again on the interpreter thread to report them
+    static inline thread_local bool deferParseErrors = false;
+    static inline thread_local int deferredParseErrors = 0;
+
+    // Script call stack as fixed-size {function, call line} records. Pushing and popping is a
+    // store and an increment; names are looked up and text built only when a trace is printed.
+    // Frames past MaxCallRecords are counted but not recorded.
+    struct CallRecord {
+        const void* function; // Function body, named through nameFunction
+        int line;             // Line of the call
+    };
+    static constexpr int MaxCallRecords = 1024;
+    static CallRecord callRecords[MaxCallRecords];
+    static int callDepth;
+    
+    // Set while profiling (profiler.cpp): told of every call, tail calls included
+    static inline void (*callHook)(const void* function) = nullptr;
+    
+    static void pushCall(const void* function, int line) {
+        if (callDepth < MaxCallRecords) callRecords[callDepth] = {function, line};
+        ++callDepth;
+        if (callHook) callHook(function);
     }
     
     static void popCall() {
-        if (!callStack.empty()) callStack.pop_back();
+        if (callDepth > 0) --callDepth;
+    }
+    
+    // A tail call reuses the caller's record
+    static void replaceCall(const void* function, int line) {
+        if (callDepth > 0 && callDepth <= MaxCallRecords) callRecords[callDepth - 1] = {function, line};
+        if (callHook) callHook(function);
     }
     
     static void clearCallStack() {
-        callStack.clear();
+        callDepth = 0;
+    }
+    
+    // Registered once per declaration (by the resolver), not per call
+    struct FunctionInfo {
+        std::string name;
+        std::string file; // As the module was opened
+        int line;         // Of the declaration
+    };
+    static void nameFunction(const void* function, const std::string& name, const std::string& file, int line) {
+        functionNames()[function] = {name, file, line};
+    }
+    
+    static const FunctionInfo* functionInfo(const void* function) {
+        auto it = functionNames().find(function);
+        return it != functionNames().end() ? &it->second : nullptr;
+    }
+    
+    // Copies the stack when a script error is thrown, so an uncaught error can still show where
+    // it came from after unwinding; restoreThrownStack puts it back before reporting
+    static void captureThrownStack() {
+        thrownDepth = callDepth;
+        std::copy(callRecords, callRecords + std::min(callDepth, MaxCallRecords), thrownRecords);
+    }
+    
+    static void restoreThrownStack() {
+        callDepth = thrownDepth;
+        std::copy(thrownRecords, thrownRecords + std::min(thrownDepth, MaxCallRecords), callRecords);
     }
     
     static std::string getStackTrace() {
-        if (callStack.empty()) return "";
+        if (callDepth == 0) return "";
         
         std::string trace = "\n" + std::string(COLOR_GRAY) + "Call stack:" + std::string(COLOR_RESET) + "\n";
         int depth = 0;
-        for (auto it = callStack.rbegin(); it != callStack.rend(); ++it) {
-            trace += "  " + std::to_string(++depth) + ". at " + *it + "\n";
+        if (callDepth > MaxCallRecords) {
+            depth = callDepth - MaxCallRecords;
+            trace += "  ... " + std::to_string(depth) + " innermost calls not recorded\n";
+        }
+        // Innermost first; runs of the same record (plain recursion) print once
+        for (int i = std::min(callDepth, MaxCallRecords) - 1; i >= 0; ) {
+            int run = 1;
+            while (i - run >= 0 && callRecords[i - run].function == callRecords[i].function && callRecords[i - run].line == callRecords[i].line) run++;
+            trace += "  " + std::to_string(++depth) + ". at " + functionName(callRecords[i].function) + " (line " + std::to_string(callRecords[i].line) + ")";
+            if (run > 1) trace += " x" + std::to_string(run);
+            trace += "\n";
+            depth += run - 1;
+            i -= run;
         }
         return trace;
     }
@@ -85,7 +151,11 @@ public:
         std::cerr << COLOR_GREEN << "✓ " << message << COLOR_RESET << std::endl;
     }
     
-    static void parseError(const std::string& message, const std::string& token, int line = 0) {
+    static void parseError(const std::string& message, std::string_view token, int line = 0) {
+        if (deferParseErrors) {
+            deferredParseErrors++;
+            return;
+        }
         std::cerr << COLOR_RED << "❌ PARSE ERROR";
         if (line > 0) {
             std::cerr << " at line " << line;
@@ -205,6 +275,19 @@ public:
     }
     
 private:
+    static CallRecord thrownRecords[MaxCallRecords];
+    static int thrownDepth;
+    
+    static std::unordered_map<const void*, FunctionInfo>& functionNames() {
+        static std::unordered_map<const void*, FunctionInfo> names;
+        return names;
+    }
+    
+    static std::string functionName(const void* function) {
+        const FunctionInfo* info = functionInfo(function);
+        return info ? info->name : "<anonymous>";
+    }
+    
     // Show code context with 2 lines before and after
     static void showCodeContext(const std::string& source, int errorLine) {
         std::stringstream ss(source);
@@ -246,6 +329,9 @@ private:
 
 // Static member definitions
 inline bool Debugger::isReplMode = false;
-inline std::vector<std::string> Debugger::callStack;
+inline Debugger::CallRecord Debugger::callRecords[Debugger::MaxCallRecords];
+inline int Debugger::callDepth = 0;
+inline Debugger::CallRecord Debugger::thrownRecords[Debugger::MaxCallRecords];
+inline int Debugger::thrownDepth = 0;
 
 #endif
@@ -0,0 +1,77 @@
+#ifndef ANIS_FRAME_POOL_H
+#define ANIS_FRAME_POOL_H
+
+#include <cstddef>
+#include <new>
+
+// Free-list pool behind scope frames. Entering a block or a call allocates an Environment,
+// its slot array and, for binding layers, a small hash table; leaving the scope frees them.
+// Freed blocks go on a per-size free list and are handed out again, so steady-state
+// execution does not reach malloc. Frames captured by closures just stay allocated until
+// their last reference goes. Not thread-safe, like the interpreter.
+class FramePool {
+    static const size_t Granule = 16;        // Block sizes are multiples of this (and aligned to it)
+    static const size_t Classes = 16;        // Pooled sizes: 16 .. 256 bytes; larger go to operator new
+    static const size_t SlabBytes = 64 * 1024;
+    
+    struct FreeBlock { FreeBlock* next; };
+    FreeBlock* freeLists[Classes] = {};
+    char* slab = nullptr;
+    size_t slabLeft = 0;
+    size_t slabBytes = 0;
+    
+public:
+    size_t reservedBytes() const { return slabBytes; } // Held for pooled blocks, in use or free
+    
+    void* allocate(size_t bytes) {
+        size_t cls = bytes ? (bytes + Granule - 1) / Granule : 1;
+        if (cls > Classes) return ::operator new(bytes);
+        FreeBlock*& head = freeLists[cls - 1];
+        if (head) {
+            void* p = head;
+            head = head->next;
+            return p;
+        }
+        size_t size = cls * Granule;
+        if (slabLeft < size) {
+            // The tail of the old slab is dropped; slabs are never returned
+            slab = static_cast<char*>(::operator new(SlabBytes));
+            slabLeft = SlabBytes;
+            slabBytes += SlabBytes;
+        }
+        void* p = slab;
+        slab += size;
+        slabLeft -= size;
+        return p;
+    }
+    
+    void deallocate(void* p, size_t bytes) {
+        size_t cls = bytes ? (bytes + Granule - 1) / Granule : 1;
+        if (cls > Classes) {
+            ::operator delete(p);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = freeLists[cls - 1];
+        freeLists[cls - 1] = block;
+    }
+};
+
+inline FramePool framePool;
+
+// Standard allocator over framePool, for the frame itself (allocate_shared) and its containers
+template<typename T>
+struct FrameAllocator {
+    using value_type = T;
+    
+    FrameAllocator() = default;
+    template<typename U> FrameAllocator(const FrameAllocator<U>&) {}
+    
+    T* allocate(size_t n) { return static_cast<T*>(framePool.allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { framePool.deallocate(p, n * sizeof(T)); }
+    
+    template<typename U> bool operator==(const FrameAllocator<U>&) const { return true; }
+    template<typename U> bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+#endif
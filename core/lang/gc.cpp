@@ -0,0 +1,77 @@
+#include "gc.h"
+#include <vector>
+#include <chrono>
+
+GcObject::GcObject() {
+    gcNext = Gc::head;
+    if (gcNext) gcNext->gcPrev = this;
+    Gc::head = this;
+    Gc::allocated++;
+    Gc::statistics.objects++;
+}
+
+GcObject::~GcObject() {
+    if (gcPrev) gcPrev->gcNext = gcNext;
+    else Gc::head = gcNext;
+    if (gcNext) gcNext->gcPrev = gcPrev;
+    Gc::statistics.objects--;
+}
+
+size_t Gc::collect() {
+    auto start = std::chrono::steady_clock::now();
+    size_t before = statistics.objects;
+    
+    // References from outside the tracked graph are what remains after subtracting internal ones
+    for (GcObject* o = head; o; o = o->gcNext) o->gcRefs = o->gcRefCount();
+    for (GcObject* o = head; o; o = o->gcNext) {
+        o->gcTraverse([](GcObject* target, void*) { target->gcRefs--; }, nullptr);
+    }
+    
+    // Everything reachable from an externally referenced object is alive (marked -1)
+    std::vector<GcObject*> work;
+    for (GcObject* o = head; o; o = o->gcNext) {
+        if (o->gcRefs > 0) {
+            o->gcRefs = -1;
+            work.push_back(o);
+        }
+    }
+    size_t scanned = 0; // References held by survivors
+    while (!work.empty()) {
+        GcObject* o = work.back();
+        work.pop_back();
+        scanned += o->gcTraverse([](GcObject* target, void* ctx) {
+            if (target->gcRefs >= 0) {
+                target->gcRefs = -1;
+                static_cast<std::vector<GcObject*>*>(ctx)->push_back(target);
+            }
+        }, &work);
+    }
+    
+    // The rest is only referenced from garbage. Pin it, clear it to break the cycles, and let
+    // reference counting free it when the pins go.
+    std::vector<std::shared_ptr<void>> pins;
+    std::vector<GcObject*> garbage;
+    for (GcObject* o = head; o; o = o->gcNext) {
+        if (o->gcRefs == 0) {
+            garbage.push_back(o);
+            pins.push_back(o->gcPin());
+        }
+    }
+    for (GcObject* o : garbage) o->gcClear();
+    garbage.clear();
+    pins.clear();
+    
+    size_t freed = before - statistics.objects;
+    statistics.freed += freed;
+    // Wait for as many allocations as the survivors hold references, so collecting stays
+    // amortized O(1) per allocation however large the live heap is
+    allocated = 0;
+    threshold = scanned > MinThreshold ? scanned : MinThreshold;
+    
+    double pause = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    statistics.collections++;
+    statistics.lastPauseMs = pause;
+    statistics.totalPauseMs += pause;
+    if (pause > statistics.maxPauseMs) statistics.maxPauseMs = pause;
+    return freed;
+}
@@ -0,0 +1,64 @@
+#ifndef ANIS_GC_H
+#define ANIS_GC_H
+
+#include <cstddef>
+#include <memory>
+
+struct GcObject;
+using GcVisitor = void (*)(GcObject* target, void* ctx);
+
+// Anything that can be part of a reference cycle: environments, closures, lists, maps, classes
+// and instances. Reference counting frees everything else as soon as it becomes unreachable;
+// Gc::collect() finds the cycles, the way CPython's collector does. It subtracts the references
+// tracked objects hold on each other, treats whatever still has references left as reachable
+// from outside (C++ locals, the VM stack, the AST, the interpreter), and clears the rest.
+struct GcObject {
+    GcObject();
+    GcObject(const GcObject&) = delete;
+    GcObject& operator=(const GcObject&) = delete;
+    virtual ~GcObject();
+    
+    virtual long gcRefCount() const = 0;                        // Strong references held on this object
+    // Visit each tracked object referenced; returns how many references were examined (the cost)
+    virtual size_t gcTraverse(GcVisitor visit, void* ctx) = 0;
+    virtual void gcClear() = 0;                                 // Drop those references
+    virtual std::shared_ptr<void> gcPin() = 0;                  // Keep alive while its cycle is cleared
+    
+private:
+    friend class Gc;
+    GcObject* gcPrev = nullptr;
+    GcObject* gcNext = nullptr;
+    long gcRefs = 0; // Scratch count during a collection
+};
+
+struct GcStats {
+    size_t objects = 0;      // Tracked objects alive
+    size_t collections = 0;
+    size_t freed = 0;        // Objects freed by collections (not by reference counting)
+    double lastPauseMs = 0;
+    double maxPauseMs = 0;
+    double totalPauseMs = 0;
+};
+
+class Gc {
+public:
+    // Collect once enough tracked objects were allocated since the last collection.
+    // Only call where every live object is referenced from somewhere (between statements):
+    // an object under construction would look unreferenced.
+    static void maybeCollect() {
+        if (allocated >= threshold) collect();
+    }
+    static size_t collect(); // Returns the number of objects freed
+    static const GcStats& stats() { return statistics; }
+    
+private:
+    friend struct GcObject;
+    static const size_t MinThreshold = 10000;
+    
+    static inline GcObject* head = nullptr;
+    static inline size_t allocated = 0;
+    static inline size_t threshold = MinThreshold;
+    static inline GcStats statistics;
+};
+
+#endif
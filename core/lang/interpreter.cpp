@@ -1,24 +1,70 @@
 #include "interpreter.h"
+#include "bytecode.h"
+#include "resolver.h"
+#include "optimizer.h"
+#include "module_cache.h"
+#include "builtins.h"
 #include <iostream>
+#include <chrono>
 #include "debugger.h"
 #include "../../lib/http/http_lib.h"
 
+static char* nativeStackLimit = nullptr; // Lowest address calls may reach, or null if unknown
+
+// Leaves room below the limit for the deepest native work one script call can do between checks
+void Interpreter::setNativeStack(char* lowest, size_t size) {
+    const size_t reserve = 1024 * 1024;
+    nativeStackLimit = size > 2 * reserve ? lowest + reserve : nullptr;
+}
+
+void Interpreter::enterCall() {
+    char marker;
+    if (++callDepth > maxCallDepth || (nativeStackLimit && (uintptr_t)&marker < (uintptr_t)nativeStackLimit)) {
+        int depth = --callDepth;
+        throw RuntimeError(errorValue("RangeError", Value("Maximum call stack size exceeded (depth " + std::to_string(depth) + ")", 0, false)));
+    }
+}
+
+// Balances enterCall() and the Debugger call record however the call ends
+struct CallDepthGuard {
+    Interpreter& interp;
+    CallDepthGuard(Interpreter& i, const void* function) : interp(i) {
+        interp.enterCall();
+        Debugger::pushCall(function, interp.currentLine);
+    }
+    ~CallDepthGuard() {
+        Debugger::popCall();
+        interp.callDepth--;
+    }
+};
+
+// Names the interpreter binds itself
+static const Atom atomThis = intern("this");
+static const Atom atomSuper = intern("super");
+static const Atom atomConstructor = intern("constructor");
+
+// Inline cache of an `obj.name(...)` callee, once a lookup through it has created it
+static InlineCache* calleeCache(CallExpr* call) {
+    if (call->callee->kind != ExprKind::Member) return nullptr;
+    return static_cast<MemberExpr*>(call->callee.get())->cache.get();
+}
+
 Interpreter::Interpreter() {
-    globals = std::make_shared<Environment>();
+    globals = Environment::make();
     environment = globals;
     
     // Default natives
-    auto print = [](std::vector<Value> args) {
+    auto print = [](Interpreter&, NativeArgs args) {
         for(auto& a : args) std::cout << a.toString();
-        return Value("", 0, true);
+        return Value::number(0);
     };
     globals->define("print", Value(print));
     natives["print"] = print; // Keep for backward compat if needed?
 
-    auto println = [](std::vector<Value> args) {
+    auto println = [](Interpreter&, NativeArgs args) {
         for(auto& a : args) std::cout << a.toString();
         std::cout << std::endl;
-        return Value("", 0, true);
+        return Value::number(0);
     };
     globals->define("println", Value(println));
     natives["println"] = println;
@@ -52,14 +98,28 @@ Value Interpreter::getVar(std::string name) {
     return environment->get(name);
 }
 
-void Interpreter::registerNative(std::string name, std::function<Value(std::vector<Value>)> func) {
+void Interpreter::registerNative(std::string name, Value::NativeCall func) {
     natives[name] = func;
     globals->define(name, Value(func));
 }
 
+void Interpreter::registerNative(std::string name, Value::NativeFunc func) {
+    Value adapted(std::move(func));
+    natives[name] = adapted.nativeFunc();
+    globals->define(name, adapted);
+}
+
 void Interpreter::interpret(const std::vector<std::shared_ptr<Stmt>>& statements) {
+    Optimizer().optimize(statements);
+    Resolver(currentFile).resolve(statements);
+    
+    if (useBytecode) {
+        std::shared_ptr<Chunk> chunk = Compiler().compile(statements);
+        run(*chunk);
+        return;
+    }
     for (auto& s : statements) {
-        if (s) execute(s);
+        if (s && execute(s.get()) == Completion::Return) break; // Top-level return ends the script
     }
 }
 
@@ -69,1027 +129,1266 @@ void Interpreter::interpret(const std::vector<std::shared_ptr<Stmt>>& statements
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 
-void Interpreter::execute(std::shared_ptr<Stmt> stmt) {
-    if (isReturning) return;
+namespace {
 
-    if (auto imp = std::dynamic_pointer_cast<ImportStmt>(stmt)) {
-        // JIT Loading
-        std::cout << "[DEBUG] Loading module: " << imp->moduleName << std::endl;
+// The interpreter state a module's top level runs under, put back however it ends
+struct ModuleScope {
+    Interpreter& in;
+    std::shared_ptr<Environment> environment;
+    Module* module;
+    std::string sourceCode;
+    std::string file;
+    
+    ModuleScope(Interpreter& in, Module& entered)
+        : in(in), environment(in.environment), module(in.modules.current),
+          sourceCode(std::move(in.sourceCode)), file(std::move(in.currentFile)) {
+        in.environment = in.globals;
+        in.modules.current = &entered;
+        in.sourceCode = entered.source;
+        in.currentFile = entered.id;
+    }
+    ~ModuleScope() {
+        in.environment = std::move(environment);
+        in.modules.current = module;
+        in.sourceCode = std::move(sourceCode);
+        in.currentFile = std::move(file);
+    }
+};
+
+}
+
+void Interpreter::loadModule(Module& module, bool parsed) {
+    if (!parsed && module.isRemote()) {
+        Lexer lexer(module.source);
+        auto tokens = lexer.tokenize();
+        Parser parser(std::move(tokens));
+        module.statements = parser.parse();
+    } else if (!parsed) {
+        module.statements = ModuleCache::parse(module.id, module.source);
+    }
+    
+    {
+        ModuleScope scope(*this, module);
+        interpret(module.statements);
+    }
+    
+    auto* exports = module.exports.mapVal();
+    for (auto& stmt : module.statements) {
+        if (!stmt || stmt->kind != StmtKind::Export) continue;
+        Stmt* decl = static_cast<ExportStmt*>(stmt.get())->declaration.get();
+        if (!decl) continue;
+        std::string name;
+        if (decl->kind == StmtKind::FuncDecl) name = static_cast<FuncDeclStmt*>(decl)->name;
+        else if (decl->kind == StmtKind::VarDecl) name = static_cast<VarDeclStmt*>(decl)->name;
+        else if (decl->kind == StmtKind::Class) name = static_cast<ClassStmt*>(decl)->name;
+        if (!name.empty()) (*exports)[name] = globals->get(name);
+    }
+    module.state = Module::State::Loaded;
+}
+
+Completion Interpreter::execute(Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::Import: {
+            auto* imp = static_cast<ImportStmt*>(stmt);
+            // JIT Loading
+            std::cout << "[DEBUG] Loading module: " << imp->moduleName << std::endl;
         
-        if (imp->moduleName == "gui" || imp->moduleName == "math" || imp->moduleName == "string" || 
-            imp->moduleName == "array" || imp->moduleName == "map" || imp->moduleName == "db" || 
-            imp->moduleName == "webserver" || imp->moduleName == "fs" || imp->moduleName == "os" || 
-            imp->moduleName == "exec" || imp->moduleName == "regex" || imp->moduleName == "json" || 
-            imp->moduleName == "http") {
-            // Built-in module: import requested symbols
-            if (!imp->symbols.empty()) {
-                for (auto& sym : imp->symbols) {
-                    if (natives.count(sym)) {
-                        try {
-                            // Create a Value wrapper for the native function
-                            Value nativeVal(natives[sym]);
-                            if (globals) {
-                                globals->define(sym, nativeVal);
-                            } else {
-                                std::cerr << "[Import Error] Globals env is null" << std::endl;
+            if (ModuleRegistry::isBuiltin(imp->moduleName)) {
+                // Built-in module: import requested symbols
+                if (!imp->symbols.empty()) {
+                    for (auto& sym : imp->symbols) {
+                        if (natives.count(sym)) {
+                            try {
+                                // Create a Value wrapper for the native function
+                                Value nativeVal(natives[sym]);
+                                if (globals) {
+                                    globals->define(sym, nativeVal);
+                                } else {
+                                    std::cerr << "[Import Error] Globals env is null" << std::endl;
+                                }
+                            } catch (const std::exception& e) {
+                                std::cerr << "[Import Error] Failed to import symbol " << sym << ": " << e.what() << std::endl;
+                            } catch (...) {
+                                std::cerr << "[Import Error] Failed to import symbol " << sym << " (Unknown)" << std::endl;
                             }
-                        } catch (const std::exception& e) {
-                            std::cerr << "[Import Error] Failed to import symbol " << sym << ": " << e.what() << std::endl;
-                        } catch (...) {
-                            std::cerr << "[Import Error] Failed to import symbol " << sym << " (Unknown)" << std::endl;
+                        } else {
+                            // Symbol not found in natives
+                            std::cerr << "[Import Warning] Native symbol '" << sym << "' not found in module '" << imp->moduleName << "'" << std::endl;
                         }
-                    } else {
-                        // Symbol not found in natives
-                        std::cerr << "[Import Warning] Native symbol '" << sym << "' not found in module '" << imp->moduleName << "'" << std::endl;
                     }
                 }
+                return Completion::Normal;
             }
-            return;
-        }
 
-        // File loading
-        std::string filename = imp->moduleName;
-        // User requested .anis extension, support .s (legacy) and .anis
-        if (filename.find('.') == std::string::npos && filename.find("://") == std::string::npos) {
-            filename += ".anis";
-        }
-        
-        std::string source;
-        bool loaded = false;
-
-        // Remote Import detection
-        if (filename.find("http://") == 0 || filename.find("https://") == 0) {
-            // std::cout << "[Remote Import] Fetching: " << filename << std::endl;
-            source = HTTPLib::fetch("GET", filename);
-            if (!source.empty()) {
-                loaded = true;
-            } else {
-                Debugger::runtimeError("Failed to fetch remote module: " + filename, 0);
-                return;
-            }
-        } else {
-            // Resolve relative paths using g_basePath
-            extern std::string g_basePath;
-            std::string fullPath = filename;
-            if (!filename.empty() && filename[0] == '.') {
-                // Remove ./ prefix
-                if (filename.length() >= 2 && filename[1] == '/') {
-                    fullPath = filename.substr(2);  // Remove "./"
+            // File loading
+            Module* importer = modules.current;
+            std::string id = modules.resolve(imp->moduleName, importer);
+            Module* module = modules.find(id);
+            if (!module) {
+                PrefetchedModule loaded;
+                bool prefetched = modules.takePrefetched(id, loaded);
+                if (id.find("://") != std::string::npos) {
+                    if (!prefetched) loaded.source = HTTPLib::fetch("GET", id);
+                    if (loaded.source.empty()) {
+                        Debugger::runtimeError("Failed to fetch remote module: " + id, 0);
+                        return Completion::Normal;
+                    }
+                } else if (!prefetched) {
+                    std::ifstream file(id);
+                    if (!file.is_open()) {
+                        Debugger::runtimeError("Could not find module '" + imp->moduleName + "'", 0);
+                        return Completion::Normal;
+                    }
+                    std::stringstream buffer;
+                    buffer << file.rdbuf();
+                    loaded.source = buffer.str();
                 }
-                fullPath = g_basePath + fullPath;
+                module = &modules.add(id);
+                module->source = std::move(loaded.source);
+                module->statements = std::move(loaded.statements);
+                if (importer) importer->dependencies.push_back(module);
+                loadModule(*module, loaded.parsed);
+            } else if (importer && std::find(importer->dependencies.begin(), importer->dependencies.end(), module) == importer->dependencies.end()) {
+                importer->dependencies.push_back(module);
             }
             
-            std::ifstream file(fullPath);
-            if (file.is_open()) {
-                std::stringstream buffer;
-                buffer << file.rdbuf();
-                source = buffer.str();
-                loaded = true;
-
-                // Extract directory from filename for nested imports
-                // Only for local files
-                extern std::string g_basePath;
-                size_t lastSlash = fullPath.find_last_of('/');
-                if (lastSlash != std::string::npos) {
-                    g_basePath = fullPath.substr(0, lastSlash + 1);
+            // A module still loading is part of an import cycle: its exports are not there yet,
+            // but its top level already defines names as it runs
+            for (auto& sym : imp->symbols) {
+                auto* exports = module->exports.mapVal();
+                auto it = exports->find(sym);
+                if (it != exports->end()) {
+                    environment->define(sym, it->second);
+                } else if (module->state == Module::State::Loaded && globals->get(sym).getType() == ValueType::Undefined) {
+                    std::cerr << "[Import Warning] Symbol '" << sym << "' not found in module '" << imp->moduleName << "'" << std::endl;
                 }
             }
+            return Completion::Normal;
         }
-
-        if (loaded) {
-            // Store source for debugging
-            this->sourceCode = source;
-            
-            Lexer lexer(source);
-            auto tokens = lexer.tokenize();
-            Parser parser(tokens);
-            auto stmts = parser.parse();
-            
-            // For remote imports, we should probably restore g_basePath if it was changed
-            // but we only change it for local files now.
-            interpret(stmts);
-        } else {
-             Debugger::runtimeError("Could not find module '" + imp->moduleName + "'", 0);
-        }
-        return;
-    }
     
-    if (auto dest = std::dynamic_pointer_cast<DestructureStmt>(stmt)) {
-        Value init = evaluate(dest->initializer);
-        if (init.isList && init.listVal && init.listVal->size() >= dest->names.size()) {
-             for (size_t i = 0; i < dest->names.size(); i++) {
-                 environment->define(dest->names[i], (*init.listVal)[i]);
+        case StmtKind::Destructure: {
+            auto* dest = static_cast<DestructureStmt*>(stmt);
+            Value init = evaluate(dest->initializer.get());
+            if (init.isList() && init.listVal() && init.listVal()->size() >= dest->names.size()) {
+                 for (size_t i = 0; i < dest->names.size(); i++) {
+                     environment->define(dest->names[i], (*init.listVal())[i]);
+                 }
+             } else {
+                 Debugger::runtimeError("Destructuring mismatch or not a list. Initializer type: " + std::to_string(init.isList()) + ", Size: " + (init.listVal() ? std::to_string(init.listVal()->size()) : "null"), 0);
              }
-         } else {
-             Debugger::runtimeError("Destructuring mismatch or not a list. Initializer type: " + std::to_string(init.isList) + ", Size: " + (init.listVal ? std::to_string(init.listVal->size()) : "null"), 0);
-         }
-    }
-    else if (auto exp = std::dynamic_pointer_cast<ExportStmt>(stmt)) {
-        // Execute the declaration (function, var, etc)
-        execute(exp->declaration);
-        // TODO: Store in module exports map for import system
-    }
-    else if (auto varDecl = std::dynamic_pointer_cast<VarDeclStmt>(stmt)) {
-        Value val = {"", 0, true};
-        if (varDecl->initializer) val = evaluate(varDecl->initializer);
-        environment->define(varDecl->name, val); // Define in current scope
-    }
-    else if (auto ret = std::dynamic_pointer_cast<ReturnStmt>(stmt)) {
-         lastReturnValue = evaluate(ret->value);
-         isReturning = true;
-    }
-    else if (auto funcDecl = std::dynamic_pointer_cast<FuncDeclStmt>(stmt)) {
-        // Store as Value (Closure) in GLOBAL scope (top-level functions should be global)
-        // Capture CURRENT environment and Params
-        globals->define(funcDecl->name, Value(funcDecl->body, environment, funcDecl->params));
-    }
-    else if (auto block = std::dynamic_pointer_cast<BlockStmt>(stmt)) {
-        executeBlock(block, std::make_shared<Environment>(environment));
-    }
-    else if (auto ifStmt = std::dynamic_pointer_cast<IfStmt>(stmt)) {
-        Value cond = evaluate(ifStmt->condition);
-        if (isTrue(cond)) execute(ifStmt->thenBranch);
-        else if (ifStmt->elseBranch) execute(ifStmt->elseBranch);
-    }
-    else if (auto whileStmt = std::dynamic_pointer_cast<WhileStmt>(stmt)) {
-        while (true) {
-            Value cond = evaluate(whileStmt->condition);
-            if (!isTrue(cond)) break;
-            execute(whileStmt->body);
-            if (isReturning) break;  // Handle early return
+            break;
         }
-    }
-    else if (auto switchStmt = std::dynamic_pointer_cast<SwitchStmt>(stmt)) {
-        Value val = evaluate(switchStmt->condition);
-        bool matchFound = false;
+        case StmtKind::Export: {
+            auto* exp = static_cast<ExportStmt*>(stmt);
+            // Only runs the declaration; loadModule collects the exported names into module.exports
+            return execute(exp->declaration.get());
+        }
+        case StmtKind::VarDecl: {
+            auto* varDecl = static_cast<VarDeclStmt*>(stmt);
+            Value val = {"", 0, true};
+            if (varDecl->initializer) val = evaluate(varDecl->initializer.get());
+            if (varDecl->slot >= 0) environment->slots[varDecl->slot] = val;
+            else environment->define(varDecl->atom, val); // Define in current scope
+            break;
+        }
+        case StmtKind::Return: {
+            auto* ret = static_cast<ReturnStmt*>(stmt);
+            if (ret->tailCall) {
+                auto* call = static_cast<CallExpr*>(ret->value.get());
+                BindingRelease release{nullptr};
+                Value callee;
+                BuiltinMethod method = evaluateCallee(call, callee);
+                release.cache = calleeCache(call);
+                std::vector<Value> args;
+                for (auto& arg : call->args) args.push_back(evaluate(arg.get()));
+                currentLine = call->line;
+                if (method) {
+                    lastReturnValue = method(*this, callee, args);
+                } else if (callee.isClosure()) {
+                    tailCallee = std::move(callee);
+                    tailArgs = std::move(args);
+                    hasTailCall = true;
+                } else {
+                    static const std::string anonymous;
+                    bool named = call->callee->kind == ExprKind::Var;
+                    lastReturnValue = callValue(callee, args, named ? static_cast<VarExpr*>(call->callee.get())->name : anonymous);
+                }
+                return Completion::Return;
+            }
+            lastReturnValue = ret->value ? evaluate(ret->value.get()) : Value::number(0);
+            return Completion::Return;
+        }
+        case StmtKind::Break:
+        case StmtKind::Continue:
+            completionLabel = static_cast<JumpStmt*>(stmt)->label;
+            return stmt->kind == StmtKind::Break ? Completion::Break : Completion::Continue;
+        case StmtKind::FuncDecl: {
+            auto* funcDecl = static_cast<FuncDeclStmt*>(stmt);
+            // Store as Value (Closure) in GLOBAL scope (top-level functions should be global)
+            // Capture CURRENT environment and Params
+            globals->define(funcDecl->name, Value(funcDecl->body, environment, funcDecl->params));
+            break;
+        }
+        case StmtKind::Block: {
+            auto* block = static_cast<BlockStmt*>(stmt);
+            return executeBlock(block, Environment::make(environment, block->locals));
+        }
+        case StmtKind::If: {
+            auto* ifStmt = static_cast<IfStmt*>(stmt);
+            Value cond = evaluate(ifStmt->condition.get());
+            if (isTrue(cond)) return execute(ifStmt->thenBranch.get());
+            else if (ifStmt->elseBranch) return execute(ifStmt->elseBranch.get());
+            break;
+        }
+        case StmtKind::While: {
+            auto* whileStmt = static_cast<WhileStmt*>(stmt);
+            while (isTrue(evaluate(whileStmt->condition.get()))) {
+                Completion c = execute(whileStmt->body.get());
+                if (c == Completion::Normal) continue;
+                if (c == Completion::Return) return c;
+                if (completionLabel != NoAtom && completionLabel != whileStmt->label) return c; // An outer loop's
+                if (c == Completion::Break) break;
+            }
+            break;
+        }
+        case StmtKind::Switch: {
+            auto* switchStmt = static_cast<SwitchStmt*>(stmt);
+            Value val = evaluate(switchStmt->condition.get());
         
-        // Helper to execute case body (which is Stmt, not Value)
-        auto execStmt = [&](std::shared_ptr<Stmt> body) {
-             if (auto block = std::dynamic_pointer_cast<BlockStmt>(body)) {
-                 // For switch cases in same scope, we might just executeBlock? 
-                 // Or create scope?
-                 // Standard is: Switch shares scope or block scope per case?
-                 // Let's create block scope.
-                 executeBlock(block, std::make_shared<Environment>(environment));
-             }
-        };
+            // Helper to execute case body (which is Stmt, not Value)
+            auto execStmt = [&](std::shared_ptr<Stmt> body) {
+                 if (body && body->kind == StmtKind::Block) {
+                     auto* block = static_cast<BlockStmt*>(body.get());
+                     // For switch cases in same scope, we might just executeBlock? 
+                     // Or create scope?
+                     // Standard is: Switch shares scope or block scope per case?
+                     // Let's create block scope.
+                     Completion c = executeBlock(block, Environment::make(environment, block->locals));
+                     // A plain break ends the switch; labelled ones and continue belong to a loop
+                     if (c == Completion::Break && completionLabel == NoAtom) return Completion::Normal;
+                     return c;
+                 }
+                 return Completion::Normal;
+            };
         
-        for (auto& cs : switchStmt->cases) {
-            if (cs.value) { // Case
-                Value caseVal = evaluate(cs.value);
-                bool eq = false;
-                if (val.isInt && caseVal.isInt) eq = (val.intVal == caseVal.intVal);
-                else if (!val.isInt && !caseVal.isInt) eq = (val.strVal == caseVal.strVal);
+            for (auto& cs : switchStmt->cases) {
+                if (cs.value) { // Case
+                    Value caseVal = evaluate(cs.value.get());
+                    bool eq = false;
+                    if (val.isInt() && caseVal.isInt()) eq = (val.intVal() == caseVal.intVal());
+                    else if (val.isNumber() && caseVal.isNumber()) eq = (val.doubleVal() == caseVal.doubleVal());
+                    else if (!val.isNumber() && !caseVal.isNumber()) eq = (val.strVal() == caseVal.strVal());
                 
-                if (eq) {
-                    execStmt(cs.body); 
-                    matchFound = true;
-                    break;
+                    if (eq) {
+                        return execStmt(cs.body);
+                    }
                 }
             }
-        }
         
-        if (!matchFound) {
             for (auto& cs : switchStmt->cases) {
                 if (!cs.value) { 
-                     execStmt(cs.body);
-                     break;
+                     return execStmt(cs.body);
                 }
             }
+            break;
         }
-    }
-    else if (auto classStmt = std::dynamic_pointer_cast<ClassStmt>(stmt)) {
-        std::shared_ptr<Class> superclass = nullptr;
-        if (!classStmt->superclass.empty()) {
-            Value sc = getVar(classStmt->superclass);
-            if (!sc.isClass || !sc.classVal) {
-                Debugger::runtimeError("Superclass must be a class.", classStmt->line);
+        case StmtKind::Class: {
+            auto* classStmt = static_cast<ClassStmt*>(stmt);
+            Ref<Class> superclass;
+            if (!classStmt->superclass.empty()) {
+                Value sc = getVar(classStmt->superclass);
+                if (!sc.isClass() || !sc.classVal()) {
+                    Debugger::runtimeError("Superclass must be a class.", classStmt->line);
+                }
+                superclass = sc.classVal();
             }
-            superclass = sc.classVal;
-        }
 
-        // Define class name in environment to allow recursive references inside methods (though 'this' is preferred)
-        // Actually, we usually define it after creation.
-        environment->define(classStmt->name, Value()); 
+            // Define class name in environment to allow recursive references inside methods (though 'this' is preferred)
+            // Actually, we usually define it after creation.
+            environment->define(classStmt->name, Value()); 
 
-        auto klass = std::make_shared<Class>(classStmt->name, superclass);
+            Ref<Class> klass = new Class(classStmt->name, superclass);
         
-        // Methods
-        for (auto& m : classStmt->methods) {
-            Value method(m.body, environment, m.params); // Capture closure
-            method.isNative = false; 
+            // Methods
+            for (auto& m : classStmt->methods) {
+                Value method(m.body, environment, m.params); // Capture closure
             
-            if (m.isStatic) {
-                klass->staticFields[m.name] = method;
-            } else if (m.isGetter) {
-                method.isGetter = true;
-                klass->getters[m.name] = method;
-            } else if (m.isSetter) {
-                method.isSetter = true;
-                klass->setters[m.name] = method;
-            } else {
-                klass->methods[m.name] = method;
+                if (m.isStatic) {
+                    klass->staticFields[intern(m.name)] = method;
+                } else if (m.isGetter) {
+                    method.markGetter();
+                    klass->getters[intern(m.name)] = method;
+                } else if (m.isSetter) {
+                    method.markSetter();
+                    klass->setters[intern(m.name)] = method;
+                } else {
+                    klass->methods[intern(m.name)] = method;
+                }
             }
-        }
         
-        // Fields
-        for (auto& f : classStmt->fields) {
-            if (f.isStatic) {
-                Value val = {"undefined", 0, false};
-                if (f.initializer) {
-                    val = evaluate(f.initializer); 
+            // Fields
+            for (auto& f : classStmt->fields) {
+                if (f.isStatic) {
+                    Value val = {"undefined", 0, false};
+                    if (f.initializer) {
+                        val = evaluate(f.initializer.get()); 
+                    }
+                    klass->staticFields[intern(f.name)] = val;
+                } else {
+                    // Instance fields: store initializer expression to be evaluated on instantiation
+                    klass->instanceFields[f.name] = f.initializer;
+                    if (f.isPrivate) klass->privateFieldNames.push_back(f.name);
                 }
-                klass->staticFields[f.name] = val;
-            } else {
-                // Instance fields: store initializer expression to be evaluated on instantiation
-                klass->instanceFields[f.name] = f.initializer;
-                if (f.isPrivate) klass->privateFieldNames.push_back(f.name);
             }
+        
+            environment->assign(classStmt->name, Value(klass.get()));
+            break;
         }
+        case StmtKind::Try: {
+            auto* tryStmt = static_cast<TryStmt*>(stmt);
+            Completion c = Completion::Normal;
+            try {
+                c = executeBlock(tryStmt->tryBlock.get(), Environment::make(environment, tryStmt->tryBlock->locals));
+            } catch (RuntimeError& e) {
+                if (tryStmt->catchBlock) {
+                    // Create scope for catch
+                    auto catchEnv = Environment::make(environment, tryStmt->catchBlock->locals);
+                    // Bind error
+                    catchEnv->define(tryStmt->catchVar, e.value);
+                    c = executeBlock(tryStmt->catchBlock.get(), catchEnv);
+                }
+            }
         
-        environment->assign(classStmt->name, Value(klass));
-    }
-    else if (auto tryStmt = std::dynamic_pointer_cast<TryStmt>(stmt)) {
-        try {
-            executeBlock(tryStmt->tryBlock, std::make_shared<Environment>(environment));
-        } catch (RuntimeError& e) {
-            if (tryStmt->catchBlock) {
-                // Create scope for catch
-                auto catchEnv = std::make_shared<Environment>(environment);
-                // Bind error
-                catchEnv->define(tryStmt->catchVar, e.value);
-                executeBlock(tryStmt->catchBlock, catchEnv);
+            if (tryStmt->finallyBlock) {
+                // finally runs on the way out of a return/break too, keeping what was pending
+                // unless it leaves by a jump of its own
+                Value pendingValue = lastReturnValue;
+                Atom pendingLabel = completionLabel;
+                Completion f = executeBlock(tryStmt->finallyBlock.get(), Environment::make(environment, tryStmt->finallyBlock->locals));
+                if (f != Completion::Normal) return f;
+                lastReturnValue = std::move(pendingValue);
+                completionLabel = pendingLabel;
             }
+            return c;
         }
-        
-        if (tryStmt->finallyBlock) {
-            executeBlock(tryStmt->finallyBlock, std::make_shared<Environment>(environment));
+        case StmtKind::Throw: {
+            auto* throwStmt = static_cast<ThrowStmt*>(stmt);
+            Value val = evaluate(throwStmt->expression.get());
+            throw RuntimeError(val);
         }
+        case StmtKind::Expr: {
+            auto* exprStmt = static_cast<ExprStmt*>(stmt);
+            lastExpressionValue = evaluate(exprStmt->expr.get());
+            hasLastExpressionValue = true;
+            break;
+        }
+        default:
+            break;
     }
-    else if (auto throwStmt = std::dynamic_pointer_cast<ThrowStmt>(stmt)) {
-        Value val = evaluate(throwStmt->expression);
-        throw RuntimeError(val);
-    }
-    else if (auto exprStmt = std::dynamic_pointer_cast<ExprStmt>(stmt)) {
-        lastExpressionValue = evaluate(exprStmt->expr);
-        hasLastExpressionValue = true;
-    }
+    return Completion::Normal;
 }
 
 
 
 
-void Interpreter::executeBlock(std::shared_ptr<BlockStmt> block, std::shared_ptr<Environment> env) {
+Completion Interpreter::executeBlock(BlockStmt* block, std::shared_ptr<Environment> env) {
+    Gc::maybeCollect(); // Safe point: everything live is referenced from somewhere
     std::shared_ptr<Environment> previous = environment;
     environment = env;
     
-    for (auto& s : block->statements) {
-        execute(s);
-        if (isReturning) break;
+    Completion c = Completion::Normal;
+    try {
+        if (useBytecode) {
+            c = run(*compileBlock(block));
+        } else {
+            for (auto& s : block->statements) {
+                c = execute(s.get());
+                if (c != Completion::Normal) break;
+            }
+        }
+    } catch (...) {
+        environment = previous; // Unwind scope for try/catch
+        throw;
     }
     
     environment = previous;
+    return c;
 }
 
-Value Interpreter::evaluate(std::shared_ptr<Expr> expr) {
-    if (expr->line > 0) currentLine = expr->line;
-    if (auto lit = std::dynamic_pointer_cast<LiteralExpr>(expr)) {
-        if (lit->isString) return {lit->value, 0, false};
-        return {"", std::stoi(lit->value), true};
-    }
-    if (auto var = std::dynamic_pointer_cast<VarExpr>(expr)) {
-        return getVar(var->name);
-    }
-    if (auto t = std::dynamic_pointer_cast<ThisExpr>(expr)) {
-        return getVar("this");
-    }
-    if (auto s = std::dynamic_pointer_cast<SuperExpr>(expr)) {
-        // Need to resolve 'super'
-        // 'super' keyword logic:
-        // We need 'this' and the superclass.
-        // Usually handled by looking up 'super' in environment if we bound it?
-        // Or finding 'this' finding its class's superclass?
-        // Simplest: Resolving 'super' requires 'this' to be bound to an instance, 
-        // and we need to know the class where the method was defined.
-        // Complex to implement strictly correctly (traits/mixins etc).
-        // Naive approach: get("super")? Or just get("this").class.superclass?
+Value Interpreter::evaluate(Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::Literal: {
+            auto* lit = static_cast<LiteralExpr*>(expr);
+            if (lit->decoded) return lit->constant;
+            if (lit->isString) return {lit->value, 0, false};
+            return Value::parseNumber(lit->value);
+        }
+        case ExprKind::Var: {
+            auto* var = static_cast<VarExpr*>(expr);
+            if (var->slot >= 0) return environment->ancestor(var->depth)->slots[var->slot];
+            if (var->depth == VarExpr::Global) return globals->get(var->atom);
+            return environment->get(var->atom);
+        }
+        case ExprKind::This: {
+            return environment->get(atomThis);
+        }
+        case ExprKind::Super: {
+            auto* s = static_cast<SuperExpr*>(expr);
+            // Need to resolve 'super'
+            // 'super' keyword logic:
+            // We need 'this' and the superclass.
+            // Usually handled by looking up 'super' in environment if we bound it?
+            // Or finding 'this' finding its class's superclass?
+            // Simplest: Resolving 'super' requires 'this' to be bound to an instance, 
+            // and we need to know the class where the method was defined.
+            // Complex to implement strictly correctly (traits/mixins etc).
+            // Naive approach: get("super")? Or just get("this").class.superclass?
         
-        // BETTER: When calling a method on super, we look up method on superclass 
-        // but bind 'this' to current instance.
+            // BETTER: When calling a method on super, we look up method on superclass 
+            // but bind 'this' to current instance.
         
-        // Let's assume we bind "super" in the environment of methods?
-        // Or we just fetch 'this' and traverse up 1 level? 
-        // Issue: if passing 'this', getting class, getting superclass -> infinite loop if calling same method name.
-        // Correct way: The closure needs to know its "HomeObject" (ES6).
+            // Let's assume we bind "super" in the environment of methods?
+            // Or we just fetch 'this' and traverse up 1 level? 
+            // Issue: if passing 'this', getting class, getting superclass -> infinite loop if calling same method name.
+            // Correct way: The closure needs to know its "HomeObject" (ES6).
         
-        // FOR NOW: Simplified. Bind "super" in constructor/methods if extends?
-        // Let's use getVar("super") approach. We must define it when entering method.
-        Value sup = getVar("super");
-        if (s->property) {
-             // super.method
-             if (sup.isClass && sup.classVal) {
-                  Value method = sup.classVal->findMethod(std::dynamic_pointer_cast<VarExpr>(s->property)->name);
+            // FOR NOW: Simplified. Bind "super" in constructor/methods if extends?
+            // Let's use getVar("super") approach. We must define it when entering method.
+            Value sup = environment->get(atomSuper);
+            if (s->property) {
+                 // super.method
+                 if (sup.isClass() && sup.classVal()) {
+                      Value method = sup.classVal()->findMethod(static_cast<VarExpr*>(s->property.get())->atom);
                   
-                  if (method.isClosure) {
-                       Value instance = getVar("this");
-                       auto boundEnv = std::make_shared<Environment>(method.closureEnv);
-                       boundEnv->define("this", instance);
-                       if (sup.classVal->superclass) {
-                           boundEnv->define("super", Value(sup.classVal->superclass));
-                       }
+                      if (method.isClosure()) {
+                           Value instance = environment->get(atomThis);
+                           auto boundEnv = Environment::make(method.closureEnv());
+                           boundEnv->define(atomThis, instance);
+                           if (sup.classVal()->superclass) {
+                               boundEnv->define(atomSuper, Value(sup.classVal()->superclass.get()));
+                           }
                        
-                       Value boundMethod = method;
-                       boundMethod.closureEnv = boundEnv;
-                       return boundMethod;
-                  }
-                  return method;
-             }
-        }
+                           Value boundMethod = method.withEnv(boundEnv);
+                           return boundMethod;
+                      }
+                      return method;
+                 }
+            }
         
-        // super() constructor call
-        if (sup.isClass && sup.classVal) {
-             Value ctor = sup.classVal->findMethod("constructor");
-             if (ctor.isClosure) {
-                 // Bind 'this' to current instance
-                 Value instance = getVar("this");
+            // super() constructor call
+            if (sup.isClass() && sup.classVal()) {
+                 Value ctor = sup.classVal()->findMethod(atomConstructor);
+                 if (ctor.isClosure()) {
+                     // Bind 'this' to current instance
+                     Value instance = environment->get(atomThis);
                  
-                 auto boundEnv = std::make_shared<Environment>(ctor.closureEnv);
-                 boundEnv->define("this", instance);
-                 if (sup.classVal->superclass) {
-                     boundEnv->define("super", Value(sup.classVal->superclass));
-                 }
+                     auto boundEnv = Environment::make(ctor.closureEnv());
+                     boundEnv->define(atomThis, instance);
+                     if (sup.classVal()->superclass) {
+                         boundEnv->define(atomSuper, Value(sup.classVal()->superclass.get()));
+                     }
                  
-                 Value boundCtor = ctor;
-                 boundCtor.closureEnv = boundEnv;
-                 return boundCtor;
-             }
+                     Value boundCtor = ctor.withEnv(boundEnv);
+                     return boundCtor;
+                 }
+            }
+            return sup;
         }
-        return sup;
-    }
-    if (auto n = std::dynamic_pointer_cast<NewExpr>(expr)) {
-         Value val = getVar(n->className);
+        case ExprKind::New: {
+            auto* n = static_cast<NewExpr*>(expr);
+             Value val = getVar(n->className);
          
-         // Allow calling native functions with new (e.g. Error)
-         if (val.isNative) {
-              std::vector<Value> args;
-              for (auto& arg : n->args) {
-                  args.push_back(evaluate(arg));
-              }
-              return val.nativeFunc(args);
-         }
+             // Allow calling native functions with new (e.g. Error)
+             if (val.isNative()) {
+                  std::vector<Value> args;
+                  for (auto& arg : n->args) {
+                      args.push_back(evaluate(arg.get()));
+                  }
+                  return val.nativeFunc()(*this, args);
+             }
 
-         if (!val.isClass || !val.classVal) {
-             Debugger::runtimeError("Operands must be a class.", n->line);
-         }
+             if (!val.isClass() || !val.classVal()) {
+                 Debugger::runtimeError("Operands must be a class.", n->line);
+             }
          
-         auto instance = std::make_shared<Instance>(val.classVal);
-         Value instVal(instance);
+             Ref<Instance> instance = new Instance(val.classVal());
+             Value instVal(instance.get());
          
-         // Initialize instance fields
-         // Need to walk up inheritance chain? JS does.
-         // Simplified: Just evaluating this class's fields. Inheritance of fields -> usually done by super() call in JS.
-         // BUT standard JS fields are added to instance.
-         // Let's initialize fields for the class hierarchy here?
-         // Actually, constructors call super() which should init parent fields.
-         // BUT we have field declarations in class body now.
-         // Let's evaluate them here for THIS class. Parent logic depends on super() call? 
-         // JS Class Fields: added when class is constructed/super returns.
+             // Initialize instance fields
+             // Need to walk up inheritance chain? JS does.
+             // Simplified: Just evaluating this class's fields. Inheritance of fields -> usually done by super() call in JS.
+             // BUT standard JS fields are added to instance.
+             // Let's initialize fields for the class hierarchy here?
+             // Actually, constructors call super() which should init parent fields.
+             // BUT we have field declarations in class body now.
+             // Let's evaluate them here for THIS class. Parent logic depends on super() call? 
+             // JS Class Fields: added when class is constructed/super returns.
          
-         // Let's implement: Iterate whole hierarchy and init fields (easier than hooking super())
-         // Or just hook super()?
-         // Let's do: Init fields for this class.
-         for (auto const& field : val.classVal->instanceFields) {
-             if (field.second) {
-                 // Evaluate initializer in context of NEW instance? or Global?
-                 // JS: evaluated in context of constructor?
-                 // Should create a temp scope?
-                 // Usually fields are simple literals. If referring to 'this', we need scope.
-                 Value init = evaluate(field.second);
-                 instance->set(field.first, init);
-             } else {
-                 instance->set(field.first, Value("undefined", 0, false));
+             // Let's implement: Iterate whole hierarchy and init fields (easier than hooking super())
+             // Or just hook super()?
+             // Let's do: Init fields for this class.
+             for (auto const& field : val.classVal()->instanceFields) {
+                 if (field.second) {
+                     // Evaluate initializer in context of NEW instance? or Global?
+                     // JS: evaluated in context of constructor?
+                     // Should create a temp scope?
+                     // Usually fields are simple literals. If referring to 'this', we need scope.
+                     Value init = evaluate(field.second.get());
+                     instance->set(intern(field.first), init);
+                 } else {
+                     instance->set(intern(field.first), Value("undefined", 0, false));
+                 }
              }
-         }
          
-         // Constructor call
-         Value ctor = val.classVal->findMethod("constructor");
-         if (ctor.isClosure) {
-            std::vector<Value> args;
-            for(auto& a : n->args) args.push_back(evaluate(a));
+             // Constructor call
+             Value ctor = val.classVal()->findMethod(atomConstructor);
+             if (ctor.isClosure()) {
+                std::vector<Value> args;
+                for(auto& a : n->args) args.push_back(evaluate(a.get()));
             
-            // Call constructor with 'this' bound to instance
-            // callClosure(ctor, args); // REMOVED: using manual logic below
+                // Call constructor with 'this' bound to instance
+                // callClosure(ctor, args); // REMOVED: using manual logic below
             
-            // Temporary manual call logic for constructor to inject 'this'
-            // Create environment for method
-            auto methodEnv = std::make_shared<Environment>(ctor.closureEnv);
-            methodEnv->define("this", instVal);
-            // define "super"
-            if (val.classVal->superclass) {
-                 methodEnv->define("super", Value(val.classVal->superclass));
-            }
+                // Temporary manual call logic for constructor to inject 'this'
+                // Create environment for method
+                auto* body = static_cast<BlockStmt*>(ctor.closureBody().get());
+                prepare(body, ctor.closureParams());
+                auto methodEnv = Environment::make(ctor.closureEnv(), body->locals);
+                methodEnv->define(atomThis, instVal);
+                // define "super"
+                if (val.classVal()->superclass) {
+                     methodEnv->define(atomSuper, Value(val.classVal()->superclass.get()));
+                }
 
-            // Bind params
-            for (size_t i = 0; i < ctor.closureParams.size(); i++) {
-                if (i < args.size()) methodEnv->define(ctor.closureParams[i], args[i]);
-                else methodEnv->define(ctor.closureParams[i], {"undefined", 0, false});
-            }
+                bindParams(ctor.closureParams(), methodEnv, args);
             
-            executeBlock(std::dynamic_pointer_cast<BlockStmt>(ctor.closureBody), methodEnv);
-         }
+                currentLine = n->line;
+                CallDepthGuard guard(*this, body);
+                executeBlock(body, methodEnv);
+                if (hasTailCall) completeTailCall(); // Result ignored, like any constructor return value
+             }
          
-         return instVal;
-    }
-    if (auto unary = std::dynamic_pointer_cast<UnaryExpr>(expr)) {
-        Value right = evaluate(unary->right);
-        if (unary->op == "!") return {"", !isTrue(right) ? 1 : 0, true};
-        if (unary->op == "-" && right.isInt) return {"", -right.intVal, true};
-        return right;
-    }
-    if (auto call = std::dynamic_pointer_cast<CallExpr>(expr)) {
-        Value callee = evaluate(call->callee);
-        
-        std::vector<Value> args;
-        for (auto& arg : call->args) {
-            args.push_back(evaluate(arg));
+             return instVal;
         }
-        
-        if (callee.isNative) {
-            return callee.nativeFunc(args);
+        case ExprKind::Unary: {
+            auto* unary = static_cast<UnaryExpr*>(expr);
+            Value right = evaluate(unary->right.get());
+            if (unary->op == UnaryOp::Not) return Value::number(!isTrue(right) ? 1 : 0);
+            if (unary->op == UnaryOp::Neg) return negate(right);
+            return right;
         }
+        case ExprKind::Call: {
+            auto* call = static_cast<CallExpr*>(expr);
+            BindingRelease release{nullptr};
+            Value callee;
+            BuiltinMethod method = evaluateCallee(call, callee);
+            release.cache = calleeCache(call);
         
-        if (callee.isClosure) {
-             return callClosure(callee, args);
-        }
+            std::vector<Value> args;
+            for (auto& arg : call->args) {
+                args.push_back(evaluate(arg.get()));
+            }
+            currentLine = call->line; // Call records and errors report the line of the call
+            if (method) return method(*this, callee, args);
         
-        std::string name = "expression";
-        if (auto var = std::dynamic_pointer_cast<VarExpr>(call->callee)) {
-            name = "'" + var->name + "'";
+            static const std::string anonymous;
+            bool named = call->callee->kind == ExprKind::Var;
+            return callValue(callee, args, named ? static_cast<VarExpr*>(call->callee.get())->name : anonymous);
         }
-        Debugger::runtimeError("Attempt to call non-function: " + name + " is " + callee.toString(), currentLine, sourceCode, currentFile);
-        return {"", 0, true}; // Unreachable
-    }
-    if (auto ternary = std::dynamic_pointer_cast<TernaryExpr>(expr)) {
-        Value cond = evaluate(ternary->condition);
-        if (isTrue(cond)) {
-            return evaluate(ternary->trueExpr);
-        } else {
-            return evaluate(ternary->falseExpr);
-        }
-    }
-    if (auto bin = std::dynamic_pointer_cast<BinaryExpr>(expr)) {
-        if (bin->op == "+=") {
-            if (auto var = std::dynamic_pointer_cast<VarExpr>(bin->left)) {
-                 Value r = evaluate(bin->right);
-                 Value l = getVar(var->name); 
-                 if (l.isInt && r.isInt) {
-                     Value newVal("", l.intVal + r.intVal, true);
-                     setVar(var->name, newVal);
-                     return newVal;
-                 }
+        case ExprKind::Ternary: {
+            auto* ternary = static_cast<TernaryExpr*>(expr);
+            Value cond = evaluate(ternary->condition.get());
+            if (isTrue(cond)) {
+                return evaluate(ternary->trueExpr.get());
+            } else {
+                return evaluate(ternary->falseExpr.get());
             }
+            break;
         }
-        if (bin->op == "=") {
-            Value val = evaluate(bin->right);
-            if (auto var = std::dynamic_pointer_cast<VarExpr>(bin->left)) {
-                environment->assign(var->name, val);
-                return val;
-            } else if (auto mem = std::dynamic_pointer_cast<MemberExpr>(bin->left)) {
-                // Object property set
-                Value obj = evaluate(mem->object);
-                std::string key;
-                if (mem->computed) {
-                    key = evaluate(mem->property).toString();
-                } else if (auto lit = std::dynamic_pointer_cast<LiteralExpr>(mem->property)) { // Changed check from VarExpr
-                     // Parser produces LiteralExpr for non-computed property? 
-                     // Parser.primary produced LiteralExpr for .property? 
-                     // Looking at Parser::primary member access...
-                     // Wait, in Parser::call(), we parse .identifier. 
-                     // We need to check how MemberExpr is constructed for dot notation.
-                     // Parser code: 
-                     // consume(TOK_DOT)
-                     // name = consume(TOK_IDENTIFIER)
-                     // property = std::make_shared<LiteralExpr>(name.text, true) <-- Logic I should assume.
-                     // Let's verify Parser::call logic later. Assuming LiteralExpr for now.
-                     key = lit->value;
-                } else if (auto v = std::dynamic_pointer_cast<VarExpr>(mem->property)) {
-                     // Sometimes we might use VarExpr?
-                     key = v->name;
-                }
-
-                if (obj.isMap && obj.mapVal) {
-                    (*obj.mapVal)[key] = val;
-                    return val;
-                }
-                if (obj.isInstance && obj.instanceVal) {
-                    // Check setter
-                    Value setter = obj.instanceVal->klass->findSetter(key);
-                    if (setter.isClosure) {
-                         // Invoke setter
-                         // Bind 'this'
-                         auto boundEnv = std::make_shared<Environment>(setter.closureEnv);
-                         boundEnv->define("this", obj);
-                         if (obj.instanceVal->klass->superclass) {
-                             boundEnv->define("super", Value(obj.instanceVal->klass->superclass));
+        case ExprKind::Binary: {
+            auto* bin = static_cast<BinaryExpr*>(expr);
+            switch (bin->op) {
+                case BinaryOp::AddAssign: {
+                    if (bin->left->kind == ExprKind::Var) {
+                         auto* var = static_cast<VarExpr*>(bin->left.get());
+                         Value r = evaluate(bin->right.get());
+                         if (var->slot >= 0) {
+                             Value& l = environment->ancestor(var->depth)->slots[var->slot];
+                             if (l.getType() == ValueType::Int && r.getType() == ValueType::Int &&
+                                 intBinaryOp(OP_ADD, l.intVal(), r.intVal(), l)) return l;
+                             if (l.isNumber() && r.isNumber()) {
+                                 l = binaryOp(OP_ADD, l, r);
+                                 return l;
+                             }
+                             return Value::number(0);
+                         }
+                         Environment* scope = var->depth == VarExpr::Global ? globals.get() : environment.get();
+                         Value l = scope->get(var->atom); 
+                         if (l.isNumber() && r.isNumber()) {
+                             Value newVal = binaryOp(OP_ADD, l, r);
+                             scope->assign(var->atom, newVal);
+                             return newVal;
                          }
-                         // Param name? Usually setters have 1 param.
-                         std::string paramName = setter.closureParams.size() > 0 ? setter.closureParams[0] : "value";
-                         boundEnv->define(paramName, val);
-                         
-                         executeBlock(std::dynamic_pointer_cast<BlockStmt>(setter.closureBody), boundEnv);
-                         return val;
                     }
-                    obj.instanceVal->set(key, val);
-                    return val;
+                    return Value::number(0);
+                }
+                case BinaryOp::Assign: {
+                    Value val = evaluate(bin->right.get());
+                    if (bin->left->kind == ExprKind::Var) {
+                        auto* var = static_cast<VarExpr*>(bin->left.get());
+                        if (var->slot >= 0) environment->ancestor(var->depth)->slots[var->slot] = val;
+                        else if (var->depth == VarExpr::Global) globals->assign(var->atom, val);
+                        else environment->assign(var->atom, val);
+                        return val;
+                    } else if (bin->left->kind == ExprKind::Member) {
+                        auto* mem = static_cast<MemberExpr*>(bin->left.get());
+                        // Object property set
+                        Value obj = evaluate(mem->object.get());
+                        if (mem->computed) {
+                            std::string key = evaluate(mem->property.get()).toString();
+                            return setMember(obj, key, lookupAtom(key), val, bin->line);
+                        }
+                        return setMemberCached(obj, mem, val, bin->line);
+                    }
+                    Debugger::runtimeError("Invalid assignment target.", bin->line);
+                    break;
+                }
+                
+                // Short-circuit logic
+                case BinaryOp::And: {
+                     Value l = evaluate(bin->left.get());
+                     if (!isTrue(l)) return l; // Short-circuit false
+                     return evaluate(bin->right.get());
+                }
+                case BinaryOp::Or: {
+                     Value l = evaluate(bin->left.get());
+                     if (isTrue(l)) return l; // Short-circuit true
+                     return evaluate(bin->right.get());
                 }
-                if (obj.isClass && obj.classVal) {
-                    obj.classVal->staticFields[key] = val;
-                    return val;
+                
+                default: {
+                    Value l = evaluate(bin->left.get());
+                    Value r = evaluate(bin->right.get());
+                    if (l.getType() == ValueType::Int && r.getType() == ValueType::Int &&
+                        intBinaryOp(opCodeFor(bin->op), l.intVal(), r.intVal(), l)) return l;
+                    return binaryOp(opCodeFor(bin->op), l, r);
                 }
             }
-            Debugger::runtimeError("Invalid assignment target.", bin->line);
-        }
-        
-        // Short-circuit logic
-        if (bin->op == "&&") {
-             Value l = evaluate(bin->left);
-             if (!isTrue(l)) return l; // Short-circuit false
-             return evaluate(bin->right);
-        }
-        if (bin->op == "||") {
-             Value l = evaluate(bin->left);
-             if (isTrue(l)) return l; // Short-circuit true
-             return evaluate(bin->right);
-        }
-
-        Value l = evaluate(bin->left);
-        Value r = evaluate(bin->right);
-        
-        if (bin->op == "==") {
-             bool eq = (l.isInt == r.isInt) && (l.intVal == r.intVal) && (l.strVal == r.strVal);
-             return {"", eq ? 1 : 0, true};
-        }
-        if (bin->op == "!=") {
-             bool neq = !((l.isInt == r.isInt) && (l.intVal == r.intVal) && (l.strVal == r.strVal));
-             return {"", neq ? 1 : 0, true};
-        }
-        if (bin->op == "<") {
-             if (l.isInt && r.isInt) return {"", (l.intVal < r.intVal) ? 1 : 0, true};
-             return {"", 0, true};
-        }
-        if (bin->op == ">") {
-             if (l.isInt && r.isInt) return {"", (l.intVal > r.intVal) ? 1 : 0, true};
-             return {"", 0, true};
-        }
-        if (bin->op == "<=") {
-             if (l.isInt && r.isInt) return {"", (l.intVal <= r.intVal) ? 1 : 0, true};
-             return {"", 0, true};
+            break;
         }
-        if (bin->op == ">=") {
-             if (l.isInt && r.isInt) return {"", (l.intVal >= r.intVal) ? 1 : 0, true};
-             return {"", 0, true};
-        }
-        if (bin->op == "+") {
-             if (l.isInt && r.isInt) return {"", l.intVal + r.intVal, true};
-             return {l.toString() + r.toString(), 0, false};
-        }
-        if (bin->op == "-") {
-             if (l.isInt && r.isInt) return {"", l.intVal - r.intVal, true};
-             return {"", 0, true};
-        }
-        if (bin->op == "*") {
-             if (l.isInt && r.isInt) return {"", l.intVal * r.intVal, true};
-             return {"", 0, true};
-        }
-        if (bin->op == "/") {
-             if (l.isInt && r.isInt && r.intVal != 0) return {"", l.intVal / r.intVal, true};
-             return {"", 0, true};
-        }
-
-    }
     
     // Function Expression (Lambda)
-    if (auto func = std::dynamic_pointer_cast<FunctionExpr>(expr)) {
-        return Value(func->body, environment, func->params);
-    }
+        case ExprKind::Function: {
+            auto* func = static_cast<FunctionExpr*>(expr);
+            return Value(func->body, environment, func->params);
+        }
     
-    if (auto jsx = std::dynamic_pointer_cast<JsxExpr>(expr)) {
-        // Component Expansion?
-        // Check if tagName is a variable (function) in scope
-        Value v = getVar(jsx->tagName);
-        if (v.isClosure) {
-             // User Component
-             // Capture props
-             std::map<std::string, Value> props;
-             for (auto const& attr : jsx->attributes) {
-                  props[attr.first] = evaluate(attr.second);
-             }
+        case ExprKind::Jsx: {
+            auto* jsx = static_cast<JsxExpr*>(expr);
+            // Component Expansion?
+            // Check if tagName is a variable (function) in scope
+            Value v = getVar(jsx->tagName);
+            if (v.isClosure()) {
+                 // User Component
+                 // Capture props
+                 std::map<std::string, Value> props;
+                 for (auto const& attr : jsx->attributes) {
+                      props[attr.first] = evaluate(attr.second.get());
+                 }
              
-             // Call it with props
-             Value ret = callClosure(v, { Value(props) }); // Use Value
-             return ret;
-         }
+                 // Call it with props
+                 Value ret = callClosure(v, { Value(props) }); // Use Value
+                 return ret;
+             }
          
-         std::string xml = "<" + jsx->tagName;
-        for (auto const& attr : jsx->attributes) {
-             std::string key = attr.first;
-             Value attrVal = evaluate(attr.second);
-             if (key.substr(0, 2) == "on" && attrVal.isClosure) {
-                 std::string id = "cb_" + std::to_string((uintptr_t)attrVal.closureBody.get());
-                 if (attrVal.isNative && !attrVal.nativeId.empty()) {
-                     id = attrVal.nativeId;
-                 }
+             std::string xml = "<" + jsx->tagName;
+            for (auto const& attr : jsx->attributes) {
+                 std::string key = attr.first;
+                 Value attrVal = evaluate(attr.second.get());
+                 if (key.substr(0, 2) == "on" && attrVal.isCallable()) {
+                     std::string id = "cb_" + std::to_string((uintptr_t)attrVal.closureBody().get());
+                     if (attrVal.isNative() && !attrVal.nativeId().empty()) {
+                         id = attrVal.nativeId();
+                     }
 
-                 // Use bind_native_input for onInput, bind_native_click for others
-                 if (key == "onInput" && natives.count("bind_native_input")) {
-                     natives["bind_native_input"]({Value(id, 0, false), attrVal});
-                 } else if (natives.count("bind_native_click")) {
-                     natives["bind_native_click"]({Value(id, 0, false), attrVal});
-                 }
+                     // Use bind_native_input for onInput, bind_native_click for others
+                     if (key == "onInput" && natives.count("bind_native_input")) {
+                         natives["bind_native_input"](*this, std::vector<Value>{Value(id, 0, false), attrVal});
+                     } else if (natives.count("bind_native_click")) {
+                         natives["bind_native_click"](*this, std::vector<Value>{Value(id, 0, false), attrVal});
+                     }
                  
-                 xml += " " + key + "=\"" + id + "\"";
-                 continue;
+                     xml += " " + key + "=\"" + id + "\"";
+                     continue;
+                 }
+                 xml += " " + key + "=\"" + attrVal.toString() + "\"";
              }
-             xml += " " + key + "=\"" + attrVal.toString() + "\"";
-         }
-        // ... children logic
-        if (jsx->children.empty()) {
-            xml += " />";
-        } else {
-            xml += ">";
-            for(auto c : jsx->children) {
-                 Value cv = evaluate(c);
-                //  std::cerr << "JSX CHILD: isList=" << cv.isList << " isInt=" << cv.isInt << " isClosure=" << cv.isClosure << " isNative=" << cv.isNative << " str=" << cv.strVal.substr(0, 50) << std::endl;
-                 // Skip falsy values (for conditional rendering: {condition && <Component />})
-                 // IMPORTANT: Lists should NOT be treated as falsy even if strVal is empty!
-                 bool isFalsy = (cv.isInt && cv.intVal == 0) || (!cv.isInt && !cv.isList && cv.strVal.empty());
-                 if (!isFalsy) {
-                     // Check if it is a list (result of map)
-                     if (cv.isList && cv.listVal) {
-                         // Flatten list
-                        //  std::cerr << "FLATTEN: List size=" << cv.listVal->size() << std::endl;
-                         for (const auto& item : *cv.listVal) {
-                             xml += item.toString();
-                            //  std::cerr << "FLATTEN ITEM: " << item.toString().substr(0, 100) << "..." << std::endl;
+            // ... children logic
+            if (jsx->children.empty()) {
+                xml += " />";
+            } else {
+                xml += ">";
+                for(auto c : jsx->children) {
+                     Value cv = evaluate(c.get());
+                    //  std::cerr << "JSX CHILD: isList=" << cv.isList() << " isInt=" << cv.isInt() << " isClosure=" << cv.isClosure() << " isNative=" << cv.isNative() << " str=" << cv.strVal().substr(0, 50) << std::endl;
+                     // Skip falsy values (for conditional rendering: {condition && <Component />})
+                     // IMPORTANT: Lists should NOT be treated as falsy even if strVal is empty!
+                     bool isFalsy = (cv.isNumber() && !cv.isTruthy()) || (!cv.isNumber() && !cv.isList() && cv.strVal().empty());
+                     if (!isFalsy) {
+                         // Check if it is a list (result of map)
+                         if (cv.isList() && cv.listVal()) {
+                             // Flatten list
+                            //  std::cerr << "FLATTEN: List size=" << cv.listVal()->size() << std::endl;
+                             for (const auto& item : *cv.listVal()) {
+                                 xml += item.toString();
+                                //  std::cerr << "FLATTEN ITEM: " << item.toString().substr(0, 100) << "..." << std::endl;
+                             }
+                         } else {
+                             xml += cv.toString();
                          }
-                     } else {
-                         xml += cv.toString();
                      }
-                 }
+                }
+                xml += "</" + jsx->tagName + ">";
             }
-            xml += "</" + jsx->tagName + ">";
+            return {xml, 0, false};
         }
-        return {xml, 0, false};
-    }
     
     // Objects/Arrays
-    if (auto obj = std::dynamic_pointer_cast<ObjectExpr>(expr)) {
-        std::map<std::string, Value> map;
-        for (auto const& prop : obj->properties) {
-            // Check if this is a spread property
-            if (prop.first.find("__spread_") == 0) {
-                if (auto spread = std::dynamic_pointer_cast<SpreadExpr>(prop.second)) {
-                    Value spreadVal = evaluate(spread->argument);
-                    // Merge spread object properties into current object
-                    if (!spreadVal.isInt && spreadVal.mapVal) {
-                        for (auto const& kv : *spreadVal.mapVal) {
-                            map[kv.first] = kv.second;
+        case ExprKind::Object: {
+            auto* obj = static_cast<ObjectExpr*>(expr);
+            std::map<std::string, Value> map;
+            for (auto const& prop : obj->properties) {
+                // Check if this is a spread property
+                if (prop.spread) {
+                    if (prop.value->kind == ExprKind::Spread) {
+                        auto* spread = static_cast<SpreadExpr*>(prop.value.get());
+                        Value spreadVal = evaluate(spread->argument.get());
+                        // Merge spread object properties into current object
+                        if (!spreadVal.isInt() && spreadVal.mapVal()) {
+                            for (auto const& kv : *spreadVal.mapVal()) {
+                                map[kv.first] = kv.second;
+                            }
                         }
                     }
+                } else {
+                    map[atomName(prop.key)] = evaluate(prop.value.get());
                 }
-            } else {
-                map[prop.first] = evaluate(prop.second);
             }
+            return Value(map);
         }
-        return Value(map);
-    }
-    if (auto arr = std::dynamic_pointer_cast<ArrayExpr>(expr)) {
-        std::vector<Value> list;
-        for (auto const& e : arr->elements) {
-            // Check if this is a spread expression
-            if (auto spread = std::dynamic_pointer_cast<SpreadExpr>(e)) {
-                Value spreadVal = evaluate(spread->argument);
-                if (spreadVal.isList && spreadVal.listVal) {
-                    // Spread the array elements
-                    for (auto& item : *spreadVal.listVal) {
-                        list.push_back(item);
+        case ExprKind::Array: {
+            auto* arr = static_cast<ArrayExpr*>(expr);
+            std::vector<Value> list;
+            for (auto const& e : arr->elements) {
+                // Check if this is a spread expression
+                if (e->kind == ExprKind::Spread) {
+                    auto* spread = static_cast<SpreadExpr*>(e.get());
+                    Value spreadVal = evaluate(spread->argument.get());
+                    if (spreadVal.isList() && spreadVal.listVal()) {
+                        // Spread the array elements
+                        for (auto& item : *spreadVal.listVal()) {
+                            list.push_back(item);
+                        }
+                    } else if (spreadVal.isMap() && spreadVal.mapVal()) {
+                        // Spread object (future: for object literals)
+                        Debugger::warning("Spread of objects in arrays not yet supported", "", 0);
                     }
-                } else if (spreadVal.isMap && spreadVal.mapVal) {
-                    // Spread object (future: for object literals)
-                    Debugger::warning("Spread of objects in arrays not yet supported", "", 0);
+                } else {
+                    list.push_back(evaluate(e.get()));
                 }
-            } else {
-                list.push_back(evaluate(e));
             }
+            return Value(list);
+        }
+        case ExprKind::Member: {
+            auto* mem = static_cast<MemberExpr*>(expr);
+            Value obj = evaluate(mem->object.get());
+            if (mem->computed) {
+                Value k = evaluate(mem->property.get());
+                return getMember(obj, k.toString());
+            }
+            return getMemberCached(obj, mem);
         }
-        return Value(list);
+        default:
+            break;
     }
-    if (auto mem = std::dynamic_pointer_cast<MemberExpr>(expr)) {
-        Value obj = evaluate(mem->object);
-        std::string key;
-        if (mem->computed) {
-            Value k = evaluate(mem->property);
-            key = k.toString();
-        } else {
-            if (auto lit = std::dynamic_pointer_cast<LiteralExpr>(mem->property)) key = lit->value;
+    return Value::number(0);
+}
+
+Value Interpreter::getMember(const Value& obj, const std::string& key, Atom atom) {
+    // DEBUG
+    // std::cout << "DEBUG: MemberExpr obj.isList()=" << obj.isList() << " key=" << key << " line=" << currentLine << std::endl;
+    
+    if (obj.isList() && obj.listVal()) {
+         if (key == "length") return Value::number((int)obj.listVal()->size());
+         
+         // Method read as a value: wrap the table entry with its receiver
+         if (BuiltinMethod method = findBuiltinMethod(obj, atom)) {
+             return Value([obj, method](Interpreter& interp, NativeArgs args) -> Value {
+                 return method(interp, obj, args);
+             });
+         }
+         
+         // Array Access
+         // Only an all-digit key is an index; one too long for an integer is out of range
+         if (isdigit((unsigned char)key[0])) {
+             char* end = nullptr;
+             errno = 0;
+             long long idx = std::strtoll(key.c_str(), &end, 10);
+             if (*end == '\0' && errno == 0 && (size_t)idx < obj.listVal()->size()) return (*obj.listVal())[idx];
+         }
+         return {"undefined", 0, false};
+    }
+    
+    if (obj.isMap() && obj.mapVal()) {
+        if (obj.mapVal()->count(key)) return (*obj.mapVal())[key];
+    }
+    
+    if (obj.isClass() && obj.classVal()) {
+        auto& statics = obj.classVal()->staticFields;
+        auto it = statics.find(atom);
+        if (it != statics.end()) return it->second;
+        return {"undefined", 0, false};
+    }
+    
+    if (obj.isInstance() && obj.instanceVal()) {
+         // Check getter first
+         Value getter = obj.instanceVal()->klass->findGetter(atom);
+         if (getter.isClosure()) return callGetter(obj, getter);
+         
+         Value val = obj.instanceVal()->get(atom);
+         // Methods come back bound to 'this', so `var m = obj.method; m();` works
+         if (val.isClosure()) return bindMethod(obj, val);
+         return val;
+    }
+    return {"undefined", 0, false};
+}
+
+Value Interpreter::setMember(const Value& obj, const std::string& key, Atom atom, const Value& val, int line) {
+    if (obj.isMap() && obj.mapVal()) {
+        (*obj.mapVal())[key] = val;
+        return val;
+    }
+    if (obj.isInstance() && obj.instanceVal()) {
+        // Check setter
+        Value setter = obj.instanceVal()->klass->findSetter(atom);
+        if (setter.isClosure()) {
+             callSetter(obj, setter, val);
+             return val;
         }
-        
-        // DEBUG
-        // std::cout << "DEBUG: MemberExpr obj.isList=" << obj.isList << " key=" << key << " line=" << currentLine << std::endl;
-        
-        // List Methods
-        if (obj.isList && obj.listVal) {
-             if (key == "length") return Value("", (int)obj.listVal->size(), true);
-             
-             if (key == "push") {
-                 Value method([obj](std::vector<Value> args) mutable -> Value {
-                     for(auto& a : args) obj.listVal->push_back(a);
-                     return Value("", (int)obj.listVal->size(), true);
-                 });
-                 method.isNative = true;
-                 return method;
-             }
-             
-             if (key == "filter") {
-                 Value method([obj, this](std::vector<Value> args) mutable -> Value {
-                     if (args.empty() || !args[0].isClosure) return Value(std::vector<Value>{});
-                     Value callback = args[0];
-                     std::vector<Value> result;
-                     for(auto& item : *obj.listVal) {
-                         Value ret = this->callClosure(callback, {item});
-                         if ((ret.isInt && ret.intVal != 0) || (!ret.isInt && !ret.strVal.empty())) {
-                             result.push_back(item);
-                         }
-                     }
-                     return Value(result);
-                 });
-                 method.isNative = true;
-                 return method;
-             }
-             
-             if (key == "map") {
-                 Value method([obj, this](std::vector<Value> args) mutable -> Value {
-                     if (args.empty() || !args[0].isClosure) return Value(std::vector<Value>{});
-                     Value callback = args[0];
-                     std::vector<Value> result;
-                     for(auto& item : *obj.listVal) {
-                         Value ret = this->callClosure(callback, {item});
-                         result.push_back(ret);
-                     }
-                     return Value(result);
-                 });
-                 method.isNative = true;
-                 return method;
-             }
+        obj.instanceVal()->set(atom != NoAtom ? atom : intern(key), val);
+        return val;
+    }
+    if (obj.isClass() && obj.classVal()) {
+        obj.classVal()->staticFields[atom != NoAtom ? atom : intern(key)] = val;
+        return val;
+    }
+    Debugger::runtimeError("Invalid assignment target.", line);
+    return Value::number(0);
+}
+
+Value Interpreter::callGetter(const Value& obj, const Value& getter) {
+    // Bind 'this'; a getter has no params
+    auto* body = static_cast<BlockStmt*>(getter.closureBody().get());
+    prepare(body, getter.closureParams());
+    auto boundEnv = Environment::make(getter.closureEnv(), body->locals);
+    boundEnv->define(atomThis, obj);
+    if (obj.instanceVal()->klass->superclass) {
+        boundEnv->define(atomSuper, Value(obj.instanceVal()->klass->superclass.get()));
+    }
+    
+    CallDepthGuard guard(*this, body);
+    Completion c = executeBlock(body, boundEnv);
+    if (hasTailCall) return completeTailCall();
+    return c == Completion::Return ? lastReturnValue : Value::undefined();
+}
+
+void Interpreter::callSetter(const Value& obj, const Value& setter, const Value& val) {
+    // Bind 'this'
+    auto* body = static_cast<BlockStmt*>(setter.closureBody().get());
+    prepare(body, setter.closureParams());
+    auto boundEnv = Environment::make(setter.closureEnv(), body->locals);
+    boundEnv->define(atomThis, obj);
+    if (obj.instanceVal()->klass->superclass) {
+        boundEnv->define(atomSuper, Value(obj.instanceVal()->klass->superclass.get()));
+    }
+    bindParams(setter.closureParams(), boundEnv, NativeArgs(&val, 1));
+    
+    CallDepthGuard guard(*this, body);
+    executeBlock(body, boundEnv);
+    if (hasTailCall) completeTailCall();
+}
+
+// Closure with an extra scope defining 'this' (and 'super'). With a cache, the binding kept
+// there is rebound instead when it is for the same method and nothing else refers to it.
+Value Interpreter::bindMethod(const Value& obj, const Value& method, InlineCache* cache) {
+    Class* superclass = obj.instanceVal()->klass->superclass.get();
+    if (cache && cache->binding.isClosure() && cache->binding.gcObject()->gcRefCount() == 1) {
+        const auto& env = cache->binding.closureEnv();
+        if (env.use_count() == 1 && env->enclosing == method.closureEnv() && cache->binding.closureBody() == method.closureBody()
+            && (superclass != nullptr) == (cache->bindingSuper != nullptr)) {
+            *cache->bindingThis = obj;
+            if (superclass) *cache->bindingSuper = Value(superclass);
+            return cache->binding;
         }
-        
-        if (obj.isMap && obj.mapVal) {
-            if (obj.mapVal->count(key)) return (*obj.mapVal)[key];
+    }
+    auto boundEnv = Environment::make(method.closureEnv());
+    boundEnv->define(atomThis, obj);
+    if (superclass) boundEnv->define(atomSuper, Value(superclass));
+    Value bound = method.withEnv(boundEnv);
+    if (cache) {
+        cache->binding = bound;
+        cache->bindingThis = &boundEnv->values[atomThis];
+        cache->bindingSuper = superclass ? &boundEnv->values[atomSuper] : nullptr;
+    }
+    return bound;
+}
+
+// After a call through the site: the binding kept for the next call stops holding the
+// receiver, or is let go if the call left other references to it (kept as a value,
+// captured by a closure, or still running further up the stack)
+void Interpreter::releaseBinding(InlineCache& cache) {
+    if (!cache.binding.isClosure()) return;
+    if (cache.binding.gcObject()->gcRefCount() == 1 && cache.binding.closureEnv().use_count() == 1) {
+        *cache.bindingThis = Value();
+    } else {
+        cache.binding = Value();
+    }
+}
+
+Value Interpreter::getMemberCached(const Value& obj, MemberExpr* site, bool callee) {
+    if (!obj.isInstance()) return getMember(obj, site->key);
+    
+    Instance* inst = obj.instanceVal();
+    if (!site->cache) site->cache.reset(new InlineCache());
+    InlineCache* cache = site->cache.get();
+    
+    InlineCache::Entry* entry = cache->find(inst->shape.get());
+    if (!entry) {
+        // Miss: resolve the name for this shape the way getMember() does, and remember it
+        entry = cache->add(inst->shape.get());
+        if (!entry) return getMember(obj, site->key);
+        const Value* getter = inst->klass->getterRef(site->key);
+        int slot = inst->shape->slotOf(site->key);
+        if (getter && getter->isClosure()) {
+            entry->kind = InlineCache::Getter;
+            entry->member = getter;
+        } else if (slot >= 0) {
+            entry->kind = InlineCache::Field;
+            entry->slot = slot;
+        } else {
+            const Value* method = inst->klass->methodRef(site->key);
+            entry->kind = method && method->isClosure() ? InlineCache::Method : InlineCache::Missing;
+            entry->member = method;
         }
-        
-        if (obj.isClass && obj.classVal) {
-            if (obj.classVal->staticFields.count(key)) return obj.classVal->staticFields[key];
-            return {"undefined", 0, false};
+    }
+    
+    InlineCache* reuse = callee ? cache : nullptr; // A binding returned as a value is not the cache's
+    switch (entry->kind) {
+        case InlineCache::Field: {
+            const Value& val = inst->slots[entry->slot];
+            if (val.isClosure()) return bindMethod(obj, val, reuse);
+            return val;
         }
-        
-        if (obj.isInstance && obj.instanceVal) {
-             // Check getter first
-             Value getter = obj.instanceVal->klass->findGetter(key);
-             if (getter.isClosure) {
-                 // Bind & Call
-                 // Bind 'this'
-                 auto boundEnv = std::make_shared<Environment>(getter.closureEnv);
-                 boundEnv->define("this", obj);
-                 if (obj.instanceVal->klass->superclass) {
-                     boundEnv->define("super", Value(obj.instanceVal->klass->superclass));
-                 }
-                 // Execute body. Getter has no params.
-                 Value ret = Value("undefined", 0, false);
-                 // We need to executeBlock and capture return value?
-                 // executeBlock returns void.
-                 // Interpreter::executeBlock handles ReturnStmt by throwing/setting flag?
-                 // Interpreter has `lastReturnValue`.
-                 
-                 // callClosure(getter, {})?
-                 // callClosure handles binding env? No.
-                 // callClosure handles return value capture!
-                 // But callClosure creates NEW env from closureEnv.
-                 // I need to create env with THIS bound.
-                 // So I duplicate callClosure logic or modify callClosure.
-                 
-                 // Since I am inside Interpreter, I can use helper.
-                 // Or executeBlock and check interpreter state.
-                 try {
-                     executeBlock(std::dynamic_pointer_cast<BlockStmt>(getter.closureBody), boundEnv);
-                 } catch (Value r) {
-                     // Value thrown as return (if implemented that way).
-                     // But Interpreter seems to set `isReturning` flag.
-                 }
-                 if (isReturning) {
-                     ret = lastReturnValue;
-                     isReturning = false;
-                 }
-                 return ret;
-             }
-             
-             Value val = obj.instanceVal->get(key);
-             // If val is a closure method from the class, we need to bind 'this'? 
-             // Ideally we bind it here using a specialized BoundMethod value or similar?
-             // OR we just rely on CallExpr logic to bind if strict.
-             // But implementing "closure binding" here allows: var m = obj.method; m(); working correctly.
-             if (val.isClosure && !val.isNative) { // Only bind user methods for now?
-                 // Create a bound closure?
-                 // Simple binding: Create a new Closure Value that wraps the original 
-                 // but has an environment where 'this' is defined.
-                 // This is expensive if done on every access.
-                 // Optimization: Only do it? 
-                 // Let's do it.
-                 auto boundEnv = std::make_shared<Environment>(val.closureEnv);
-                 boundEnv->define("this", obj);
-                 if (obj.instanceVal->klass->superclass) {
-                     boundEnv->define("super", Value(obj.instanceVal->klass->superclass));
-                 }
-                 Value boundMethod = val;
-                 boundMethod.closureEnv = boundEnv;
-                 return boundMethod;
-             }
-             return val;
+        case InlineCache::Method:
+            return bindMethod(obj, *entry->member, reuse);
+        case InlineCache::Getter:
+            return callGetter(obj, *entry->member);
+        default:
+            return Value::undefined();
+    }
+}
+
+Value Interpreter::setMemberCached(const Value& obj, MemberExpr* site, const Value& val, int line) {
+    if (!obj.isInstance()) return setMember(obj, atomName(site->key), site->key, val, line);
+    
+    Instance* inst = obj.instanceVal();
+    if (!site->cache) site->cache.reset(new InlineCache());
+    InlineCache* cache = site->cache.get();
+    
+    InlineCache::Entry* entry = cache->find(inst->shape.get());
+    if (!entry) {
+        entry = cache->add(inst->shape.get());
+        if (!entry) return setMember(obj, atomName(site->key), site->key, val, line);
+        const Value* setter = inst->klass->setterRef(site->key);
+        int slot = inst->shape->slotOf(site->key);
+        if (setter && setter->isClosure()) {
+            entry->kind = InlineCache::Setter;
+            entry->member = setter;
+        } else if (slot >= 0) {
+            entry->kind = InlineCache::Field;
+            entry->slot = slot;
+        } else {
+            entry->kind = InlineCache::AddField;
+            entry->nextShape = inst->shape->withField(site->key);
         }
-        if (obj.isList && obj.listVal) {
-             // Array Properties
-             if (key == "length") {
-                 return Value("", (int)obj.listVal->size(), true);
-             }
+    }
+    
+    switch (entry->kind) {
+        case InlineCache::Setter:
+            callSetter(obj, *entry->member, val);
+            break;
+        case InlineCache::Field:
+            inst->slots[entry->slot] = val;
+            break;
+        default:
+            inst->addField(entry->nextShape.get(), val);
+            break;
+    }
+    return val;
+}
 
-             // Array Methods
-             if (key == "map") {
-                 return Value([this, obj](std::vector<Value> args) -> Value {
-                     if (args.empty() || !args[0].isClosure) return Value(std::vector<Value>{});
-                     Value cb = args[0];
-                     std::vector<Value> res;
-                     for (auto& item : *obj.listVal) {
-                         // Call closure with item
-                         res.push_back(this->callClosure(cb, {item}));
-                     }
-                     return Value(res);
-                 });
-             }
-             if (key == "filter") {
-                 return Value([this, obj](std::vector<Value> args) -> Value {
-                     if (args.empty() || !args[0].isClosure) return Value(std::vector<Value>{});
-                     Value cb = args[0];
-                     std::vector<Value> res;
-                     for (auto& item : *obj.listVal) {
-                         Value ret = this->callClosure(cb, {item});
-                         bool keep = (ret.isInt && ret.intVal != 0) || (!ret.isInt && !ret.strVal.empty());
-                         if (keep) res.push_back(item);
-                     }
-                     return Value(res);
-                 });
+// `recv.name(args)` on a built-in receiver calls straight into the method table: then the
+// method is returned and `callee` holds the receiver
+BuiltinMethod Interpreter::evaluateCallee(CallExpr* call, Value& callee) {
+    if (call->callee->kind == ExprKind::Member && !static_cast<MemberExpr*>(call->callee.get())->computed) {
+        auto* mem = static_cast<MemberExpr*>(call->callee.get());
+        Value obj = evaluate(mem->object.get());
+        if (BuiltinMethod method = findBuiltinMethod(obj, mem->key)) {
+            callee = std::move(obj);
+            return method;
+        }
+        callee = getMemberCached(obj, mem, true);
+        return nullptr;
+    }
+    callee = evaluate(call->callee.get());
+    return nullptr;
+}
+
+Value Interpreter::callValue(const Value& callee, std::vector<Value>& args, const std::string& name) {
+    if (callee.isNative()) {
+        return callee.nativeFunc()(*this, args);
+    }
+    
+    if (callee.isClosure()) {
+         return callClosure(callee, args);
+    }
+    
+    std::string label = name.empty() ? "expression" : "'" + name + "'";
+    Debugger::runtimeError("Attempt to call non-function: " + label + " is " + callee.toString(), currentLine, sourceCode, currentFile);
+    return Value::number(0); // Unreachable
+}
+
+// Booleans never equal numbers (`true == 1` is false); ints and doubles compare by value
+static bool valuesEqual(const Value& l, const Value& r) {
+    if (l.isDouble() || r.isDouble()) {
+        if (!l.isNumber() || !r.isNumber() || l.getType() == ValueType::Bool || r.getType() == ValueType::Bool) return false;
+        return l.doubleVal() == r.doubleVal();
+    }
+    return (l.isInt() == r.isInt()) && (l.intVal() == r.intVal()) && (l.strVal() == r.strVal());
+}
+
+// Integer arithmetic stays int64 (division truncates, and dividing by zero gives 0); a double
+// operand or an overflowing result makes it floating point.
+Value Interpreter::binaryOp(OpCode op, const Value& l, const Value& r) {
+    if (l.getType() == ValueType::Int && r.getType() == ValueType::Int) {
+        Value out;
+        if (intBinaryOp(op, l.intVal(), r.intVal(), out)) return out;
+    }
+    switch (op) {
+        case OP_EQ:
+             return Value::number(valuesEqual(l, r) ? 1 : 0);
+        case OP_NE:
+             return Value::number(valuesEqual(l, r) ? 0 : 1);
+        case OP_LT:
+             if (l.isInt() && r.isInt()) return Value::number((l.intVal() < r.intVal()) ? 1 : 0);
+             if (l.isNumber() && r.isNumber()) return Value::number((l.doubleVal() < r.doubleVal()) ? 1 : 0);
+             return Value::number(0);
+        case OP_GT:
+             if (l.isInt() && r.isInt()) return Value::number((l.intVal() > r.intVal()) ? 1 : 0);
+             if (l.isNumber() && r.isNumber()) return Value::number((l.doubleVal() > r.doubleVal()) ? 1 : 0);
+             return Value::number(0);
+        case OP_LE:
+             if (l.isInt() && r.isInt()) return Value::number((l.intVal() <= r.intVal()) ? 1 : 0);
+             if (l.isNumber() && r.isNumber()) return Value::number((l.doubleVal() <= r.doubleVal()) ? 1 : 0);
+             return Value::number(0);
+        case OP_GE:
+             if (l.isInt() && r.isInt()) return Value::number((l.intVal() >= r.intVal()) ? 1 : 0);
+             if (l.isNumber() && r.isNumber()) return Value::number((l.doubleVal() >= r.doubleVal()) ? 1 : 0);
+             return Value::number(0);
+        case OP_ADD:
+             if (l.isInt() && r.isInt()) {
+                 int64_t res;
+                 if (!__builtin_add_overflow(l.intVal(), r.intVal(), &res)) return Value::number(res);
              }
-             if (key == "push") {
-                 return Value([obj](std::vector<Value> args) -> Value {
-                     for(auto& a : args) {
-                         obj.listVal->push_back(a);
-                     }
-                     return Value("", (int)obj.listVal->size(), true);
-                 });
+             if (l.isNumber() && r.isNumber()) return Value::real(l.doubleVal() + r.doubleVal());
+             return Value::concat(l, r);
+        case OP_SUB:
+             if (l.isInt() && r.isInt()) {
+                 int64_t res;
+                 if (!__builtin_sub_overflow(l.intVal(), r.intVal(), &res)) return Value::number(res);
              }
-             if (key == "pop") {
-                 return Value([obj](std::vector<Value> args) -> Value {
-                     if (obj.listVal->empty()) return {"undefined", 0, false};
-                     Value v = obj.listVal->back();
-                     obj.listVal->pop_back();
-                     return v;
-                 });
+             if (l.isNumber() && r.isNumber()) return Value::real(l.doubleVal() - r.doubleVal());
+             return Value::number(0);
+        case OP_MUL:
+             if (l.isInt() && r.isInt()) {
+                 int64_t res;
+                 if (!__builtin_mul_overflow(l.intVal(), r.intVal(), &res)) return Value::number(res);
              }
-             // Array Access
-             if (isdigit(key[0])) {
-                 int idx = std::stoi(key);
-                 if (idx >= 0 && idx < obj.listVal->size()) return (*obj.listVal)[idx];
+             if (l.isNumber() && r.isNumber()) return Value::real(l.doubleVal() * r.doubleVal());
+             return Value::number(0);
+        case OP_DIV:
+             if (l.isInt() && r.isInt()) {
+                 if (r.intVal() == 0) return Value::number(0);
+                 if (r.intVal() == -1 && l.intVal() == INT64_MIN) return Value::real(-l.doubleVal());
+                 return Value::number(l.intVal() / r.intVal());
              }
+             if (l.isNumber() && r.isNumber()) return Value::real(l.doubleVal() / r.doubleVal());
+             return Value::number(0);
+        default:
+             return Value::number(0);
+    }
+}
+
+Value Interpreter::errorValue(const std::string& name, const Value& message) {
+    std::map<std::string, Value> error;
+    error["name"] = Value(name, 0, false);
+    error["message"] = message;
+    error["toString"] = Value([message](Interpreter&, NativeArgs) -> Value {
+        return message;
+    });
+    return Value(error);
+}
+
+Value Interpreter::negate(const Value& v) {
+    if (v.isDouble()) return Value::real(-v.doubleVal());
+    if (!v.isInt()) return v;
+    if (v.intVal() == INT64_MIN) return Value::real(-v.doubleVal());
+    return Value::number(-v.intVal());
+}
+
+// Binds call arguments to the parameters' slots in a fresh call frame. Defaults are evaluated
+// in that frame, so they can refer to earlier parameters.
+void Interpreter::bindParams(const ParamList& params, const std::shared_ptr<Environment>& frame, NativeArgs args) {
+    if (!params) return;
+    auto bind = [&frame](const Param::Binding& b, const Value& v) {
+        if (b.slot >= 0) frame->slots[b.slot] = v;
+        else frame->define(b.atom, v);
+    };
+    for (size_t i = 0; i < params->size(); i++) {
+        const Param& param = (*params)[i];
+        if (param.kind == Param::Rest) {
+            std::vector<Value> rest;
+            for (size_t j = i; j < args.size(); j++) rest.push_back(args[j]);
+            bind(param.names[0], Value(rest));
+            break;
+        }
+        
+        Value arg = i < args.size() ? args[i] : Value::undefined();
+        if (param.defaultValue && arg.getType() == ValueType::Undefined) {
+            std::shared_ptr<Environment> saved = environment;
+            environment = frame;
+            arg = evaluate(param.defaultValue.get());
+            environment = saved;
+        }
+        
+        switch (param.kind) {
+            case Param::Object:
+                // Properties missing from the argument (or a non-object argument) stay undefined
+                if (auto* map = arg.mapVal()) {
+                    for (auto& b : param.names) {
+                        auto it = map->find(b.name);
+                        if (it != map->end()) bind(b, it->second);
+                    }
+                }
+                break;
+            case Param::Array:
+                if (auto* list = arg.listVal()) {
+                    for (size_t k = 0; k < param.names.size() && k < list->size(); k++) bind(param.names[k], (*list)[k]);
+                }
+                break;
+            default:
+                bind(param.names[0], arg);
+                break;
         }
-        return {"undefined", 0, false};
     }
+}
 
-    return {"", 0, true};
+void Interpreter::parseDeferred(BlockStmt* body, const ParamList& params) {
+    auto start = std::chrono::steady_clock::now();
+    std::string file = body->lazy->file;
+    size_t bytes = body->lazy->end - body->lazy->begin;
+    Parser::parseDeferred(*body);
+    Optimizer().optimize(body->statements);
+    Resolver(file).function(params, body);
+    if (ModuleCache::timing) {
+        ModuleCache::noteDeferredParse(bytes, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
 }
 
-// New method to replace callClosure logic properly
+// A body that ended in a tail call outside callClosure's loop (constructors, accessors,
+// executeClosure) makes the call here
+Value Interpreter::completeTailCall() {
+    hasTailCall = false;
+    Value callee = std::move(tailCallee);
+    std::vector<Value> args = std::move(tailArgs);
+    return callClosure(callee, std::move(args));
+}
+
+// Tail calls reuse this invocation: the pending callee gets a fresh frame in the same loop, so
+// `return f(...)` recursion runs in constant native stack
 Value Interpreter::callClosure(Value closure, std::vector<Value> args) {
-    if (!closure.isClosure || !closure.closureBody) return {"", 0, false};
+    if (closure.isNative()) return closure.nativeFunc()(*this, args);
+    if (!closure.isClosure() || !closure.closureBody()) return {"", 0, false};
     
-    if (auto block = std::dynamic_pointer_cast<BlockStmt>(closure.closureBody)) {
-        // Prepare Environment
-        std::shared_ptr<Environment> prev = environment;
+    CallDepthGuard guard(*this, closure.closureBody().get());
+    std::shared_ptr<Environment> prev = environment;
+    Value ret = Value::number(0);
+    while (closure.closureBody()->kind == StmtKind::Block) {
+        auto* block = static_cast<BlockStmt*>(closure.closureBody().get());
+        prepare(block, closure.closureParams());
         // Use captured env as parent, create new scope
-        if (closure.closureEnv) {
-            environment = std::make_shared<Environment>(closure.closureEnv);
+        if (closure.closureEnv()) {
+            environment = Environment::make(closure.closureEnv(), block->locals);
         } else {
             // Fallback (shouldn't happen if we capture correctly)
-            environment = std::make_shared<Environment>(globals); 
-        }
-        
-        // Bind Params
-        for (size_t i = 0; i < closure.closureParams.size() && i < args.size(); i++) {
-            std::string param = closure.closureParams[i];
-            // Check if this is a destructuring pattern
-            bool isDestruct = (param.length() > 12 && param.substr(0, 12) == "__destruct:{") || (param.front() == '{' && param.back() == '}');
-            if (isDestruct) {
-                // Extract property names form pattern
-                std::string pattern;
-                if (param.front() == '{') pattern = param.substr(1, param.length() - 2);
-                else pattern = param.substr(12, param.length() - 13);
-                
-                std::vector<std::string> props;
-                size_t start = 0;
-                size_t comma = pattern.find(',');
-                while (comma != std::string::npos) {
-                    props.push_back(pattern.substr(start, comma - start));
-                    start = comma + 1;
-                    comma = pattern.find(',', start);
-                }
-                if (start < pattern.length()) {
-                    props.push_back(pattern.substr(start));
-                }
-                
-                // Destructure the argument (should be an object)
-                Value arg = args[i];
-                if (arg.isMap && arg.mapVal) {
-                    for (auto& propName : props) {
-                        if (arg.mapVal->count(propName)) {
-                            environment->define(propName, (*arg.mapVal)[propName]);
-                        } else {
-                            environment->define(propName, Value("undefined", 0, false));
-                        }
-                    }
-                }
-            } else {
-                environment->define(param, args[i]);
-            }
+            environment = Environment::make(globals, block->locals); 
         }
         
-        isReturning = false;
-        executeBlock(block, environment); 
+        bindParams(closure.closureParams(), environment, args);
         
-        Value ret = {"", 0, true};
-        if (isReturning) ret = lastReturnValue;
-        isReturning = false;
+        Completion c = executeBlock(block, environment);
         
-        environment = prev; // Restore
-        return ret;
+        if (hasTailCall) {
+            hasTailCall = false;
+            closure = std::move(tailCallee);
+            args = std::move(tailArgs);
+            Debugger::replaceCall(closure.closureBody().get(), currentLine);
+            continue;
+        }
+        ret = c == Completion::Return ? lastReturnValue : Value{"", 0, true};
+        break;
     }
-    return {"", 0, true};
+    
+    environment = prev; // Restore
+    return ret;
 }
 
 void Interpreter::executeClosure(Value closure, std::vector<Value> args) {
-    if (!closure.isClosure || !closure.closureBody) return;
+    if (closure.isNative()) {
+        closure.nativeFunc()(*this, args);
+        return;
+    }
+    if (!closure.isClosure() || !closure.closureBody()) return;
     
-    if (auto block = std::dynamic_pointer_cast<BlockStmt>(closure.closureBody)) {
+    if (closure.closureBody()->kind == StmtKind::Block) {
+        auto* block = static_cast<BlockStmt*>(closure.closureBody().get());
+        prepare(block, closure.closureParams());
+        CallDepthGuard guard(*this, block);
         std::shared_ptr<Environment> prev = environment;
-        if (closure.closureEnv) {
-            environment = std::make_shared<Environment>(closure.closureEnv);
+        if (closure.closureEnv()) {
+            environment = Environment::make(closure.closureEnv(), block->locals);
         } else {
-            environment = std::make_shared<Environment>(globals);
+            environment = Environment::make(globals, block->locals);
         }
         
-        // Bind Params
-        for (size_t i = 0; i < closure.closureParams.size() && i < args.size(); i++) {
-            std::string param = closure.closureParams[i];
-            // Check if this is a destructuring pattern
-            if (param.length() > 12 && param.substr(0, 12) == "__destruct:{") {
-                // Extract property names from pattern
-                std::string pattern = param.substr(12, param.length() - 13);
-                std::vector<std::string> props;
-                size_t start = 0;
-                size_t comma = pattern.find(',');
-                while (comma != std::string::npos) {
-                    props.push_back(pattern.substr(start, comma - start));
-                    start = comma + 1;
-                    comma = pattern.find(',', start);
-                }
-                if (start < pattern.length()) {
-                    props.push_back(pattern.substr(start));
-                }
-                
-                // Destructure the argument
-                Value arg = args[i];
-                if (arg.isMap && arg.mapVal) {
-                    for (auto& propName : props) {
-                        if (arg.mapVal->count(propName)) {
-                            environment->define(propName, (*arg.mapVal)[propName]);
-                        } else {
-                            environment->define(propName, Value("undefined", 0, false));
-                        }
-                    }
-                }
-            } else {
-                environment->define(param, args[i]);
-            }
-        }
+        bindParams(closure.closureParams(), environment, args);
         
         executeBlock(block, environment);
+        if (hasTailCall) completeTailCall();
         
         environment = prev;
     }
@@ -1103,11 +1402,22 @@ void Interpreter::callFunction(std::string name) {
     // Deprecated
 }
 
-bool Interpreter::isTrue(Value v) const {
-    if (v.isInt) return v.intVal != 0;
-    if (v.isList && v.listVal) return true;
-    if (v.isMap && v.mapVal) return true;
-    if (v.strVal == "undefined" || v.strVal == "null" || v.strVal == "false" || v.strVal == "0") return false;
-    return !v.strVal.empty();
+bool Interpreter::isTrue(const Value& v) {
+    switch (v.getType()) {
+        case ValueType::Int:
+        case ValueType::Bool:
+            return v.intVal() != 0;
+        case ValueType::Double:
+            return v.isTruthy();
+        case ValueType::Undefined:
+        case ValueType::Null:
+            return false;
+        case ValueType::String: {
+            const std::string& s = v.strVal();
+            return !s.empty() && s != "false" && s != "0";
+        }
+        default:
+            return true; // Lists, maps, functions, classes and instances
+    }
 }
 
@@ -2,189 +2,189 @@
 #define ANIS_INTERPRETER_H
 
 #include "parser.h"
+#include "value.h"
+#include "frame_pool.h"
+#include "builtins.h"
+#include "debugger.h"
+#include "module_registry.h"
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <functional>
+#include <cstdint>
 
 // Forward Decl
 struct Environment;
 struct Class;
 struct Instance;
+struct Chunk;
+enum OpCode : uint8_t;
 
-struct Value {
-    std::string strVal;
-    int intVal;
-    bool isInt; 
-    bool isClosure = false;
-    std::shared_ptr<Stmt> closureBody; 
-    std::shared_ptr<Environment> closureEnv; // Captured scope
-    std::vector<std::string> closureParams; // Added params
-    
-    // List support (Reference Semantics)
-    std::shared_ptr<std::vector<Value>> listVal;
-    bool isList = false;
-
-    // Map/Object support (Reference Semantics)
-    std::shared_ptr<std::map<std::string, Value>> mapVal;
-    bool isMap = false;
-
-    // Native Function
-    using NativeFunc = std::function<Value(std::vector<Value>)>;
-    NativeFunc nativeFunc;
-    bool isNative = false;
-    
-    // Getter/Setter tagging
-    bool isGetter = false;
-    bool isSetter = false;
-    
-    // OOP support (Reference Semantics)
-    std::shared_ptr<Class> classVal;
-    bool isClass = false;
-    std::shared_ptr<Instance> instanceVal;
-    bool isInstance = false;
-    
-    std::string nativeId; // Stable identification for native closures
-    
-    Value(std::string s, int i, bool isI);
-    Value(std::shared_ptr<Stmt> body, std::shared_ptr<Environment> env = nullptr, std::vector<std::string> params = {});
-    Value(std::vector<Value> list);
-    Value(std::map<std::string, Value> map);
-    Value(NativeFunc func);
-    Value(std::shared_ptr<Class> c);
-    Value(std::shared_ptr<Instance> i);
-    Value();
-    
-    std::string toString() const;
-    std::string toJson() const;
-    
-    // Type safety helper methods
-    std::string getTypeName() const {
-        if (isInt) return "number";
-        if (isList) return "array";
-        if (isMap) return "object";
-        if (isClosure) return "function";
-        if (isNative) return "native function";
-        if (isClass) return "class";
-        if (isInstance) return "instance";
-        if (isGetter) return "getter";
-        if (isSetter) return "setter";
-        return "string";
-    }
-    
-    bool isCallable() const {
-        return isClosure || isNative;
-    }
-    
-    bool isTruthy() const {
-        if (isInt) return intVal != 0;
-        if (strVal == "false" || strVal == "null" || strVal == "undefined") return false;
-        if (isList && listVal) return !listVal->empty();
-        if (isMap && mapVal) return !mapVal->empty();
-        return !strVal.empty() || isClosure || isNative || isClass || isInstance;
-    }
+struct Environment : GcObject, std::enable_shared_from_this<Environment> {
+    // Resolved locals live in `slots`, indexed by the resolver (resolver.cpp).
+    // `values` holds names only known at runtime: globals, natives, this/super.
+    // Frames and their storage come from framePool (frame_pool.h); create them with make().
+    std::vector<Value, FrameAllocator<Value>> slots;
+    std::shared_ptr<std::vector<Atom>> slotNames; // Null for globals and method binding layers
+    std::unordered_map<Atom, Value, std::hash<Atom>, std::equal_to<Atom>, FrameAllocator<std::pair<const Atom, Value>>> values;
+    std::shared_ptr<Environment> enclosing;
     
-    bool isNullOrUndefined() const {
-        return (!isInt && (strVal == "null" || strVal == "undefined"));
+    template<typename... Args>
+    static std::shared_ptr<Environment> make(Args&&... args) {
+        return std::allocate_shared<Environment>(FrameAllocator<Environment>(), std::forward<Args>(args)...);
     }
     
-    // Safe accessors with defaults
-    int safeGetInt(int defaultVal = 0) const {
-        return isInt ? intVal : defaultVal;
-    }
+    Environment(std::shared_ptr<Environment> enc = nullptr) : enclosing(enc) {}
     
-    std::string safeGetString(const std::string& defaultVal = "") const {
-        return !isInt ? strVal : defaultVal;
+    // Frame for a resolved block scope
+    Environment(std::shared_ptr<Environment> enc, const std::shared_ptr<std::vector<Atom>>& names) 
+        : slotNames(names), enclosing(enc) {
+        if (names) slots.resize(names->size(), Value::undefined());
     }
     
-    // Safe list access
-    Value safeGetListItem(size_t index, const Value& defaultVal = Value("undefined", 0, false)) const {
-        if (isList && listVal && index < listVal->size()) {
-            return (*listVal)[index];
+    int slotOf(Atom name) const {
+        if (!slotNames) return -1;
+        for (size_t i = 0; i < slotNames->size(); i++) {
+            if ((*slotNames)[i] == name) return (int)i;
         }
-        return defaultVal;
+        return -1;
     }
     
-    // Safe map access
-    Value safeGetMapValue(const std::string& key, const Value& defaultVal = Value("undefined", 0, false)) const {
-        if (isMap && mapVal) {
-            auto it = mapVal->find(key);
-            if (it != mapVal->end()) {
-                return it->second;
-            }
+    // Frame `depth` scopes up; binding layers without slots are not counted
+    Environment* ancestor(int depth) {
+        Environment* env = this;
+        for (; depth > 0; depth--) {
+            env = env->enclosing.get();
+            while (!env->slotNames) env = env->enclosing.get();
         }
-        return defaultVal;
+        return env;
     }
     
-    // Check if value is a specific type
-    bool checkType(const std::string& expectedType) const {
-        return getTypeName() == expectedType;
-    }
-
-};
-
-struct Environment {
-    std::map<std::string, Value> values;
-    std::shared_ptr<Environment> enclosing;
-    
-    Environment(std::shared_ptr<Environment> enc = nullptr) : enclosing(enc) {}
-    
-    void define(std::string name, Value v) {
-        values[name] = v;
+    void define(Atom name, Value v) {
+        int slot = slotOf(name);
+        if (slot >= 0) slots[slot] = std::move(v);
+        else values[name] = std::move(v);
     }
     
     // Assign to nearest scope
-    void assign(std::string name, Value v) {
-        if (values.count(name)) {
-            values[name] = v;
-            return;
+    void assign(Atom name, Value v) {
+        for (Environment* env = this; env; env = env->enclosing.get()) {
+            int slot = env->slotOf(name);
+            if (slot >= 0) {
+                env->slots[slot] = std::move(v);
+                return;
+            }
+            auto it = env->values.find(name);
+            if (it != env->values.end()) {
+                it->second = std::move(v);
+                return;
+            }
         }
-        if (enclosing) enclosing->assign(name, v);
     }
     
     // Get from nearest scope
-    Value get(std::string name) {
-        if (values.count(name)) return values[name];
-        if (enclosing) return enclosing->get(name);
-        return {"undefined", 0, false};
+    Value get(Atom name) {
+        for (Environment* env = this; env; env = env->enclosing.get()) {
+            int slot = env->slotOf(name);
+            if (slot >= 0) return env->slots[slot];
+            auto it = env->values.find(name);
+            if (it != env->values.end()) return it->second;
+        }
+        return Value::undefined();
+    }
+    
+    void define(const std::string& name, Value v) { define(intern(name), std::move(v)); }
+    void assign(const std::string& name, Value v) { assign(intern(name), std::move(v)); }
+    Value get(const std::string& name) {
+        Atom atom = lookupAtom(name);
+        return atom != NoAtom ? get(atom) : Value::undefined();
     }
+    
+    // Cycle collection (gc.h): a closure and the scope it captured often reference each other
+    long gcRefCount() const override { return weak_from_this().use_count(); }
+    std::shared_ptr<void> gcPin() override { return shared_from_this(); }
+    size_t gcTraverse(GcVisitor visit, void* ctx) override;
+    void gcClear() override;
 };
 
 
-struct Class {
+struct Class : TrackedObject {
     std::string name;
-    std::shared_ptr<Class> superclass;
-    std::map<std::string, Value> methods;
-    std::map<std::string, Value> getters;
-    std::map<std::string, Value> setters;
-    std::map<std::string, Value> staticFields;
+    Ref<Class> superclass;
+    std::unordered_map<Atom, Value> methods;
+    std::unordered_map<Atom, Value> getters;
+    std::unordered_map<Atom, Value> setters;
+    std::unordered_map<Atom, Value> staticFields;
     std::map<std::string, std::shared_ptr<Expr>> instanceFields;
     std::vector<std::string> privateFieldNames;
+    Ref<Shape> rootShape; // Shape of a new instance, before any field is set
     
-    Class(std::string n, std::shared_ptr<Class> s = nullptr) : name(n), superclass(s) {}
-    Value findMethod(const std::string& name);
-    Value findGetter(const std::string& name);
-    Value findSetter(const std::string& name);
+    Class(std::string n, Ref<Class> s = nullptr) : name(n), superclass(s), rootShape(new Shape()) {}
+    Value findMethod(Atom name);
+    Value findGetter(Atom name);
+    Value findSetter(Atom name);
+    // Where findMethod() & co. find the member, or null. Stable: the tables are only filled
+    // while the class is declared.
+    const Value* methodRef(Atom name);
+    const Value* getterRef(Atom name);
+    const Value* setterRef(Atom name);
+    size_t gcTraverse(GcVisitor visit, void* ctx) override;
+    void gcClear() override;
 };
 
-struct Instance {
-    std::shared_ptr<Class> klass;
-    std::map<std::string, Value> fields;
-    std::map<std::string, Value> privateFields;
+struct Instance : TrackedObject {
+    Ref<Class> klass;
+    Ref<Shape> shape;         // Field names, one per slot (shape.h); private '#' fields included
+    std::vector<Value> slots;
+    
+    Instance(Ref<Class> k) : klass(k), shape(k->rootShape) {}
+    Value get(Atom name);
+    void set(Atom name, Value value);
     
-    Instance(std::shared_ptr<Class> k) : klass(k) {}
-    Value get(const std::string& name);
-    void set(const std::string& name, Value value);
+    // Append a field the current shape does not have yet
+    void addField(Shape* next, Value value) {
+        shape = next;
+        slots.push_back(std::move(value));
+    }
+    size_t gcTraverse(GcVisitor visit, void* ctx) override;
+    void gcClear() override;
 };
 
+inline Class* Value::classVal() const {
+    return isClass() ? static_cast<Class*>(as.obj) : nullptr;
+}
+
+inline Instance* Value::instanceVal() const {
+    return isInstance() ? static_cast<Instance*>(as.obj) : nullptr;
+}
+
+// How a statement finished. Statements hand this back up to the loop, switch or call that
+// consumes it, so straight-line code never tests a flag: Return leaves its value in
+// lastReturnValue, Break and Continue name their loop in completionLabel.
+enum class Completion : uint8_t { Normal, Return, Break, Continue };
+
 class Interpreter {
 public:
     std::shared_ptr<Environment> globals;
     std::shared_ptr<Environment> environment; // Current scope
     
-    std::map<std::string, std::function<Value(std::vector<Value>)>> natives;
+    std::map<std::string, Value::NativeCall> natives;
     
     Value lastReturnValue;
-    bool isReturning = false;
+    Atom completionLabel = NoAtom; // Target of the pending break/continue; NoAtom = innermost
+    
+    // `return f(args)` in tail position (ReturnStmt::tailCall) leaves the call here instead of
+    // making it; callClosure's loop then runs it in place of the returning frame
+    bool hasTailCall = false;
+    Value tailCallee;
+    std::vector<Value> tailArgs;
+    
+    // Nested script calls. Past maxCallDepth, or close to the end of the native stack the host
+    // registered with setNativeStack, a call throws a RangeError instead of overflowing.
+    int callDepth = 0;
+    int maxCallDepth = 100000;
+    static void setNativeStack(char* lowest, size_t size);
+    void enterCall(); // Throws the RangeError; paired with callDepth-- (see CallDepthGuard)
     
     Value lastExpressionValue;
     bool hasLastExpressionValue = false;
@@ -193,10 +193,16 @@ public:
     std::vector<Value> hooks;
     int hookIndex = 0;
      
-    std::string sourceCode; // For debug
+    std::string sourceCode; // For debug; the running module's
     std::string currentFile = "main.anis"; // Default
+    
+    ModuleRegistry modules; // Every script module loaded, each run once
     int currentLine = 0;
     
+    // Execution engine: compile blocks to bytecode (default) or walk the AST (--interp=ast)
+    bool useBytecode = true;
+    std::vector<Value> stack; // VM operand stack, shared by nested run() calls
+    
     void resetHooks() { hookIndex = 0; }
 
 public:
@@ -206,7 +212,8 @@ public:
 
     Interpreter();
     void interpret(const std::vector<std::shared_ptr<Stmt>>& statements);
-    void registerNative(std::string name, std::function<Value(std::vector<Value>)> func);
+    void registerNative(std::string name, Value::NativeCall func);
+    void registerNative(std::string name, Value::NativeFunc func); // Legacy signature, adapted
     
     // API for host
     Value getGlobal(std::string name);
@@ -214,12 +221,56 @@ public:
     Value callClosure(Value closure, std::vector<Value> args = {}); 
     void executeClosure(Value closure, std::vector<Value> args = {}); 
     
+    // Value semantics shared by the tree-walker, the bytecode VM and constant folding
+    static bool isTrue(const Value& v);
+    static Value binaryOp(OpCode op, const Value& l, const Value& r);
+    static Value negate(const Value& v);
+    // Script-visible error object: { name, message, toString() }
+    static Value errorValue(const std::string& name, const Value& message);
+    
 private:
-    void execute(std::shared_ptr<Stmt> stmt);
-    Value evaluate(std::shared_ptr<Expr> expr);
-    bool isTrue(Value v) const;
+    Completion execute(Stmt* stmt);
+    Value evaluate(Expr* expr);
+    
+    Completion executeBlock(BlockStmt* block, std::shared_ptr<Environment> env);
+    
+    // Parse a newly registered module (unless prefetch already did) and run its top level in
+    // the global scope, then fill in its exports
+    void loadModule(Module& module, bool parsed);
+    
+    // Member access and calls shared by the tree-walker and the bytecode VM
+    // `atom` is the interned key, or NoAtom for computed keys that never were (see atom.h)
+    Value getMember(const Value& obj, const std::string& key, Atom atom);
+    Value setMember(const Value& obj, const std::string& key, Atom atom, const Value& val, int line);
+    Value getMember(const Value& obj, Atom key) { return getMember(obj, atomName(key), key); }
+    Value getMember(const Value& obj, const std::string& key) { return getMember(obj, key, lookupAtom(key)); }
+    Value callValue(const Value& callee, std::vector<Value>& args, const std::string& name);
+    BuiltinMethod evaluateCallee(CallExpr* call, Value& callee);
+    Value completeTailCall();
+    void bindParams(const ParamList& params, const std::shared_ptr<Environment>& frame, NativeArgs args);
+    // Parses and resolves a function body the parser deferred (LazyBody), before its first run
+    void prepare(BlockStmt* body, const ParamList& params) {
+        if (body->lazy) parseDeferred(body, params);
+    }
+    void parseDeferred(BlockStmt* body, const ParamList& params);
+    
+    // Non-computed `obj.key` through the site's inline cache. For the callee of a call, a
+    // method binding kept in the cache may be reused; the call then ends with releaseBinding().
+    Value getMemberCached(const Value& obj, MemberExpr* site, bool callee = false);
+    Value setMemberCached(const Value& obj, MemberExpr* site, const Value& val, int line);
+    Value bindMethod(const Value& obj, const Value& method, InlineCache* cache = nullptr);
+    static void releaseBinding(InlineCache& cache);
+    // Releases the binding of the call through `cache` (if any) on every exit; declare it
+    // before the callee Value, so that is dropped first
+    struct BindingRelease {
+        InlineCache* cache;
+        ~BindingRelease() { if (cache) releaseBinding(*cache); }
+    };
+    Value callGetter(const Value& obj, const Value& getter);
+    void callSetter(const Value& obj, const Value& setter, const Value& val);
     
-    void executeBlock(std::shared_ptr<BlockStmt> block, std::shared_ptr<Environment> env);
+    // Bytecode VM (vm.cpp)
+    Completion run(Chunk& chunk);
 
 };
 
@@ -227,7 +278,7 @@ private:
 // Exception Support
 struct RuntimeError : public std::runtime_error {
     Value value; // The thrown value (can be string or Error object)
-    RuntimeError(Value v) : std::runtime_error(v.toString()), value(v) {}
+    RuntimeError(Value v) : std::runtime_error(v.toString()), value(v) { Debugger::captureThrownStack(); }
 };
 
 #endif
@@ -1,10 +1,108 @@
 #include "lexer.h"
+#include <algorithm>
 #include <cctype>
 #include <iostream>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+struct Keyword {
+    std::string_view text;
+    TokenType type = TOK_IDENTIFIER;
+};
+
+constexpr Keyword keywords[] = {
+    {"var", TOK_VAR}, {"if", TOK_IF}, {"for", TOK_FOR}, {"while", TOK_WHILE}, {"function", TOK_FUNCTION},
+    {"import", TOK_IMPORT}, {"from", TOK_FROM}, {"return", TOK_RETURN}, {"export", TOK_EXPORT},
+    {"switch", TOK_SWITCH}, {"case", TOK_CASE}, {"default", TOK_DEFAULT}, {"const", TOK_CONST},
+    {"else", TOK_ELSE}, {"class", TOK_CLASS}, {"new", TOK_NEW}, {"extends", TOK_EXTENDS},
+    {"super", TOK_SUPER}, {"static", TOK_STATIC}, {"this", TOK_THIS}, {"get", TOK_GET}, {"set", TOK_SET},
+    {"try", TOK_TRY}, {"catch", TOK_CATCH}, {"finally", TOK_FINALLY}, {"throw", TOK_THROW},
+    {"break", TOK_BREAK}, {"continue", TOK_CONTINUE},
+};
+
+// Perfect hash of the keywords above: no two share a slot, so a lookup is one hash and one
+// compare. Identifiers shorter than 2 or longer than 8 characters are never keywords.
+constexpr size_t KeywordSlots = 64;
+constexpr size_t keywordHash(std::string_view word) {
+    return ((unsigned char)word[0] + (unsigned char)word[1] * 13 + word.size() * 11) & (KeywordSlots - 1);
+}
+
+struct KeywordTable {
+    Keyword slots[KeywordSlots] = {};
+    bool perfect = true;
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table;
+    for (const Keyword& keyword : keywords) {
+        Keyword& slot = table.slots[keywordHash(keyword.text)];
+        if (!slot.text.empty()) table.perfect = false;
+        slot = keyword;
+    }
+    return table;
+}
+
+constexpr KeywordTable keywordTable = buildKeywordTable();
+static_assert(keywordTable.perfect, "Keyword hash collision: pick new constants for keywordHash");
+
+// Keywords get the table's static text, so their tokens never point into the source
+Token classify(std::string_view word, int line) {
+    if (word.size() >= 2 && word.size() <= 8) {
+        const Keyword& keyword = keywordTable.slots[keywordHash(word)];
+        if (keyword.text == word) return {keyword.type, keyword.text, line};
+    }
+    return {TOK_IDENTIFIER, word, line};
+}
+
+bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Length of the run of [A-Za-z0-9_] starting at `from`, 16 bytes at a time where SSE2 is there
+size_t identifierRun(std::string_view src, size_t from) {
+    size_t i = from;
+#if defined(__SSE2__)
+    for (; i + 16 <= src.size(); i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + i));
+        __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20)); // Bytes >= 0x80 stay negative: never in range
+        __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+        __m128i underscore = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), underscore));
+        if (mask != 0xFFFF) return i - from + __builtin_ctz(~mask);
+    }
+#endif
+    while (i < src.size() && isIdentifierChar(src[i])) i++;
+    return i - from;
+}
+
+// Length of the run of spaces starting at `from` (indentation)
+size_t spaceRun(std::string_view src, size_t from) {
+    size_t i = from;
+#if defined(__SSE2__)
+    for (; i + 16 <= src.size(); i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')));
+        if (mask != 0xFFFF) return i - from + __builtin_ctz(~mask);
+    }
+#endif
+    while (i < src.size() && src[i] == ' ') i++;
+    return i - from;
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+}
 
 std::vector<Token> Lexer::tokenize() {
     std::vector<Token> tokens;
-    auto addToken = [&](TokenType t, std::string text) {
+    tokens.reserve(src.size() / 5 + 1); // Typical density
+    auto addToken = [&](TokenType t, std::string_view text) {
         tokens.push_back({t, text, line});
     };
 
@@ -13,76 +111,38 @@ std::vector<Token> Lexer::tokenize() {
         if (c == '\n') {
             line++;
             advance();
-        } else if (isspace(c)) {
+        } else if (c == ' ') {
+            pos += spaceRun(src, pos);
+        } else if (isspace((unsigned char)c)) {
             advance();
-        } else if (isalpha(c) || c == '_') {
-            std::string ident;
-            while (isalnum(peek()) || peek() == '_') ident += advance();
-            
-            if (ident == "var") addToken(TOK_VAR, ident);
-            else if (ident == "if") addToken(TOK_IF, ident);
-            else if (ident == "for") addToken(TOK_FOR, ident);
-            else if (ident == "while") addToken(TOK_WHILE, ident);
-            else if (ident == "function") addToken(TOK_FUNCTION, ident);
-            else if (ident == "import") addToken(TOK_IMPORT, ident);
-            else if (ident == "from") addToken(TOK_FROM, ident);
-            else if (ident == "return") addToken(TOK_RETURN, ident);
-            else if (ident == "export") addToken(TOK_EXPORT, ident);
-            else if (ident == "switch") addToken(TOK_SWITCH, ident);
-            else if (ident == "case") addToken(TOK_CASE, ident);
-            else if (ident == "default") addToken(TOK_DEFAULT, ident);
-            else if (ident == "const") addToken(TOK_CONST, ident);
-            else if (ident == "else") addToken(TOK_ELSE, ident);
-            else if (ident == "class") addToken(TOK_CLASS, ident);
-            else if (ident == "new") addToken(TOK_NEW, ident);
-            else if (ident == "extends") addToken(TOK_EXTENDS, ident);
-            else if (ident == "super") addToken(TOK_SUPER, ident);
-            else if (ident == "static") addToken(TOK_STATIC, ident);
-            else if (ident == "this") addToken(TOK_THIS, ident);
-            else if (ident == "get") addToken(TOK_GET, ident);
-            else if (ident == "set") addToken(TOK_SET, ident);
-            else if (ident == "try") addToken(TOK_TRY, ident);
-            else if (ident == "catch") addToken(TOK_CATCH, ident);
-            else if (ident == "finally") addToken(TOK_FINALLY, ident);
-            else if (ident == "throw") addToken(TOK_THROW, ident);
-            else addToken(TOK_IDENTIFIER, ident);
-        } else if (isdigit(c)) {
-            // ...
-            std::string num;
-            while (isdigit(peek())) num += advance();
+        } else if (isalpha((unsigned char)c) || c == '_') {
+            size_t length = identifierRun(src, pos);
+            tokens.push_back(classify(src.substr(pos, length), line));
+            pos += length;
+        } else if (isDigit(c)) {
+            size_t start = pos;
+            while (isDigit(peek())) pos++;
             // check for float
-            if (peek() == '.' && pos + 1 < src.size() && isdigit(src[pos+1])) {
-                 num += advance(); // .
-                 while (isdigit(peek())) num += advance();
-            }
-            addToken(TOK_NUMBER, num);
-        } else if (c == '"') {
-             // ...
-             advance(); // skip opening
-            std::string str;
-            while (peek() != '"' && pos < src.size()) {
-                 str += advance();
-            }
-            advance(); // skip closing
-            addToken(TOK_STRING, str);
-        } else if (c == '`') {
-             // ...
-             advance(); // skip opening
-            std::string str;
-            while (peek() != '`' && pos < src.size()) {
-                 str += advance();
-            }
-            advance(); // skip closing
-            addToken(TOK_STRING, str);
-        } else if (c == '\'') {
-             // ...
-             advance(); // skip opening
-            std::string str;
-            while (peek() != '\'' && pos < src.size()) {
-                 str += advance();
-            }
-            advance(); // skip closing
-            addToken(TOK_STRING, str);
+            if (peek() == '.' && pos + 1 < src.size() && isDigit(src[pos+1])) {
+                 pos++; // .
+                 while (isDigit(peek())) pos++;
+            }
+            // Exponent (1e6, 2.5E-3)
+            if (peek() == 'e' || peek() == 'E') {
+                size_t digits = pos + 1;
+                if (digits < src.size() && (src[digits] == '+' || src[digits] == '-')) digits++;
+                if (digits < src.size() && isDigit(src[digits])) {
+                    pos = digits;
+                    while (isDigit(peek())) pos++;
+                }
+            }
+            addToken(TOK_NUMBER, src.substr(start, pos - start));
+        } else if (c == '"' || c == '`' || c == '\'') {
+            // No escapes: the literal is everything up to the same quote (or the end of the source)
+            size_t start = pos + 1;
+            size_t end = std::min(src.find(c, start), src.size());
+            addToken(TOK_STRING, src.substr(start, end - start));
+            pos = std::min(end + 1, src.size());
         } else {
             advance();
             if (c == '(') addToken(TOK_LPAREN, "(");
@@ -91,19 +151,12 @@ std::vector<Token> Lexer::tokenize() {
                  if (peek() == '*') {
                       // Multi-line comment {* ... *}
                       advance(); // skip *
-                      while (pos + 1 < src.size()) {
-                           if (src[pos] == '*' && src[pos+1] == '}') {
-                                pos += 2;
-                                break;
-                           }
-                           if (src[pos] == '\n') line++; // Track newlines in comments
-                           pos++;
-                      }
+                      skipBlockComment('}');
                  } else {
-                      addToken(TOK_LBRACE, "{");
+                      addToken(TOK_LBRACE, src.substr(pos - 1, 1));
                  }
             }
-            else if (c == '}') addToken(TOK_RBRACE, "}");
+            else if (c == '}') addToken(TOK_RBRACE, src.substr(pos - 1, 1));
             else if (c == '[') addToken(TOK_LBRACKET, "[");
             else if (c == ']') addToken(TOK_RBRACKET, "]");
             else if (c == ';') addToken(TOK_SEMICOLON, ";");
@@ -121,9 +174,9 @@ std::vector<Token> Lexer::tokenize() {
             else if (c == '#') {
                  // Private identifier #field
                  // advance() already consumed '#'
-                 std::string ident = "#";
-                 while (isalnum(peek()) || peek() == '_') ident += advance();
-                 addToken(TOK_PRIVATE_IDENTIFIER, ident);
+                 size_t length = identifierRun(src, pos);
+                 addToken(TOK_PRIVATE_IDENTIFIER, src.substr(pos - 1, length + 1));
+                 pos += length;
             }
             else if (c == '+') {
                  if (peek() == '=') { advance(); addToken(TOK_PLUS_EQUAL, "+="); }
@@ -143,19 +196,12 @@ std::vector<Token> Lexer::tokenize() {
             else if (c == '/') {
                  if (peek() == '/') {
                       // Comment //
-                      while (peek() != '\n' && pos < src.size()) advance();
+                      pos = std::min(src.find('\n', pos), src.size());
                  } 
                  else if (peek() == '*') {
                       // Comment /* ... */
                       advance(); // skip *
-                      while (pos + 1 < src.size()) {
-                           if (src[pos] == '*' && src[pos+1] == '/') {
-                                pos += 2;
-                                break;
-                           }
-                           if (src[pos] == '\n') line++; // Track newlines
-                           pos++;
-                      }
+                      skipBlockComment('/');
                  }
                  else {
                       addToken(TOK_SLASH, "/");
@@ -192,3 +238,11 @@ char Lexer::advance() {
     if (pos >= src.size()) return 0;
     return src[pos++];
 }
+
+// Newlines inside the comment still count; an unterminated comment runs to the end
+void Lexer::skipBlockComment(char close) {
+    const char terminator[] = {'*', close};
+    size_t end = std::min(src.find(std::string_view(terminator, 2), pos), src.size());
+    line += (int)std::count(src.begin() + pos, src.begin() + end, '\n');
+    pos = std::min(end + 2, src.size());
+}
@@ -2,21 +2,24 @@
 #define ANIS_LEXER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include "token.h"
 
+// Tokens point into `source`, which must outlive them: keep it until the tokens are parsed.
+// So do brace tokens, which is how the parser finds where a function body starts and ends.
 class Lexer {
-    std::string src;
+    std::string_view src;
     size_t pos = 0;
-    int line = 1;
+    int line;
 public:
-    Lexer(const std::string& source) : src(source) {}
+    // `firstLine`: the line `source` starts on, when it is a slice of a larger file
+    Lexer(std::string_view source, int firstLine = 1) : src(source), line(firstLine) {}
     std::vector<Token> tokenize();
 private:
     char peek();
     char advance();
-    bool match(char expected);
-    void skipWhitespace();
+    void skipBlockComment(char close); // After "/*" or "{*", up to "*/" or "*}"
 };
 
 #endif
@@ -0,0 +1,840 @@
+#include "module_cache.h"
+#include "lexer.h"
+#include "debugger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Bump whenever the AST or the encoding below changes
+const uint32_t FormatVersion = 4;
+const char Magic[8] = {'A', 'N', 'I', 'S', 'C', '\0', '\0', '\0'};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t sourceHash;
+};
+
+const uint8_t NullNode = 0xFF;
+
+uint64_t hashSource(const std::string& source) {
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    for (unsigned char c : source) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Encoding: node kind byte (NullNode for a missing child), line, then the node's fields in
+// declaration order. Integers are LEB128 varints, strings are length-prefixed.
+class Writer {
+public:
+    explicit Writer(std::string& o) : out(o) {}
+
+    void statements(const std::vector<std::shared_ptr<Stmt>>& list) {
+        varint(list.size());
+        for (auto& s : list) stmt(s.get());
+    }
+
+private:
+    std::string& out;
+
+    void u8(uint8_t v) { out.push_back((char)v); }
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((char)v);
+    }
+    void str(const std::string& s) {
+        varint(s.size());
+        out.append(s);
+    }
+    void label(Atom atom) { str(atom == NoAtom ? std::string() : atomName(atom)); }
+
+    void exprs(const std::vector<std::shared_ptr<Expr>>& list) {
+        varint(list.size());
+        for (auto& e : list) expr(e.get());
+    }
+
+    void params(const ParamList& list) {
+        if (!list) {
+            u8(0);
+            return;
+        }
+        u8(1);
+        varint(list->size());
+        for (auto& p : *list) {
+            u8(p.kind);
+            varint(p.names.size());
+            for (auto& b : p.names) str(b.name);
+            expr(p.defaultValue.get());
+        }
+    }
+
+    void expr(Expr* e) {
+        if (!e) {
+            u8(NullNode);
+            return;
+        }
+        u8((uint8_t)e->kind);
+        varint((uint32_t)e->line);
+        switch (e->kind) {
+            case ExprKind::Literal: {
+                auto* lit = static_cast<LiteralExpr*>(e);
+                str(lit->value);
+                u8(lit->isString);
+                break;
+            }
+            case ExprKind::Var:
+                str(static_cast<VarExpr*>(e)->name);
+                break;
+            case ExprKind::Call: {
+                auto* call = static_cast<CallExpr*>(e);
+                expr(call->callee.get());
+                exprs(call->args);
+                break;
+            }
+            case ExprKind::Member: {
+                auto* mem = static_cast<MemberExpr*>(e);
+                expr(mem->object.get());
+                expr(mem->property.get());
+                u8(mem->computed);
+                break;
+            }
+            case ExprKind::Object: {
+                auto* obj = static_cast<ObjectExpr*>(e);
+                varint(obj->properties.size());
+                for (auto& prop : obj->properties) {
+                    str(atomName(prop.key));
+                    expr(prop.value.get());
+                }
+                break;
+            }
+            case ExprKind::Array:
+                exprs(static_cast<ArrayExpr*>(e)->elements);
+                break;
+            case ExprKind::Spread:
+                expr(static_cast<SpreadExpr*>(e)->argument.get());
+                break;
+            case ExprKind::This:
+                break;
+            case ExprKind::Super: {
+                auto* sup = static_cast<SuperExpr*>(e);
+                varint(sup->keyword.type); // Its text is always "super"
+                varint((uint32_t)sup->keyword.line);
+                expr(sup->property.get());
+                break;
+            }
+            case ExprKind::New: {
+                auto* n = static_cast<NewExpr*>(e);
+                str(n->className);
+                exprs(n->args);
+                break;
+            }
+            case ExprKind::Unary: {
+                auto* unary = static_cast<UnaryExpr*>(e);
+                u8((uint8_t)unary->op);
+                expr(unary->right.get());
+                break;
+            }
+            case ExprKind::Binary: {
+                auto* bin = static_cast<BinaryExpr*>(e);
+                expr(bin->left.get());
+                u8((uint8_t)bin->op);
+                expr(bin->right.get());
+                break;
+            }
+            case ExprKind::Ternary: {
+                auto* ternary = static_cast<TernaryExpr*>(e);
+                expr(ternary->condition.get());
+                expr(ternary->trueExpr.get());
+                expr(ternary->falseExpr.get());
+                break;
+            }
+            case ExprKind::Jsx: {
+                auto* jsx = static_cast<JsxExpr*>(e);
+                str(jsx->tagName);
+                varint(jsx->attributes.size());
+                for (auto& attr : jsx->attributes) {
+                    str(attr.first);
+                    expr(attr.second.get());
+                }
+                exprs(jsx->children);
+                break;
+            }
+            case ExprKind::Function: {
+                auto* fn = static_cast<FunctionExpr*>(e);
+                params(fn->params);
+                stmt(fn->body.get());
+                break;
+            }
+        }
+    }
+
+    void stmt(Stmt* s) {
+        if (!s) {
+            u8(NullNode);
+            return;
+        }
+        u8((uint8_t)s->kind);
+        varint((uint32_t)s->line);
+        switch (s->kind) {
+            case StmtKind::Block: {
+                // A body the parser deferred is stored as its place in the source
+                auto* block = static_cast<BlockStmt*>(s);
+                u8(block->lazy != nullptr);
+                if (block->lazy) {
+                    varint(block->lazy->begin);
+                    varint(block->lazy->end);
+                    varint((uint32_t)block->lazy->line);
+                } else {
+                    statements(block->statements);
+                }
+                break;
+            }
+            case StmtKind::VarDecl: {
+                auto* varDecl = static_cast<VarDeclStmt*>(s);
+                str(varDecl->name);
+                expr(varDecl->initializer.get());
+                break;
+            }
+            case StmtKind::If: {
+                auto* ifStmt = static_cast<IfStmt*>(s);
+                expr(ifStmt->condition.get());
+                stmt(ifStmt->thenBranch.get());
+                stmt(ifStmt->elseBranch.get());
+                break;
+            }
+            case StmtKind::While: {
+                auto* whileStmt = static_cast<WhileStmt*>(s);
+                expr(whileStmt->condition.get());
+                stmt(whileStmt->body.get());
+                label(whileStmt->label);
+                break;
+            }
+            case StmtKind::Switch: {
+                auto* switchStmt = static_cast<SwitchStmt*>(s);
+                expr(switchStmt->condition.get());
+                varint(switchStmt->cases.size());
+                for (auto& cs : switchStmt->cases) {
+                    expr(cs.value.get());
+                    stmt(cs.body.get());
+                }
+                break;
+            }
+            case StmtKind::FuncDecl: {
+                auto* funcDecl = static_cast<FuncDeclStmt*>(s);
+                str(funcDecl->name);
+                params(funcDecl->params);
+                stmt(funcDecl->body.get());
+                break;
+            }
+            case StmtKind::Return:
+                expr(static_cast<ReturnStmt*>(s)->value.get());
+                break;
+            case StmtKind::Import: {
+                auto* imp = static_cast<ImportStmt*>(s);
+                str(imp->moduleName);
+                varint(imp->symbols.size());
+                for (auto& sym : imp->symbols) str(sym);
+                break;
+            }
+            case StmtKind::Destructure: {
+                auto* dest = static_cast<DestructureStmt*>(s);
+                varint(dest->names.size());
+                for (auto& n : dest->names) str(n);
+                expr(dest->initializer.get());
+                break;
+            }
+            case StmtKind::Export:
+                stmt(static_cast<ExportStmt*>(s)->declaration.get());
+                break;
+            case StmtKind::Expr:
+                expr(static_cast<ExprStmt*>(s)->expr.get());
+                break;
+            case StmtKind::Class: {
+                auto* classStmt = static_cast<ClassStmt*>(s);
+                str(classStmt->name);
+                str(classStmt->superclass);
+                varint(classStmt->methods.size());
+                for (auto& m : classStmt->methods) {
+                    str(m.name);
+                    params(m.params);
+                    stmt(m.body.get());
+                    u8(m.isStatic | m.isGetter << 1 | m.isSetter << 2 | m.isPrivate << 3);
+                }
+                varint(classStmt->fields.size());
+                for (auto& f : classStmt->fields) {
+                    str(f.name);
+                    expr(f.initializer.get());
+                    u8(f.isStatic | f.isPrivate << 1);
+                }
+                break;
+            }
+            case StmtKind::Try: {
+                auto* tryStmt = static_cast<TryStmt*>(s);
+                stmt(tryStmt->tryBlock.get());
+                stmt(tryStmt->catchBlock.get());
+                stmt(tryStmt->finallyBlock.get());
+                str(tryStmt->catchVar);
+                break;
+            }
+            case StmtKind::Throw:
+                expr(static_cast<ThrowStmt*>(s)->expression.get());
+                break;
+            case StmtKind::Break:
+            case StmtKind::Continue:
+                label(static_cast<JumpStmt*>(s)->label);
+                break;
+        }
+    }
+};
+
+struct Malformed : std::runtime_error {
+    Malformed() : std::runtime_error("malformed module cache") {}
+};
+
+class Reader {
+public:
+    // `text`: the module source, for the bodies stored as a place in it; null if there is none
+    Reader(const char* data, size_t size, const std::string* text) : pos(data), end(data + size), text(text) {}
+    Reader(const Reader&) = delete;
+    ~Reader() { arena->release(); }
+
+    std::vector<std::shared_ptr<Stmt>> statements() {
+        std::vector<std::shared_ptr<Stmt>> list(count());
+        for (auto& s : list) s = stmt();
+        return list;
+    }
+
+    bool atEnd() const { return pos == end; }
+
+    size_t deferredBodies = 0;
+    size_t deferredBytes = 0;
+
+private:
+    const char* pos;
+    const char* end;
+    const std::string* text;
+    std::shared_ptr<const std::string> source; // Copy of `text`, made for the first deferred body
+    AstArena* arena = AstArena::create(); // Nodes of this module, as the parser allocates them
+
+    uint8_t u8() {
+        if (pos >= end) throw Malformed();
+        return (uint8_t)*pos++;
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = u8();
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw Malformed();
+    }
+    // A length no larger than the bytes left, so corrupt input cannot request huge allocations
+    size_t count() {
+        uint64_t n = varint();
+        if (n > (uint64_t)(end - pos)) throw Malformed();
+        return (size_t)n;
+    }
+    std::string str() {
+        size_t n = count();
+        std::string s(pos, n);
+        pos += n;
+        return s;
+    }
+    Atom label() {
+        std::string s = str();
+        return s.empty() ? NoAtom : intern(s);
+    }
+
+    std::vector<std::shared_ptr<Expr>> exprs() {
+        std::vector<std::shared_ptr<Expr>> list(count());
+        for (auto& e : list) e = expr();
+        return list;
+    }
+
+    std::shared_ptr<BlockStmt> block() {
+        std::shared_ptr<Stmt> s = stmt();
+        if (s && s->kind != StmtKind::Block) throw Malformed();
+        return std::static_pointer_cast<BlockStmt>(s);
+    }
+
+    ParamList params() {
+        if (!u8()) return nullptr;
+        auto list = std::make_shared<std::vector<Param>>(count());
+        for (auto& p : *list) {
+            uint8_t kind = u8();
+            if (kind > Param::Rest) throw Malformed();
+            p.kind = (Param::Kind)kind;
+            p.names.resize(count());
+            for (auto& b : p.names) {
+                b.name = str();
+                b.atom = intern(b.name);
+            }
+            p.defaultValue = expr();
+        }
+        return list;
+    }
+
+    std::shared_ptr<Expr> expr() {
+        uint8_t kind = u8();
+        if (kind == NullNode) return nullptr;
+        int line = (int)varint();
+        std::shared_ptr<Expr> e;
+        switch ((ExprKind)kind) {
+            case ExprKind::Literal: {
+                std::string value = str();
+                bool isString = u8();
+                e = makeNode<LiteralExpr>(arena, value, isString);
+                break;
+            }
+            case ExprKind::Var:
+                e = makeNode<VarExpr>(arena, str());
+                break;
+            case ExprKind::Call: {
+                auto callee = expr();
+                e = makeNode<CallExpr>(arena, callee, exprs());
+                break;
+            }
+            case ExprKind::Member: {
+                auto object = expr();
+                auto property = expr();
+                if (!property) throw Malformed();
+                e = makeNode<MemberExpr>(arena, object, property, u8() != 0);
+                break;
+            }
+            case ExprKind::Object: {
+                std::vector<std::pair<std::string, std::shared_ptr<Expr>>> props(count());
+                for (auto& [key, value] : props) {
+                    key = str();
+                    value = expr();
+                }
+                e = makeNode<ObjectExpr>(arena, std::move(props));
+                break;
+            }
+            case ExprKind::Array:
+                e = makeNode<ArrayExpr>(arena, exprs());
+                break;
+            case ExprKind::Spread:
+                e = makeNode<SpreadExpr>(arena, expr());
+                break;
+            case ExprKind::This:
+                e = makeNode<ThisExpr>(arena);
+                break;
+            case ExprKind::Super: {
+                Token keyword;
+                keyword.type = (TokenType)varint();
+                keyword.text = "super";
+                keyword.line = (int)varint();
+                e = makeNode<SuperExpr>(arena, keyword, expr());
+                break;
+            }
+            case ExprKind::New: {
+                std::string className = str();
+                e = makeNode<NewExpr>(arena, className, exprs());
+                break;
+            }
+            case ExprKind::Unary: {
+                uint8_t op = u8();
+                if (op > (uint8_t)UnaryOp::Neg) throw Malformed();
+                e = makeNode<UnaryExpr>(arena, (UnaryOp)op, expr());
+                break;
+            }
+            case ExprKind::Binary: {
+                auto left = expr();
+                uint8_t op = u8();
+                if (op > (uint8_t)BinaryOp::Div) throw Malformed();
+                e = makeNode<BinaryExpr>(arena, left, (BinaryOp)op, expr());
+                break;
+            }
+            case ExprKind::Ternary: {
+                auto condition = expr();
+                auto trueExpr = expr();
+                e = makeNode<TernaryExpr>(arena, condition, trueExpr, expr());
+                break;
+            }
+            case ExprKind::Jsx: {
+                std::string tagName = str();
+                std::map<std::string, std::shared_ptr<Expr>> attrs;
+                size_t n = count();
+                for (size_t i = 0; i < n; i++) {
+                    std::string name = str();
+                    attrs[name] = expr();
+                }
+                e = makeNode<JsxExpr>(arena, tagName, attrs, exprs());
+                break;
+            }
+            case ExprKind::Function: {
+                ParamList p = params();
+                e = makeNode<FunctionExpr>(arena, p, block());
+                break;
+            }
+            default:
+                throw Malformed();
+        }
+        e->line = line;
+        return e;
+    }
+
+    std::shared_ptr<Stmt> stmt() {
+        uint8_t kind = u8();
+        if (kind == NullNode) return nullptr;
+        int line = (int)varint();
+        std::shared_ptr<Stmt> s;
+        switch ((StmtKind)kind) {
+            case StmtKind::Block: {
+                auto b = makeNode<BlockStmt>(arena);
+                if (u8()) {
+                    size_t begin = (size_t)varint();
+                    size_t bodyEnd = (size_t)varint();
+                    int bodyLine = (int)varint();
+                    if (!text || begin >= bodyEnd || bodyEnd > text->size() || (*text)[begin] != '{' || (*text)[bodyEnd - 1] != '}') {
+                        throw Malformed();
+                    }
+                    if (!source) source = std::make_shared<const std::string>(*text);
+                    b->lazy.reset(new LazyBody{source, arena, begin, bodyEnd, bodyLine, ""});
+                    deferredBodies++;
+                    deferredBytes += bodyEnd - begin;
+                } else {
+                    b->statements = statements();
+                }
+                s = b;
+                break;
+            }
+            case StmtKind::VarDecl: {
+                std::string name = str();
+                s = makeNode<VarDeclStmt>(arena, name, expr());
+                break;
+            }
+            case StmtKind::If: {
+                auto condition = expr();
+                auto thenBranch = stmt();
+                s = makeNode<IfStmt>(arena, condition, thenBranch, stmt());
+                break;
+            }
+            case StmtKind::While: {
+                auto condition = expr();
+                auto loop = makeNode<WhileStmt>(arena, condition, stmt());
+                loop->label = label();
+                s = loop;
+                break;
+            }
+            case StmtKind::Switch: {
+                auto condition = expr();
+                std::vector<Case> cases(count());
+                for (auto& cs : cases) {
+                    cs.value = expr();
+                    cs.body = stmt();
+                }
+                s = makeNode<SwitchStmt>(arena, condition, cases);
+                break;
+            }
+            case StmtKind::FuncDecl: {
+                std::string name = str();
+                ParamList p = params();
+                s = makeNode<FuncDeclStmt>(arena, name, p, block());
+                break;
+            }
+            case StmtKind::Return:
+                s = makeNode<ReturnStmt>(arena, expr());
+                break;
+            case StmtKind::Import: {
+                std::string moduleName = str();
+                std::vector<std::string> symbols(count());
+                for (auto& sym : symbols) sym = str();
+                s = makeNode<ImportStmt>(arena, moduleName, symbols);
+                break;
+            }
+            case StmtKind::Destructure: {
+                std::vector<std::string> names(count());
+                for (auto& n : names) n = str();
+                s = makeNode<DestructureStmt>(arena, names, expr());
+                break;
+            }
+            case StmtKind::Export:
+                s = makeNode<ExportStmt>(arena, stmt());
+                break;
+            case StmtKind::Expr:
+                s = makeNode<ExprStmt>(arena, expr());
+                break;
+            case StmtKind::Class: {
+                std::string name = str();
+                auto classStmt = makeNode<ClassStmt>(arena, name, str());
+                classStmt->methods.resize(count());
+                for (auto& m : classStmt->methods) {
+                    m.name = str();
+                    m.params = params();
+                    m.body = block();
+                    uint8_t flags = u8();
+                    m.isStatic = flags & 1;
+                    m.isGetter = flags & 2;
+                    m.isSetter = flags & 4;
+                    m.isPrivate = flags & 8;
+                }
+                classStmt->fields.resize(count());
+                for (auto& f : classStmt->fields) {
+                    f.name = str();
+                    f.initializer = expr();
+                    uint8_t flags = u8();
+                    f.isStatic = flags & 1;
+                    f.isPrivate = flags & 2;
+                }
+                s = classStmt;
+                break;
+            }
+            case StmtKind::Try: {
+                auto tryBlock = block();
+                auto catchBlock = block();
+                auto finallyBlock = block();
+                if (!tryBlock) throw Malformed();
+                s = makeNode<TryStmt>(arena, tryBlock, catchBlock, finallyBlock, str());
+                break;
+            }
+            case StmtKind::Throw:
+                s = makeNode<ThrowStmt>(arena, expr());
+                break;
+            case StmtKind::Break:
+            case StmtKind::Continue:
+                s = makeNode<JumpStmt>(arena, (StmtKind)kind, label());
+                break;
+            default:
+                throw Malformed();
+        }
+        s->line = line;
+        return s;
+    }
+};
+
+// Startup instrumentation
+using Clock = std::chrono::steady_clock;
+const Clock::time_point processStart = Clock::now(); // Static initialisation: close enough
+
+struct ModuleLoad {
+    std::string path;
+    const char* how;  // "cache", "parsed", ...
+    double cacheMs;   // Checking and reading (or writing) the .anisc
+    double lexMs;
+    double parseMs;
+    size_t sourceBytes = 0;
+    size_t deferredBodies = 0; // Function bodies left to parse on first call (LazyBody)
+    size_t deferredBytes = 0;
+};
+std::vector<ModuleLoad> loads;
+std::mutex loadsMutex; // Modules are also parsed on the prefetch threads
+
+// Deferred bodies parsed since, all on the interpreter thread
+size_t lateBodies = 0;
+size_t lateBytes = 0;
+double lateMs = 0;
+
+void record(const ModuleLoad& load) {
+    std::lock_guard<std::mutex> lock(loadsMutex);
+    loads.push_back(load);
+}
+double scriptStartMs = -1;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::string cachePathFor(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos && path.substr(dot) == ".anis") return path + "c";
+    return path + ".anisc";
+}
+
+// Statements from the binary form; `load` (if any) gets the deferred body counts
+bool decode(const char* data, size_t size, const std::string* source, std::vector<std::shared_ptr<Stmt>>& statements, ModuleLoad* load) {
+    try {
+        Reader reader(data, size, source);
+        statements = reader.statements();
+        if (load) {
+            load->deferredBodies = reader.deferredBodies;
+            load->deferredBytes = reader.deferredBytes;
+        }
+        return reader.atEnd();
+    } catch (const Malformed&) {
+        return false;
+    }
+}
+
+// The cached statements if `cachePath` holds an entry for exactly this source
+bool loadEntry(const std::string& cachePath, const Header& expected, const std::string& source,
+               std::vector<std::shared_ptr<Stmt>>& statements, ModuleLoad& load) {
+#ifndef _WIN32
+    int fd = open(cachePath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+    const char* data = static_cast<const char*>(mapped);
+#else
+    std::ifstream in(cachePath, std::ios::binary);
+    if (!in) return false;
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t size = contents.size();
+    const char* data = contents.data();
+#endif
+    bool ok = size >= sizeof(Header) && std::memcmp(data, &expected, sizeof(Header)) == 0 &&
+              decode(data + sizeof(Header), size - sizeof(Header), &source, statements, &load);
+#ifndef _WIN32
+    munmap(mapped, size);
+#endif
+    return ok;
+}
+
+// Written beside the source through a temporary file, so readers never see half an entry.
+// Failures (read-only directory, full disk) just leave the module uncached.
+void storeEntry(const std::string& cachePath, const Header& header, const std::vector<std::shared_ptr<Stmt>>& statements) {
+    std::string data(reinterpret_cast<const char*>(&header), sizeof(Header));
+    ModuleCache::serialize(statements, data);
+    std::string tmpPath = cachePath + ".tmp" + std::to_string(Clock::now().time_since_epoch().count());
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out.write(data.data(), (std::streamsize)data.size());
+        if (!out) {
+            out.close();
+            std::remove(tmpPath.c_str());
+            return;
+        }
+    }
+    std::remove(cachePath.c_str()); // rename() does not replace on Windows
+    if (std::rename(tmpPath.c_str(), cachePath.c_str()) != 0) std::remove(tmpPath.c_str());
+}
+
+} // namespace
+
+void ModuleCache::serialize(const std::vector<std::shared_ptr<Stmt>>& statements, std::string& out) {
+    Writer(out).statements(statements);
+}
+
+bool ModuleCache::deserialize(const char* data, size_t size, std::vector<std::shared_ptr<Stmt>>& statements, const std::string* source) {
+    return decode(data, size, source, statements, nullptr);
+}
+
+std::vector<std::shared_ptr<Stmt>> ModuleCache::parse(const std::string& path, const std::string& source) {
+    ModuleLoad load{path, "parsed", 0, 0, 0, source.size()};
+    std::vector<std::shared_ptr<Stmt>> statements;
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = FormatVersion;
+    header.sourceSize = source.size();
+    struct stat st;
+    bool cacheable = mode != Mode::Off && stat(path.c_str(), &st) == 0;
+    std::string cachePath = cachePathFor(path);
+
+    if (cacheable) {
+        auto start = Clock::now();
+        header.sourceMtime = (int64_t)st.st_mtime;
+        header.sourceHash = hashSource(source);
+        bool hit = mode == Mode::Use && loadEntry(cachePath, header, source, statements, load);
+        load.cacheMs = msSince(start);
+        if (hit) {
+            load.how = "cache";
+            if (timing) record(load);
+            return statements;
+        }
+    }
+
+    // The source outlives this call: deferred function bodies are parsed from it later
+    auto text = std::make_shared<const std::string>(source);
+    auto start = Clock::now();
+    Lexer lexer(*text);
+    std::vector<Token> tokens = lexer.tokenize();
+    load.lexMs = msSince(start);
+    start = Clock::now();
+    Parser parser(std::move(tokens), text);
+    statements = parser.parse();
+    load.parseMs = msSince(start);
+    load.deferredBodies = parser.deferredBodies;
+    load.deferredBytes = parser.deferredBytes;
+
+    // A REPL import, or a prefetch, may have parsed past errors
+    if (cacheable && !Debugger::isReplMode && Debugger::deferredParseErrors == 0) {
+        start = Clock::now();
+        storeEntry(cachePath, header, statements);
+        load.cacheMs += msSince(start);
+        load.how = mode == Mode::Rebuild ? "rebuilt" : "parsed, cached";
+    }
+    if (timing) record(load);
+    return statements;
+}
+
+void ModuleCache::noteScriptStart() {
+    if (scriptStartMs < 0) scriptStartMs = msSince(processStart);
+}
+
+void ModuleCache::noteDeferredParse(size_t bytes, double ms) {
+    lateBodies++;
+    lateBytes += bytes;
+    lateMs += ms;
+}
+
+void ModuleCache::reportTiming() {
+    if (!timing) return;
+    double total = 0;
+    size_t deferredBodies = 0, deferredBytes = 0, eagerBytes = 0;
+    double eagerParseMs = 0;
+    std::cerr << "Startup timing:" << std::endl;
+    for (auto& load : loads) {
+        double ms = load.cacheMs + load.lexMs + load.parseMs;
+        total += ms;
+        deferredBodies += load.deferredBodies;
+        deferredBytes += load.deferredBytes;
+        if (load.parseMs > 0) {
+            eagerParseMs += load.parseMs;
+            eagerBytes += load.sourceBytes - load.deferredBytes;
+        }
+        char line[512];
+        std::snprintf(line, sizeof(line), "  %8.2f ms  %-15s %s  (cache %.2f, lex %.2f, parse %.2f; %zu function bodies deferred)",
+                      ms, load.how, load.path.c_str(), load.cacheMs, load.lexMs, load.parseMs, load.deferredBodies);
+        std::cerr << line << std::endl;
+    }
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %8.2f ms  loading %zu module(s)", total, loads.size());
+    std::cerr << line << std::endl;
+    if (scriptStartMs >= 0) {
+        std::snprintf(line, sizeof(line), "  %8.2f ms  process start to main script running", scriptStartMs);
+        std::cerr << line << std::endl;
+    }
+    if (deferredBodies > 0) {
+        // Bodies still unparsed, at the rate deferred bodies parsed at (or else whole modules did)
+        double msPerByte = lateBytes > 0 ? lateMs / lateBytes : eagerBytes > 0 ? eagerParseMs / eagerBytes : 0;
+        std::snprintf(line, sizeof(line), "  %8.2f ms  parsing %zu deferred function bodies on first call",
+                      lateMs, lateBodies);
+        std::cerr << line << std::endl;
+        std::snprintf(line, sizeof(line), "  %8.2f ms  parse time saved (estimated): %zu of %zu deferred bodies (%zu of %zu bytes) never parsed",
+                      (deferredBytes - lateBytes) * msPerByte, deferredBodies - lateBodies, deferredBodies,
+                      deferredBytes - lateBytes, deferredBytes);
+        std::cerr << line << std::endl;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef ANIS_MODULE_CACHE_H
+#define ANIS_MODULE_CACHE_H
+
+#include "parser.h"
+#include <vector>
+#include <string>
+#include <memory>
+
+// Parsed modules cached on disk. Next to each script the first run writes a `.anisc` file
+// (main.anis -> main.anisc) holding its AST in a compact binary form; later runs map that file
+// and rebuild the tree from it instead of lexing and parsing the source. An entry is used only
+// when the source's size, mtime and content hash all match the ones it was written for and its
+// format version is current; anything else is parsed again and the entry rewritten.
+// Resolver and optimizer annotations are not stored: they are recomputed on every run. Function
+// bodies the parser deferred are stored as their place in the source, and parsed from it.
+class ModuleCache {
+public:
+    enum class Mode { Use, Off, Rebuild }; // Default, --no-cache, --rebuild-cache
+    static inline Mode mode = Mode::Use;
+    static inline bool timing = false;     // --startup-timing
+
+    // Statements of the module at `path` (as opened) whose text is `source`
+    static std::vector<std::shared_ptr<Stmt>> parse(const std::string& path, const std::string& source);
+
+    // The binary form on its own (no header), and back. deserialize() returns false on any
+    // malformed input, leaving `statements` unspecified. Deferred bodies need the `source`
+    // they were parsed from.
+    static void serialize(const std::vector<std::shared_ptr<Stmt>>& statements, std::string& out);
+    static bool deserialize(const char* data, size_t size, std::vector<std::shared_ptr<Stmt>>& statements,
+                            const std::string* source = nullptr);
+
+    // Startup instrumentation: mark the point the main script starts running, then print how
+    // long each module took to load (and how) and the time from process start to that point.
+    // Function bodies parsed on first call are noted too, and the report estimates the parse
+    // time the ones never called saved.
+    static void noteScriptStart();
+    static void noteDeferredParse(size_t bytes, double ms);
+    static void reportTiming();
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "module_registry.h"
+#include "module_cache.h"
+#include "lexer.h"
+#include "debugger.h"
+#include "../../lib/http/http_lib.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+extern std::string g_basePath;
+
+namespace {
+
+bool isUrl(const std::string& name) {
+    return name.compare(0, 7, "http://") == 0 || name.compare(0, 8, "https://") == 0;
+}
+
+// Ids of local files are absolute and normalized, so "./a.anis" from the main script and
+// "../a.anis" from a view name the same module. The file need not exist yet.
+std::string canonicalPath(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+    if (ec) canonical = std::filesystem::absolute(path, ec).lexically_normal();
+    return ec ? path : canonical.generic_string();
+}
+
+// Base for relative imports: the id up to and including its last '/'
+std::string directoryOf(const std::string& id) {
+    size_t lastSlash = id.find_last_of('/');
+    return lastSlash == std::string::npos ? "" : id.substr(0, lastSlash + 1);
+}
+
+std::string resolveIn(const std::string& name, const std::string& base) {
+    std::string path = name;
+    // User requested .anis extension, support .s (legacy) and .anis
+    if (path.find('.') == std::string::npos && path.find("://") == std::string::npos) path += ".anis";
+    if (isUrl(path)) return path;
+    
+    if (!path.empty() && path[0] == '.') {
+        if (path.compare(0, 2, "./") == 0) path = path.substr(2);
+        path = base + path;
+        if (isUrl(path)) return path; // Relative to a remote module: the server resolves "../"
+    }
+    return canonicalPath(path);
+}
+
+// One prefetch job, on a pool thread. False if there is no such local file; a failed fetch
+// keeps its empty source, so the import reports it without fetching again.
+bool readAndParse(const std::string& id, PrefetchedModule& module) {
+    bool remote = isUrl(id);
+    if (remote) {
+        module.source = HTTPLib::fetch("GET", id);
+        if (module.source.empty()) return true;
+    } else {
+        std::ifstream file(id);
+        if (!file.is_open()) return false;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        module.source = buffer.str();
+    }
+    
+    Debugger::deferredParseErrors = 0;
+    try {
+        if (remote) {
+            Lexer lexer(module.source);
+            auto tokens = lexer.tokenize();
+            module.statements = Parser(std::move(tokens)).parse();
+        } else {
+            module.statements = ModuleCache::parse(id, module.source);
+        }
+        module.parsed = Debugger::deferredParseErrors == 0;
+    } catch (...) {
+        module.parsed = false;
+    }
+    if (!module.parsed) module.statements.clear();
+    return true;
+}
+
+}
+
+Module& ModuleRegistry::addMain(const std::string& path, const std::string& source) {
+    Module& main = add(canonicalPath(path));
+    main.source = source;
+    current = &main;
+    return main;
+}
+
+std::string ModuleRegistry::resolve(const std::string& name, const Module* importer) const {
+    return resolveIn(name, importer ? importer->directory : g_basePath);
+}
+
+bool ModuleRegistry::isBuiltin(const std::string& name) {
+    static const char* const builtins[] = {
+        "gui", "math", "string", "array", "map", "db", "webserver", "fs", "os", "exec", "regex", "json", "http"
+    };
+    return std::find(std::begin(builtins), std::end(builtins), name) != std::end(builtins);
+}
+
+void ModuleRegistry::prefetch(const Module& root, const std::vector<std::shared_ptr<Stmt>>& statements) {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::string> queue;
+    std::unordered_set<std::string> seen{root.id};
+    int busy = 0;
+    
+    // Imports are top-level statements only. Called with `mutex` held.
+    auto discover = [&](const std::vector<std::shared_ptr<Stmt>>& stmts, const std::string& directory) {
+        for (auto& stmt : stmts) {
+            if (!stmt || stmt->kind != StmtKind::Import) continue;
+            const std::string& name = static_cast<ImportStmt*>(stmt.get())->moduleName;
+            if (isBuiltin(name)) continue;
+            std::string id = resolveIn(name, directory);
+            if (seen.insert(id).second) queue.push_back(std::move(id));
+        }
+    };
+    discover(statements, root.directory);
+    if (queue.empty()) return;
+    
+    // One thread per queued import, up to `cap`; workers add threads as they find more imports.
+    // Mostly waiting on disk and network, so more threads than cores still help.
+    const size_t cap = std::clamp(std::thread::hardware_concurrency(), 8u, 16u);
+    std::vector<std::thread> pool; // Guarded by `mutex`
+    std::function<void()> worker;
+    auto grow = [&] { // Called with `mutex` held
+        while (pool.size() < cap && pool.size() - (size_t)busy < queue.size()) pool.emplace_back(worker);
+    };
+    
+    worker = [&] {
+        Debugger::deferParseErrors = true;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] { return !queue.empty() || busy == 0; });
+            if (queue.empty()) break; // And no job left that could add to it
+            std::string id = std::move(queue.front());
+            queue.pop_front();
+            busy++;
+            lock.unlock();
+            
+            PrefetchedModule module;
+            bool found = readAndParse(id, module);
+            
+            lock.lock();
+            busy--;
+            if (found) {
+                discover(module.statements, directoryOf(id));
+                prefetched[id] = std::move(module);
+                grow();
+            }
+            wake.notify_all();
+        }
+    };
+    
+    setAtomsConcurrent(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        grow();
+    }
+    // Once the threads started so far are done, none is left to start another
+    for (size_t i = 0;; i++) {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (i == pool.size()) break;
+            thread = std::move(pool[i]);
+        }
+        thread.join();
+    }
+    setAtomsConcurrent(false);
+}
+
+bool ModuleRegistry::takePrefetched(const std::string& id, PrefetchedModule& module) {
+    auto it = prefetched.find(id);
+    if (it == prefetched.end()) return false;
+    module = std::move(it->second);
+    prefetched.erase(it);
+    return true;
+}
+
+Module* ModuleRegistry::find(const std::string& id) const {
+    auto it = modules.find(id);
+    return it != modules.end() ? it->second.get() : nullptr;
+}
+
+Module& ModuleRegistry::add(const std::string& id) {
+    auto& slot = modules[id];
+    if (!slot) {
+        slot = std::make_unique<Module>();
+        slot->id = id;
+        slot->directory = directoryOf(id);
+        slot->exports = Value(std::map<std::string, Value>{});
+        order.push_back(slot.get());
+    }
+    return *slot;
+}
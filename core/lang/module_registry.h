@@ -0,0 +1,65 @@
+#ifndef ANIS_MODULE_REGISTRY_H
+#define ANIS_MODULE_REGISTRY_H
+
+#include "parser.h"
+#include "value.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+// A script module: the main script, an imported file or a remote URL. Each one is loaded and run
+// once per process; importing it again only binds names from its exports.
+struct Module {
+    enum class State { Loading, Loaded };
+
+    std::string id;        // Canonical file path or URL; the registry key
+    std::string directory; // What the module's own relative imports resolve against
+    std::string source;    // For error reports
+    std::vector<std::shared_ptr<Stmt>> statements; // Kept alive: closures point into the tree
+    Value exports;         // Map of exported name -> value, filled once the module has run
+    std::vector<Module*> dependencies; // Modules it imports, in the order first imported
+    State state = State::Loading;
+
+    bool isRemote() const { return id.compare(0, 7, "http://") == 0 || id.compare(0, 8, "https://") == 0; }
+};
+
+// Source and tree of a module read ahead of its import (ModuleRegistry::prefetch)
+struct PrefetchedModule {
+    std::string source;
+    std::vector<std::shared_ptr<Stmt>> statements;
+    bool parsed = false; // False after parse errors: the import parses it again to report them
+};
+
+class ModuleRegistry {
+public:
+    // The main script, registered by the host before it runs so importing it back is a no-op
+    Module& addMain(const std::string& path, const std::string& source);
+
+    // Id of `name` as imported from `importer` (null: the main script or the REPL, which
+    // resolve against g_basePath). Only names starting with '.' are relative; a name without
+    // an extension gets ".anis".
+    std::string resolve(const std::string& name, const Module* importer) const;
+    static bool isBuiltin(const std::string& name); // "gui", "math", ...: natives, no file
+    
+    // Before the main script runs, read (or fetch) and parse every module reachable through
+    // imports from `statements`, on a pool of threads, so a cold start waits for the slowest
+    // module rather than the sum of them. Nothing runs early: each module still runs when its
+    // import statement is reached, in the same order as without prefetching.
+    void prefetch(const Module& root, const std::vector<std::shared_ptr<Stmt>>& statements);
+    // Hands over what prefetch() read for `id`; false if it has nothing for it
+    bool takePrefetched(const std::string& id, PrefetchedModule& module);
+
+    Module* find(const std::string& id) const;
+    Module& add(const std::string& id);
+
+    Module* current = nullptr; // Module whose top level is running
+    const std::vector<Module*>& loadOrder() const { return order; }
+
+private:
+    std::unordered_map<std::string, std::unique_ptr<Module>> modules;
+    std::vector<Module*> order;
+    std::unordered_map<std::string, PrefetchedModule> prefetched;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "optimizer.h"
+#include "interpreter.h"
+#include "bytecode.h"
+
+// Literal value if `expr` is a decoded constant, else nullptr
+static const Value* constantOf(const std::shared_ptr<Expr>& expr) {
+    if (!expr || expr->kind != ExprKind::Literal) return nullptr;
+    auto* lit = static_cast<LiteralExpr*>(expr.get());
+    return lit->decoded ? &lit->constant : nullptr;
+}
+
+static std::shared_ptr<Expr> folded(const Value& v, int line) {
+    auto lit = std::make_shared<LiteralExpr>(v);
+    lit->line = line;
+    return lit;
+}
+
+void Optimizer::optimize(const std::vector<std::shared_ptr<Stmt>>& statements) {
+    for (auto& s : statements) {
+        if (s) statement(s.get());
+    }
+}
+
+void Optimizer::block(BlockStmt* block) {
+    if (!block) return;
+    for (auto& s : block->statements) {
+        if (s) statement(s.get());
+    }
+}
+
+void Optimizer::params(const ParamList& params) {
+    if (!params) return;
+    for (auto& p : *params) {
+        if (p.defaultValue) expression(p.defaultValue);
+    }
+}
+
+void Optimizer::statement(Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::Block:
+            block(static_cast<BlockStmt*>(stmt));
+            break;
+        case StmtKind::VarDecl: {
+            auto* varDecl = static_cast<VarDeclStmt*>(stmt);
+            if (varDecl->initializer) expression(varDecl->initializer);
+            break;
+        }
+        case StmtKind::If: {
+            auto* ifStmt = static_cast<IfStmt*>(stmt);
+            expression(ifStmt->condition);
+            if (ifStmt->thenBranch) statement(ifStmt->thenBranch.get());
+            if (ifStmt->elseBranch) statement(ifStmt->elseBranch.get());
+            break;
+        }
+        case StmtKind::While: {
+            auto* whileStmt = static_cast<WhileStmt*>(stmt);
+            expression(whileStmt->condition);
+            if (whileStmt->body) statement(whileStmt->body.get());
+            break;
+        }
+        case StmtKind::Switch: {
+            auto* switchStmt = static_cast<SwitchStmt*>(stmt);
+            expression(switchStmt->condition);
+            for (auto& cs : switchStmt->cases) {
+                if (cs.value) expression(cs.value);
+                if (cs.body) statement(cs.body.get());
+            }
+            break;
+        }
+        case StmtKind::FuncDecl: {
+            auto* funcDecl = static_cast<FuncDeclStmt*>(stmt);
+            params(funcDecl->params);
+            block(funcDecl->body.get());
+            break;
+        }
+        case StmtKind::Return: {
+            auto* ret = static_cast<ReturnStmt*>(stmt);
+            if (ret->value) expression(ret->value);
+            break;
+        }
+        case StmtKind::Destructure:
+            expression(static_cast<DestructureStmt*>(stmt)->initializer);
+            break;
+        case StmtKind::Export:
+            statement(static_cast<ExportStmt*>(stmt)->declaration.get());
+            break;
+        case StmtKind::Expr:
+            expression(static_cast<ExprStmt*>(stmt)->expr);
+            break;
+        case StmtKind::Class: {
+            auto* classStmt = static_cast<ClassStmt*>(stmt);
+            for (auto& m : classStmt->methods) {
+                params(m.params);
+                block(m.body.get());
+            }
+            for (auto& f : classStmt->fields) {
+                if (f.initializer) expression(f.initializer);
+            }
+            break;
+        }
+        case StmtKind::Try: {
+            auto* tryStmt = static_cast<TryStmt*>(stmt);
+            block(tryStmt->tryBlock.get());
+            block(tryStmt->catchBlock.get());
+            block(tryStmt->finallyBlock.get());
+            break;
+        }
+        case StmtKind::Throw:
+            expression(static_cast<ThrowStmt*>(stmt)->expression);
+            break;
+        case StmtKind::Import:
+        case StmtKind::Break:
+        case StmtKind::Continue:
+            break;
+    }
+}
+
+void Optimizer::expression(std::shared_ptr<Expr>& expr) {
+    if (!expr) return;
+    switch (expr->kind) {
+        case ExprKind::Literal: {
+            auto* lit = static_cast<LiteralExpr*>(expr.get());
+            if (lit->decoded) break;
+            if (lit->isString) {
+                lit->constant = Value(lit->value, 0, false);
+                lit->decoded = true;
+                break;
+            }
+            lit->constant = Value::parseNumber(lit->value);
+            lit->decoded = true;
+            break;
+        }
+        case ExprKind::Call: {
+            auto* call = static_cast<CallExpr*>(expr.get());
+            expression(call->callee);
+            for (auto& a : call->args) expression(a);
+            break;
+        }
+        case ExprKind::Member: {
+            auto* mem = static_cast<MemberExpr*>(expr.get());
+            expression(mem->object);
+            if (mem->computed) expression(mem->property);
+            break;
+        }
+        case ExprKind::Object:
+            for (auto& prop : static_cast<ObjectExpr*>(expr.get())->properties) expression(prop.value);
+            break;
+        case ExprKind::Array:
+            for (auto& e : static_cast<ArrayExpr*>(expr.get())->elements) expression(e);
+            break;
+        case ExprKind::Spread:
+            expression(static_cast<SpreadExpr*>(expr.get())->argument);
+            break;
+        case ExprKind::New:
+            for (auto& a : static_cast<NewExpr*>(expr.get())->args) expression(a);
+            break;
+        case ExprKind::Jsx: {
+            auto* jsx = static_cast<JsxExpr*>(expr.get());
+            for (auto& attr : jsx->attributes) expression(attr.second);
+            for (auto& c : jsx->children) expression(c);
+            break;
+        }
+        case ExprKind::Function:
+            params(static_cast<FunctionExpr*>(expr.get())->params);
+            block(static_cast<FunctionExpr*>(expr.get())->body.get());
+            break;
+        case ExprKind::Unary: {
+            auto* unary = static_cast<UnaryExpr*>(expr.get());
+            expression(unary->right);
+            const Value* right = constantOf(unary->right);
+            if (!right) break;
+            if (unary->op == UnaryOp::Not) expr = folded(Value::number(!Interpreter::isTrue(*right) ? 1 : 0), unary->line);
+            else if (right->isNumber()) expr = folded(Interpreter::negate(*right), unary->line);
+            else expr = unary->right;
+            break;
+        }
+        case ExprKind::Binary: {
+            auto* bin = static_cast<BinaryExpr*>(expr.get());
+            if (bin->op == BinaryOp::Assign || bin->op == BinaryOp::AddAssign) {
+                if (bin->left->kind == ExprKind::Member) expression(bin->left);
+                expression(bin->right);
+                break;
+            }
+            expression(bin->left);
+            expression(bin->right);
+            const Value* l = constantOf(bin->left);
+            if (!l) break;
+            if (bin->op == BinaryOp::And) {
+                expr = Interpreter::isTrue(*l) ? bin->right : bin->left;
+                break;
+            }
+            if (bin->op == BinaryOp::Or) {
+                expr = Interpreter::isTrue(*l) ? bin->left : bin->right;
+                break;
+            }
+            const Value* r = constantOf(bin->right);
+            if (r) expr = folded(Interpreter::binaryOp(opCodeFor(bin->op), *l, *r), bin->line);
+            break;
+        }
+        case ExprKind::Ternary: {
+            auto* ternary = static_cast<TernaryExpr*>(expr.get());
+            expression(ternary->condition);
+            expression(ternary->trueExpr);
+            expression(ternary->falseExpr);
+            const Value* cond = constantOf(ternary->condition);
+            if (cond) expr = Interpreter::isTrue(*cond) ? ternary->trueExpr : ternary->falseExpr;
+            break;
+        }
+        default:
+            // Variables, this, super: not constant
+            break;
+    }
+}
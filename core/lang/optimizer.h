@@ -0,0 +1,22 @@
+#ifndef ANIS_OPTIMIZER_H
+#define ANIS_OPTIMIZER_H
+
+#include "parser.h"
+#include <vector>
+
+// AST pass run once before resolving. Literal nodes get their runtime Value built up front,
+// and operators whose operands are all literals are folded into a single literal:
+// `60 * 60 * 24`, `!0`, `"a" + "b"`, `1 ? x : y`, `0 && f()`.
+// Folding uses the same Interpreter::binaryOp/isTrue as execution, so results never differ.
+class Optimizer {
+public:
+    void optimize(const std::vector<std::shared_ptr<Stmt>>& statements);
+    
+private:
+    void statement(Stmt* stmt);
+    void expression(std::shared_ptr<Expr>& expr);
+    void block(BlockStmt* block);
+    void params(const ParamList& params);
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "parser.h"
 #include <iostream>
+#include <atomic>
 #include "debugger.h"
 
 std::vector<std::shared_ptr<Stmt>> Parser::parse() {
@@ -10,11 +11,27 @@ std::vector<std::shared_ptr<Stmt>> Parser::parse() {
             statements.push_back(declaration());
         } catch (...) {
             advance(); // synchronize
+            nesting = 0;
         }
     }
     return statements;
 }
 
+void Parser::parseDeferred(BlockStmt& body) {
+    std::unique_ptr<LazyBody> lazy = std::move(body.lazy);
+    try {
+        Lexer lexer(std::string_view(*lazy->source).substr(lazy->begin, lazy->end - lazy->begin), lazy->line);
+        Parser parser(lexer.tokenize(), lazy->arena);
+        parser.consume(TOK_LBRACE, "Expect '{' before function body.");
+        parser.nesting = 1;
+        parser.statementsInto(body, "Expect '}' after body.");
+    } catch (...) {
+        body.statements.clear();
+        body.lazy = std::move(lazy);
+        throw;
+    }
+}
+
 std::shared_ptr<Stmt> Parser::declaration() {
     // Skip extra semicolons
     while (match(TOK_SEMICOLON));
@@ -22,7 +39,7 @@ std::shared_ptr<Stmt> Parser::declaration() {
     // Export statement
     if (match(TOK_EXPORT)) {
         auto decl = declaration();  // Parse what follows (function, var, etc)
-        return std::make_shared<ExportStmt>(decl);
+        return node<ExportStmt>(decl);
     }
     
     // Duplicated import block removed
@@ -31,12 +48,13 @@ std::shared_ptr<Stmt> Parser::declaration() {
         Token name = consume(TOK_IDENTIFIER, "Expect class name.");
         std::string superclass = "";
         if (match(TOK_EXTENDS)) {
-            superclass = consume(TOK_IDENTIFIER, "Expect superclass name.").text;
+            superclass = std::string(consume(TOK_IDENTIFIER, "Expect superclass name.").text);
         }
         
         consume(TOK_LBRACE, "Expect '{' before class body.");
         
-        auto classStmt = std::make_shared<ClassStmt>(name.text, superclass);
+        auto classStmt = node<ClassStmt>(std::string(name.text), superclass);
+        classStmt->line = name.line;
         
         while (!check(TOK_RBRACE) && !isAtEnd()) {
             bool isStatic = match(TOK_STATIC);
@@ -54,23 +72,15 @@ std::shared_ptr<Stmt> Parser::declaration() {
             
             if (match(TOK_LPAREN)) {
                 // Method
-                std::vector<std::string> params;
-                if (!check(TOK_RPAREN)) {
-                    do {
-                        params.push_back(consume(TOK_IDENTIFIER, "Expect parameter name.").text);
-                    } while (match(TOK_COMMA));
-                }
-                consume(TOK_RPAREN, "Expect ')' after parameters.");
+                ParamList params = parameters();
+                // A setter without a declared parameter receives its value as 'value'
+                if (isSetter && params->empty()) params->push_back(Param::named("value"));
                 consume(TOK_LBRACE, "Expect '{' before method body.");
                 
-                std::shared_ptr<BlockStmt> body = std::make_shared<BlockStmt>();
-                while (!check(TOK_RBRACE) && !isAtEnd()) {
-                    body->statements.push_back(declaration());
-                }
-                consume(TOK_RBRACE, "Expect '}' after method body.");
+                std::shared_ptr<BlockStmt> body = functionBody("Expect '}' after method body.");
                 
                 ClassStmt::Method method;
-                method.name = memberName.text;
+                method.name = std::string(memberName.text);
                 method.params = params;
                 method.body = body;
                 method.isStatic = isStatic;
@@ -86,7 +96,7 @@ std::shared_ptr<Stmt> Parser::declaration() {
                 }
                 consume(TOK_SEMICOLON, "Expect ';' after field declaration.");
                 ClassStmt::Field field;
-                field.name = memberName.text;
+                field.name = std::string(memberName.text);
                 field.initializer = init;
                 field.isStatic = isStatic;
                 field.isPrivate = isPrivate;
@@ -104,7 +114,9 @@ std::shared_ptr<Stmt> Parser::declaration() {
         if (match(TOK_EQ)) {
             init = expression();
         }
-        return std::make_shared<VarDeclStmt>(name.text, init);
+        auto decl = node<VarDeclStmt>(std::string(name.text), init);
+        decl->line = name.line;
+        return decl;
     }
     // const handling (treat as var or destructuring)
     if (match(TOK_CONST)) {
@@ -114,13 +126,13 @@ std::shared_ptr<Stmt> Parser::declaration() {
             if (!check(TOK_RBRACKET)) {
                 do {
                     Token t = consume(TOK_IDENTIFIER, "Expect variable name in destructuring.");
-                    names.push_back(t.text);
+                    names.emplace_back(t.text);
                 } while (match(TOK_COMMA));
             }
             consume(TOK_RBRACKET, "Expect ']' after destructuring list.");
             consume(TOK_EQ, "Expect '=' after destructuring declaration.");
             std::shared_ptr<Expr> init = expression();
-            return std::make_shared<DestructureStmt>(names, init);
+            return node<DestructureStmt>(std::move(names), std::move(init));
         } else {
              // Normal const var
              Token name = consume(TOK_IDENTIFIER, "Expect variable name.");
@@ -128,58 +140,32 @@ std::shared_ptr<Stmt> Parser::declaration() {
              if (match(TOK_EQ)) {
                  init = expression();
              }
-             return std::make_shared<VarDeclStmt>(name.text, init);
+             auto decl = node<VarDeclStmt>(std::string(name.text), init);
+             decl->line = name.line;
+             return decl;
         }
     }
     if (match(TOK_FUNCTION)) {
         // Named function declaration: function Name(a, b) { ... }
         Token name = consume(TOK_IDENTIFIER, "Expect function name.");
         consume(TOK_LPAREN, "Expect '(' after function name.");
-        std::vector<std::string> params;
-        if (!check(TOK_RPAREN)) {
-            do {
-                // Check for destructuring pattern { a, b, c }
-                if (match(TOK_LBRACE)) {
-                    std::vector<std::string> props;
-                    if (!check(TOK_RBRACE)) {
-                        do {
-                            Token prop = consume(TOK_IDENTIFIER, "Expect property name in destructuring.");
-                            props.push_back(prop.text);
-                        } while (match(TOK_COMMA));
-                    }
-                    consume(TOK_RBRACE, "Expect '}' after destructuring pattern.");
-                    // Store as special format: "__destruct:{a,b,c}"
-                    std::string pattern = "__destruct:{";
-                    for (size_t i = 0; i < props.size(); i++) {
-                        pattern += props[i];
-                        if (i < props.size() - 1) pattern += ",";
-                    }
-                    pattern += "}";
-                    params.push_back(pattern);
-                } else if (match(TOK_IDENTIFIER)) {
-                    params.push_back(previous().text);
-                }
-            } while (match(TOK_COMMA));
-        }
-        consume(TOK_RPAREN, "Expect ')' after parens.");
+        ParamList params = parameters();
         consume(TOK_LBRACE, "Expect '{' before function body.");
-        std::shared_ptr<BlockStmt> body = std::make_shared<BlockStmt>();
-        while (!check(TOK_RBRACE) && !isAtEnd()) {
-            body->statements.push_back(declaration());
-        }
-        consume(TOK_RBRACE, "Expect '}' after body.");
-        return std::make_shared<FuncDeclStmt>(name.text, params, body);
+        std::shared_ptr<BlockStmt> body = functionBody("Expect '}' after body.");
+        auto decl = node<FuncDeclStmt>(std::string(name.text), params, body);
+        decl->line = name.line;
+        return decl;
     }
     if (match(TOK_IMPORT)) {
         if (match(TOK_STRING)) {
-            std::string mod = previous().text;
-            return std::make_shared<ImportStmt>(mod);
+            std::string mod(previous().text);
+            return node<ImportStmt>(mod);
         }
         if (match(TOK_LBRACE)) {
             std::vector<std::string> syms;
             if (!check(TOK_RBRACE)) {
                 do {
-                    if (match(TOK_IDENTIFIER)) syms.push_back(previous().text);
+                    if (match(TOK_IDENTIFIER)) syms.emplace_back(previous().text);
                 } while (match(TOK_COMMA));
             }
             consume(TOK_RBRACE, "Expect '}' after import list.");
@@ -187,7 +173,7 @@ std::shared_ptr<Stmt> Parser::declaration() {
                  // matched from
             }
             Token modToken = consume(TOK_STRING, "Expect module string after 'from'.");
-            return std::make_shared<ImportStmt>(modToken.text, syms);
+            return node<ImportStmt>(std::string(modToken.text), std::move(syms));
         }
     }
 
@@ -202,7 +188,7 @@ std::shared_ptr<Stmt> Parser::statement() {
         }
         // consume semicolon if present
         match(TOK_SEMICOLON);
-        return std::make_shared<ReturnStmt>(value);
+        return node<ReturnStmt>(value);
     }
     if (match(TOK_IF)) {
         consume(TOK_LPAREN, "Expect '(' after if.");
@@ -213,27 +199,44 @@ std::shared_ptr<Stmt> Parser::statement() {
         if (match(TOK_ELSE)) {
             elseBranch = statement();
         }
-        return std::make_shared<IfStmt>(condition, thenBranch, elseBranch);
+        return node<IfStmt>(condition, thenBranch, elseBranch);
+    }
+    if (check(TOK_IDENTIFIER) && peekNext().type == TOK_COLON) {
+        // Labelled loop: name: while (...) ...
+        Token label = advance();
+        advance(); // ':'
+        if (!check(TOK_WHILE)) {
+            Debugger::parseError("Expect loop after label '" + std::string(label.text) + "'.", peek().text, peek().line);
+            throw std::runtime_error("Expect loop after label.");
+        }
+        auto loop = std::static_pointer_cast<WhileStmt>(statement());
+        loop->label = intern(std::string(label.text));
+        return loop;
+    }
+    if (match(TOK_BREAK) || match(TOK_CONTINUE)) {
+        Token keyword = previous();
+        Atom label = NoAtom;
+        if (check(TOK_IDENTIFIER) && peek().line == keyword.line) label = intern(std::string(advance().text));
+        match(TOK_SEMICOLON);
+        auto jump = node<JumpStmt>(keyword.type == TOK_BREAK ? StmtKind::Break : StmtKind::Continue, label);
+        jump->line = keyword.line;
+        return jump;
     }
     if (match(TOK_WHILE)) {
         consume(TOK_LPAREN, "Expect '(' after while.");
         std::shared_ptr<Expr> condition = expression();
         consume(TOK_RPAREN, "Expect ')' after condition.");
         std::shared_ptr<Stmt> body = statement();
-        return std::make_shared<WhileStmt>(condition, body);
+        return node<WhileStmt>(condition, body);
     }
     if (match(TOK_THROW)) {
         std::shared_ptr<Expr> expr = expression();
         consume(TOK_SEMICOLON, "Expect ';' after throw value.");
-        return std::make_shared<ThrowStmt>(expr);
+        return node<ThrowStmt>(expr);
     }
     if (match(TOK_TRY)) {
         consume(TOK_LBRACE, "Expect '{' after try.");
-        std::shared_ptr<BlockStmt> tryBlock = std::make_shared<BlockStmt>();
-        while (!check(TOK_RBRACE) && !isAtEnd()) {
-            tryBlock->statements.push_back(declaration());
-        }
-        consume(TOK_RBRACE, "Expect '}' after try block.");
+        std::shared_ptr<BlockStmt> tryBlock = blockBody("Expect '}' after try block.");
         
         std::shared_ptr<BlockStmt> catchBlock = nullptr;
         std::string catchVar = "";
@@ -242,27 +245,19 @@ std::shared_ptr<Stmt> Parser::statement() {
         if (match(TOK_CATCH)) {
             consume(TOK_LPAREN, "Expect '(' after catch.");
             Token name = consume(TOK_IDENTIFIER, "Expect catch variable name.");
-            catchVar = name.text;
+            catchVar = std::string(name.text);
             consume(TOK_RPAREN, "Expect ')' after catch variable.");
             
             consume(TOK_LBRACE, "Expect '{' before catch block.");
-            catchBlock = std::make_shared<BlockStmt>();
-            while (!check(TOK_RBRACE) && !isAtEnd()) {
-                catchBlock->statements.push_back(declaration());
-            }
-            consume(TOK_RBRACE, "Expect '}' after catch block.");
+            catchBlock = blockBody("Expect '}' after catch block.");
         }
         
         if (match(TOK_FINALLY)) {
             consume(TOK_LBRACE, "Expect '{' before finally block.");
-            finallyBlock = std::make_shared<BlockStmt>();
-            while (!check(TOK_RBRACE) && !isAtEnd()) {
-                finallyBlock->statements.push_back(declaration());
-            }
-            consume(TOK_RBRACE, "Expect '}' after finally block.");
+            finallyBlock = blockBody("Expect '}' after finally block.");
         }
         
-        return std::make_shared<TryStmt>(tryBlock, catchBlock, finallyBlock, catchVar);
+        return node<TryStmt>(tryBlock, catchBlock, finallyBlock, catchVar);
     }
     if (match(TOK_SWITCH)) {
         consume(TOK_LPAREN, "Expect '(' after switch.");
@@ -271,6 +266,7 @@ std::shared_ptr<Stmt> Parser::statement() {
         consume(TOK_LBRACE, "Expect '{' before switch cases.");
         
         std::vector<Case> cases;
+        nesting++;
         while (!check(TOK_RBRACE) && !isAtEnd()) {
             if (match(TOK_CASE)) {
                  std::shared_ptr<Expr> value = expression();
@@ -278,14 +274,14 @@ std::shared_ptr<Stmt> Parser::statement() {
                  // Parse statements until next case/default/brace?
                  // Simplification: Require block or single statement
                  // Or loop declarations until case/default/rbrace
-                 std::shared_ptr<BlockStmt> block = std::make_shared<BlockStmt>();
+                 std::shared_ptr<BlockStmt> block = node<BlockStmt>();
                  while (!check(TOK_CASE) && !check(TOK_DEFAULT) && !check(TOK_RBRACE) && !isAtEnd()) {
                      block->statements.push_back(declaration());
                  }
                  cases.push_back({value, block});
             } else if (match(TOK_DEFAULT)) {
                  consume(TOK_COLON, "Expect ':' after default.");
-                 std::shared_ptr<BlockStmt> block = std::make_shared<BlockStmt>();
+                 std::shared_ptr<BlockStmt> block = node<BlockStmt>();
                  while (!check(TOK_CASE) && !check(TOK_DEFAULT) && !check(TOK_RBRACE) && !isAtEnd()) {
                      block->statements.push_back(declaration());
                  }
@@ -295,141 +291,107 @@ std::shared_ptr<Stmt> Parser::statement() {
                  advance();
             }
         }
+        nesting--;
         consume(TOK_RBRACE, "Expect '}' after switch cases.");
-        return std::make_shared<SwitchStmt>(condition, cases);
+        return node<SwitchStmt>(std::move(condition), std::move(cases));
     }
     if (match(TOK_LBRACE)) {
-        std::shared_ptr<BlockStmt> block = std::make_shared<BlockStmt>();
-        while (!check(TOK_RBRACE) && !isAtEnd()) {
-            block->statements.push_back(declaration());
-        }
-        consume(TOK_RBRACE, "Expect '}'");
+        std::shared_ptr<BlockStmt> block = blockBody("Expect '}'");
         return block;
     }
     std::shared_ptr<Expr> expr = expression();
     match(TOK_SEMICOLON); // optional
-    return std::make_shared<ExprStmt>(expr);
+    return node<ExprStmt>(expr);
 }
 
 // Expression Precedence
-// expression -> assignment
-// assignment -> equality
-// ... -> primary
+// expression -> assignment (ternary, =, +=)
+// assignment -> binary operators by precedence (below) -> unary -> call -> primary
 
 std::shared_ptr<Expr> Parser::expression() {
     return assignment();
 }
 
 std::shared_ptr<Expr> Parser::assignment() {
-    std::shared_ptr<Expr> expr = logicalOr();
+    std::shared_ptr<Expr> expr = binary(1);
     
     // Ternary operator: condition ? trueExpr : falseExpr
     if (match(TOK_QUESTION)) {
         std::shared_ptr<Expr> trueExpr = expression();
         consume(TOK_COLON, "Expect ':' after true expression in ternary.");
         std::shared_ptr<Expr> falseExpr = assignment();
-        return std::make_shared<TernaryExpr>(expr, trueExpr, falseExpr);
+        return node<TernaryExpr>(std::move(expr), std::move(trueExpr), std::move(falseExpr));
     }
     
     if (match(TOK_EQ)) {
         std::shared_ptr<Expr> value = assignment();
-        if (auto var = std::dynamic_pointer_cast<VarExpr>(expr)) {
-            return std::make_shared<BinaryExpr>(var, "=", value);
-        }
-        if (auto mem = std::dynamic_pointer_cast<MemberExpr>(expr)) {
-            return std::make_shared<BinaryExpr>(mem, "=", value);
+        if (expr->kind == ExprKind::Var || expr->kind == ExprKind::Member) {
+            return node<BinaryExpr>(std::move(expr), BinaryOp::Assign, std::move(value));
         }
     Debugger::parseError("Invalid assignment target.", "", peek().line);
     return expr;
     }
     if (match(TOK_PLUS_EQUAL)) {
         std::shared_ptr<Expr> value = assignment();
-        if (auto var = std::dynamic_pointer_cast<VarExpr>(expr)) {
-             return std::make_shared<BinaryExpr>(var, "+=", value);
+        if (expr->kind == ExprKind::Var) {
+             return node<BinaryExpr>(std::move(expr), BinaryOp::AddAssign, std::move(value));
         }
     }
     
     return expr;
 }
 
-std::shared_ptr<Expr> Parser::logicalOr() {
-    std::shared_ptr<Expr> expr = logicalAnd();
-    while (match(TOK_OR)) {
-        std::shared_ptr<Expr> right = logicalAnd();
-        expr = std::make_shared<BinaryExpr>(expr, "||", right);
-    }
-    return expr;
-}
-
-std::shared_ptr<Expr> Parser::logicalAnd() {
-    std::shared_ptr<Expr> expr = equality();
-    while (match(TOK_AND)) {
-        std::shared_ptr<Expr> right = equality();
-        expr = std::make_shared<BinaryExpr>(expr, "&&", right);
-    }
-    return expr;
-}
+namespace {
 
-std::shared_ptr<Expr> Parser::equality() {
-    std::shared_ptr<Expr> expr = comparison();
-    while (match(TOK_EQEQ) || match(TOK_NE)) {
-        Token opToken = previous();
-        std::string op = opToken.type == TOK_EQEQ ? "==" : "!=";
-        std::shared_ptr<Expr> right = comparison();
-        auto bin = std::make_shared<BinaryExpr>(expr, op, right);
-        bin->line = opToken.line;
-        expr = bin;
-    }
-    return expr;
-}
+// Binary operators by token: how tightly each binds (0: not a binary operator). All of them
+// are left-associative.
+struct BinaryRule {
+    BinaryOp op;
+    int precedence;
+};
 
-std::shared_ptr<Expr> Parser::comparison() {
-    std::shared_ptr<Expr> expr = term();
-    while (match(TOK_LT) || match(TOK_GT) || match(TOK_LTE) || match(TOK_GTE)) {
-        Token opToken = previous();
-        std::string op;
-        if (opToken.type == TOK_LT) op = "<";
-        else if (opToken.type == TOK_GT) op = ">";
-        else if (opToken.type == TOK_LTE) op = "<=";
-        else if (opToken.type == TOK_GTE) op = ">=";
-        std::shared_ptr<Expr> right = term();
-        auto bin = std::make_shared<BinaryExpr>(expr, op, right);
-        bin->line = opToken.line;
-        expr = bin;
+BinaryRule binaryRule(TokenType type) {
+    switch (type) {
+        case TOK_OR: return {BinaryOp::Or, 1};
+        case TOK_AND: return {BinaryOp::And, 2};
+        case TOK_EQEQ: return {BinaryOp::Eq, 3};
+        case TOK_NE: return {BinaryOp::Ne, 3};
+        case TOK_LT: return {BinaryOp::Lt, 4};
+        case TOK_GT: return {BinaryOp::Gt, 4};
+        case TOK_LTE: return {BinaryOp::Le, 4};
+        case TOK_GTE: return {BinaryOp::Ge, 4};
+        case TOK_PLUS: return {BinaryOp::Add, 5};
+        case TOK_MINUS: return {BinaryOp::Sub, 5};
+        case TOK_STAR: return {BinaryOp::Mul, 6};
+        case TOK_SLASH: return {BinaryOp::Div, 6};
+        default: return {BinaryOp::Assign, 0};
     }
-    return expr;
 }
 
-std::shared_ptr<Expr> Parser::term() {
-    std::shared_ptr<Expr> expr = factor();
-    while (match(TOK_PLUS) || match(TOK_MINUS)) {
-        std::string op = previous().type == TOK_PLUS ? "+" : "-";
-        std::shared_ptr<Expr> right = factor(); 
-        auto bin = std::make_shared<BinaryExpr>(expr, op, right);
-        bin->line = previous().line;
-        expr = bin;
-    }
-    return expr;
 }
 
-std::shared_ptr<Expr> Parser::factor() {
-    std::shared_ptr<Expr> expr = unary();
-    while (match(TOK_STAR) || match(TOK_SLASH)) {
-        std::string op = previous().type == TOK_STAR ? "*" : "/";
-        std::shared_ptr<Expr> right = unary();
-        auto bin = std::make_shared<BinaryExpr>(expr, op, right);
-        bin->line = previous().line;
-        expr = bin;
-    }
-    return expr;
+// Precedence climbing: one loop for every level instead of a function per level, so an
+// operand costs one table lookup rather than a descent through all of them
+std::shared_ptr<Expr> Parser::binary(int minPrecedence) {
+    std::shared_ptr<Expr> left = unary();
+    for (;;) {
+        BinaryRule rule = binaryRule(peek().type);
+        if (rule.precedence == 0 || rule.precedence < minPrecedence) break;
+        int line = advance().line;
+        std::shared_ptr<Expr> right = binary(rule.precedence + 1);
+        auto bin = node<BinaryExpr>(std::move(left), rule.op, std::move(right));
+        bin->line = line;
+        left = std::move(bin);
+    }
+    return left;
 }
 
 std::shared_ptr<Expr> Parser::unary() {
     if (match(TOK_BANG) || match(TOK_MINUS)) {
         Token opToken = previous();
-        std::string op = opToken.text;
+        UnaryOp op = opToken.type == TOK_BANG ? UnaryOp::Not : UnaryOp::Neg;
         std::shared_ptr<Expr> right = unary();
-        auto u = std::make_shared<UnaryExpr>(op, right);
+        auto u = node<UnaryExpr>(op, right);
         u->line = opToken.line;
         return u;
     }
@@ -438,47 +400,37 @@ std::shared_ptr<Expr> Parser::unary() {
 
 std::shared_ptr<Expr> Parser::primary() {
     if (match(TOK_NUMBER)) {
-        auto expr = std::make_shared<LiteralExpr>(previous().text, false);
+        auto expr = node<LiteralExpr>(std::string(previous().text), false);
         expr->line = previous().line;
         return expr;
     }
     if (match(TOK_STRING)) {
-        auto expr = std::make_shared<LiteralExpr>(previous().text, true);
+        auto expr = node<LiteralExpr>(std::string(previous().text), true);
         expr->line = previous().line;
         return expr;
     }
     
     // Arrow Function: param => ... (Single param, no parens)
     if (check(TOK_IDENTIFIER) && peekNext().type == TOK_ARROW) {
-        std::string param = advance().text;
+        std::string param(advance().text);
         int line = previous().line;
         consume(TOK_ARROW, "Expect '=>'");
         
-        std::shared_ptr<BlockStmt> body = std::make_shared<BlockStmt>();
-        if (match(TOK_LBRACE)) {
-             while (!check(TOK_RBRACE) && !isAtEnd()) {
-                 body->statements.push_back(declaration());
-             }
-             consume(TOK_RBRACE, "Expect '}'");
-        } else {
-             // Expression body: param => expr -> implicit return
-             std::shared_ptr<Expr> expr = expression();
-             body->statements.push_back(std::make_shared<ReturnStmt>(expr));
-        }
-        auto fn = std::make_shared<FunctionExpr>(std::vector<std::string>{param}, body);
+        std::shared_ptr<BlockStmt> body = arrowBody();
+        auto fn = node<FunctionExpr>(namedParams({param}), body);
         fn->line = line;
         return fn;
     }
 
     // Identifier
     if (match(TOK_IDENTIFIER)) {
-        auto var = std::make_shared<VarExpr>(previous().text);
+        auto var = node<VarExpr>(std::string(previous().text));
         var->line = previous().line;
         return var;
     }
     
     if (match(TOK_THIS)) {
-        auto t = std::make_shared<ThisExpr>();
+        auto t = node<ThisExpr>();
         t->line = previous().line;
         return t;
     }
@@ -487,16 +439,16 @@ std::shared_ptr<Expr> Parser::primary() {
         Token keyword = previous();
         std::shared_ptr<Expr> property = nullptr;
         if (match(TOK_DOT)) {
-            property = std::make_shared<VarExpr>(consume(TOK_IDENTIFIER, "Expect superclass method name.").text);
+            property = node<VarExpr>(std::string(consume(TOK_IDENTIFIER, "Expect superclass method name.").text));
         }
-        auto s = std::make_shared<SuperExpr>(keyword, property);
+        auto s = node<SuperExpr>(keyword, property);
         s->line = keyword.line;
         return s;
     }
     
     if (match(TOK_NEW)) {
         int line = previous().line;
-        std::string name = consume(TOK_IDENTIFIER, "Expect class name after 'new'.").text;
+        std::string name(consume(TOK_IDENTIFIER, "Expect class name after 'new'.").text);
         consume(TOK_LPAREN, "Expect '(' after class name.");
         std::vector<std::shared_ptr<Expr>> args;
         if (!check(TOK_RPAREN)) {
@@ -505,7 +457,7 @@ std::shared_ptr<Expr> Parser::primary() {
             } while (match(TOK_COMMA));
         }
         consume(TOK_RPAREN, "Expect ')' after arguments.");
-        auto n = std::make_shared<NewExpr>(name, args);
+        auto n = node<NewExpr>(std::move(name), std::move(args));
         n->line = line;
         return n;
     }
@@ -513,7 +465,7 @@ std::shared_ptr<Expr> Parser::primary() {
     // Object Literal
     if (match(TOK_LBRACE)) {
         Token lbraceToken = previous(); // Capture token for line number
-        std::map<std::string, std::shared_ptr<Expr>> props;
+        std::vector<std::pair<std::string, std::shared_ptr<Expr>>> props;
         if (!check(TOK_RBRACE)) {
             do {
                 if (check(TOK_RBRACE)) break; // Support trailing comma
@@ -521,22 +473,21 @@ std::shared_ptr<Expr> Parser::primary() {
                 if (match(TOK_DOT_DOT_DOT)) {
                     std::shared_ptr<Expr> spreadExpr = expression();
                     // Store spread with special key prefix
-                    static int spreadCounter = 0;
-                    auto spread = std::make_shared<SpreadExpr>(spreadExpr);
+                    static std::atomic<int> spreadCounter{0}; // Modules are parsed on several threads
+                    auto spread = node<SpreadExpr>(spreadExpr);
                     spread->line = previous().line; // Line of '...'
-                    props["__spread_" + std::to_string(spreadCounter++)] = spread;
+                    props.emplace_back("__spread_" + std::to_string(spreadCounter++), std::move(spread));
                 } else {
                     if (check(TOK_IDENTIFIER) || check(TOK_STRING)) {
                         Token key = advance();
                         
                         if (match(TOK_COLON)) {
-                             std::shared_ptr<Expr> val = expression();
-                             props[key.text] = val;
+                             props.emplace_back(std::string(key.text), expression());
                         } else if (key.type == TOK_IDENTIFIER) {
                              // Shorthand { key } -> { key: key }
-                             auto var = std::make_shared<VarExpr>(key.text);
+                             auto var = node<VarExpr>(std::string(key.text));
                              var->line = key.line;
-                             props[key.text] = var;
+                             props.emplace_back(std::string(key.text), std::move(var));
                         } else {
                              Debugger::parseError("Expect ':' after string key in object literal.", key.text, key.line);
                         }
@@ -547,7 +498,7 @@ std::shared_ptr<Expr> Parser::primary() {
             } while (match(TOK_COMMA));
         }
         consume(TOK_RBRACE, "Expect '}' after object literal.");
-        auto objExpr = std::make_shared<ObjectExpr>(props);
+        auto objExpr = node<ObjectExpr>(std::move(props));
         objExpr->line = lbraceToken.line; // Line of '{'
         return objExpr;
     }
@@ -560,7 +511,7 @@ std::shared_ptr<Expr> Parser::primary() {
             do {
                 if (match(TOK_DOT_DOT_DOT)) {
                     auto arg = expression();
-                    auto spread = std::make_shared<SpreadExpr>(arg);
+                    auto spread = node<SpreadExpr>(arg);
                     spread->line = previous().line; // Line of '...'
                     elements.push_back(spread);
                 } else {
@@ -569,7 +520,7 @@ std::shared_ptr<Expr> Parser::primary() {
             } while (match(TOK_COMMA));
         }
         consume(TOK_RBRACKET, "Expect ']' after array literal.");
-        auto arrayExpr = std::make_shared<ArrayExpr>(elements);
+        auto arrayExpr = node<ArrayExpr>(std::move(elements));
         arrayExpr->line = lbracketToken.line; // Line of '['
         return arrayExpr;
     }
@@ -611,29 +562,19 @@ std::shared_ptr<Expr> Parser::primary() {
                  consume(TOK_RPAREN, "Expect ')'");
                  consume(TOK_ARROW, "Expect '=>'");
                   
-                  std::shared_ptr<BlockStmt> body = std::make_shared<BlockStmt>();
-                  if (match(TOK_LBRACE)) {
-                      while (!check(TOK_RBRACE) && !isAtEnd()) {
-                          body->statements.push_back(declaration());
-                      }
-                      consume(TOK_RBRACE, "Expect '}'");
-                  } else {
-                      // Expression body
-                      std::shared_ptr<Expr> expr = expression();
-                      body->statements.push_back(std::make_shared<ReturnStmt>(expr));
-                  }
-                 return std::make_shared<FunctionExpr>(std::vector<std::string>{}, body);
+                 std::shared_ptr<BlockStmt> body = arrowBody();
+                 auto fn = node<FunctionExpr>(namedParams({}), body);
+                 fn->line = lparenToken.line;
+                 return fn;
              }
              // Legacy () { ... }
              if (t.type == TOK_LBRACE) {
                  consume(TOK_RPAREN, "Expect ')'");
                  consume(TOK_LBRACE, "Expect '{'");
-                 std::shared_ptr<BlockStmt> body = std::make_shared<BlockStmt>();
-                 while (!check(TOK_RBRACE) && !isAtEnd()) {
-                      body->statements.push_back(declaration());
-                 }
-                 consume(TOK_RBRACE, "Expect '}'");
-                 return std::make_shared<FunctionExpr>(std::vector<std::string>{}, body);
+                 std::shared_ptr<BlockStmt> body = functionBody("Expect '}'");
+                 auto fn = node<FunctionExpr>(namedParams({}), body);
+                 fn->line = lparenToken.line;
+                 return fn;
              }
         }
         
@@ -643,11 +584,11 @@ std::shared_ptr<Expr> Parser::primary() {
         if (check(TOK_IDENTIFIER)) {
             size_t savedPos = current;
             std::vector<std::string> params;
-            params.push_back(advance().text);
+            params.emplace_back(advance().text);
             
             while (match(TOK_COMMA)) {
                 if (check(TOK_IDENTIFIER)) {
-                    params.push_back(advance().text);
+                    params.emplace_back(advance().text);
                 } else {
                     current = savedPos;
                     params.clear();
@@ -659,18 +600,10 @@ std::shared_ptr<Expr> Parser::primary() {
                 consume(TOK_RPAREN, "Expect ')'");
                 consume(TOK_ARROW, "Expect '=>'");
                 
-                std::shared_ptr<BlockStmt> body = std::make_shared<BlockStmt>();
-                if (match(TOK_LBRACE)) {
-                    while (!check(TOK_RBRACE) && !isAtEnd()) {
-                        body->statements.push_back(declaration());
-                    }
-                    consume(TOK_RBRACE, "Expect '}'");
-                } else {
-                    // Expression body
-                    std::shared_ptr<Expr> expr = expression();
-                    body->statements.push_back(std::make_shared<ReturnStmt>(expr));
-                }
-                return std::make_shared<FunctionExpr>(params, body);
+                std::shared_ptr<BlockStmt> body = arrowBody();
+                auto fn = node<FunctionExpr>(namedParams(params), body);
+                fn->line = lparenToken.line;
+                return fn;
             } else {
                 // Not arrow function, restore position
                 current = savedPos;
@@ -710,12 +643,10 @@ std::shared_ptr<Expr> Parser::primary() {
              }
              
              consume(TOK_LBRACE, "Expect '{' for lambda body.");
-             std::shared_ptr<BlockStmt> body = std::make_shared<BlockStmt>();
-             while (!check(TOK_RBRACE) && !isAtEnd()) {
-                 body->statements.push_back(declaration());
-             }
-             consume(TOK_RBRACE, "Expect '}' after lambda body.");
-             return std::make_shared<FunctionExpr>(params, body);
+             std::shared_ptr<BlockStmt> body = functionBody("Expect '}' after lambda body.");
+             auto fn = node<FunctionExpr>(namedParams(params), body);
+             fn->line = lparenToken.line;
+             return fn;
         }
         
         return expr;
@@ -727,7 +658,7 @@ std::shared_ptr<Expr> Parser::primary() {
         if (!match(TOK_IDENTIFIER)) {
              Debugger::parseError("Expect tag name.", peek().text, peek().line);
         }
-        std::string tagName = previous().text;
+        std::string tagName(previous().text);
         std::map<std::string, std::shared_ptr<Expr>> attrs;
         std::vector<std::shared_ptr<Expr>> children;
         
@@ -735,12 +666,12 @@ std::shared_ptr<Expr> Parser::primary() {
         // Iterate until '/' or '>'
         while (!check(TOK_GT) && !check(TOK_SLASH) && !isAtEnd()) {
              if (match(TOK_IDENTIFIER)) {
-                 std::string key = previous().text;
-                 std::shared_ptr<Expr> val = std::make_shared<LiteralExpr>("true", false); // Default boolean true
+                 std::string key(previous().text);
+                 std::shared_ptr<Expr> val;
                  
                  if (match(TOK_EQ)) {
                       if (match(TOK_STRING)) {
-                           val = std::make_shared<LiteralExpr>(previous().text, true);
+                           val = node<LiteralExpr>(std::string(previous().text), true);
                       } else if (match(TOK_LBRACE)) {
                            val = expression();
                            consume(TOK_RBRACE, "Expect '}' after attribute expression.");
@@ -748,7 +679,8 @@ std::shared_ptr<Expr> Parser::primary() {
                            Debugger::parseError("Expect string or {expr} for attribute value.", peek().text, peek().line);
                       }
                  }
-                 attrs[key] = val;
+                 if (!val) val = node<LiteralExpr>("true", false); // Default boolean true
+                 attrs[std::move(key)] = std::move(val);
              } else {
                  advance(); // skip garbage?
              }
@@ -757,7 +689,7 @@ std::shared_ptr<Expr> Parser::primary() {
         // Self closing?
         if (match(TOK_SLASH)) {
             consume(TOK_GT, "Expect '>' after '/' in self-closing tag.");
-            return std::make_shared<JsxExpr>(tagName, attrs, children);
+            return node<JsxExpr>(std::move(tagName), std::move(attrs), std::move(children));
         }
         
         consume(TOK_GT, "Expect '>' after attributes.");
@@ -795,8 +727,7 @@ std::shared_ptr<Expr> Parser::primary() {
                     }
                 } else {
                     // Primitive Text content approximation
-                    std::string s = advance().text;
-                    children.push_back(std::make_shared<LiteralExpr>(s, true));
+                    children.push_back(node<LiteralExpr>(std::string(advance().text), true));
                 }
             }
         }
@@ -805,11 +736,11 @@ std::shared_ptr<Expr> Parser::primary() {
         consume(TOK_SLASH, "Expect '/'.");
         if (match(TOK_IDENTIFIER)) {
              if (previous().text != tagName) {
-                  Debugger::parseError("Mismatch closing tag: expected " + tagName + ", got " + previous().text, previous().text, previous().line);
+                  Debugger::parseError("Mismatch closing tag: expected " + tagName + ", got " + std::string(previous().text), previous().text, previous().line);
              }
         }
         consume(TOK_GT, "Expect '>' after closing tag.");
-        return std::make_shared<JsxExpr>(tagName, attrs, children);
+        return node<JsxExpr>(std::move(tagName), std::move(attrs), std::move(children));
     }
     
     Debugger::parseError("Unexpected token.", peek().text, peek().line);
@@ -829,9 +760,9 @@ std::shared_ptr<Expr> Parser::call() {
                 } while (match(TOK_COMMA));
             }
             consume(TOK_RPAREN, "Expect ')' after arguments.");
-            auto call = std::make_shared<CallExpr>(expr, args);
+            auto call = node<CallExpr>(std::move(expr), std::move(args));
             call->line = previous().line; // Closing paren line
-            expr = call;
+            expr = std::move(call);
         }
         else if (match(TOK_DOT)) {
             Token name;
@@ -843,17 +774,17 @@ std::shared_ptr<Expr> Parser::call() {
             } else {
                 name = consume(TOK_IDENTIFIER, "Expect property name after '.'.");
             }
-            auto member = std::make_shared<MemberExpr>(expr, std::make_shared<LiteralExpr>(name.text, true), false);
+            auto member = node<MemberExpr>(std::move(expr), node<LiteralExpr>(std::string(name.text), true), false);
             member->line = name.line;
-            expr = member;
+            expr = std::move(member);
         }
         else if (match(TOK_LBRACKET)) {
              auto index = expression();
              consume(TOK_RBRACKET, "Expect ']' after index.");
              Token bracket = previous();
-             auto member = std::make_shared<MemberExpr>(expr, index, true);
+             auto member = node<MemberExpr>(std::move(expr), std::move(index), true);
              member->line = bracket.line;
-             expr = member;
+             expr = std::move(member);
         }
         else {
             break;
@@ -864,35 +795,95 @@ std::shared_ptr<Expr> Parser::call() {
 }
 
 // Helpers
-bool Parser::match(TokenType t) {
-    if (check(t)) {
-        advance();
-        return true;
+ParamList Parser::parameters() {
+    auto params = std::make_shared<std::vector<Param>>();
+    if (!check(TOK_RPAREN)) {
+        do {
+            Param param;
+            if (match(TOK_LBRACE) || match(TOK_LBRACKET)) {
+                // Destructuring pattern { a, b } or [ a, b ]
+                bool object = previous().type == TOK_LBRACE;
+                TokenType close = object ? TOK_RBRACE : TOK_RBRACKET;
+                param.kind = object ? Param::Object : Param::Array;
+                if (!check(close)) {
+                    do {
+                        Token name = consume(TOK_IDENTIFIER, "Expect name in destructuring pattern.");
+                        param.names.push_back({std::string(name.text), intern(std::string(name.text))});
+                    } while (match(TOK_COMMA));
+                }
+                consume(close, object ? "Expect '}' after destructuring pattern." : "Expect ']' after destructuring pattern.");
+            } else {
+                if (match(TOK_DOT_DOT_DOT)) param.kind = Param::Rest;
+                Token name = consume(TOK_IDENTIFIER, "Expect parameter name.");
+                param.names.push_back({std::string(name.text), intern(std::string(name.text))});
+            }
+            if (param.kind != Param::Rest && match(TOK_EQ)) {
+                nesting++; // Defaults are resolved in the function's frame
+                param.defaultValue = assignment();
+                nesting--;
+            }
+            params->push_back(std::move(param));
+            if (params->back().kind == Param::Rest) break; // Rest must be last
+        } while (match(TOK_COMMA));
     }
-    return false;
-}
-bool Parser::check(TokenType t) {
-    if (isAtEnd()) return false;
-    return peek().type == t;
-}
-Token Parser::advance() {
-    if (!isAtEnd()) current++;
-    return previous();
+    consume(TOK_RPAREN, "Expect ')' after parameters.");
+    return params;
 }
-bool Parser::isAtEnd() {
-    return peek().type == TOK_EOF;
+
+void Parser::statementsInto(BlockStmt& block, const char* err) {
+    while (!check(TOK_RBRACE) && !isAtEnd()) {
+        block.statements.push_back(declaration());
+    }
+    consume(TOK_RBRACE, err);
 }
-Token Parser::peek() {
-    return tokens[current];
+
+std::shared_ptr<BlockStmt> Parser::blockBody(const char* err) {
+    std::shared_ptr<BlockStmt> block = node<BlockStmt>();
+    nesting++;
+    statementsInto(*block, err);
+    nesting--;
+    return block;
 }
-Token Parser::peekNext() {
-    if (isAtEnd()) return peek();
-    return tokens[current + 1];
+
+// Bodies at the top level of a module parsed with its source are only brace-matched: a view
+// module declares many components and handlers that a run never calls. Short ones are parsed
+// anyway, since parsing them later costs more than it saves.
+std::shared_ptr<BlockStmt> Parser::functionBody(const char* err) {
+    const size_t MinLazyTokens = 32;
+    if (source && nesting == 0) {
+        size_t depth = 1;
+        size_t close = current;
+        for (; tokens[close].type != TOK_EOF; close++) {
+            if (tokens[close].type == TOK_LBRACE) depth++;
+            else if (tokens[close].type == TOK_RBRACE && --depth == 0) break;
+        }
+        // Unbalanced braces fall through, so the error is reported now
+        if (depth == 0 && close - current >= MinLazyTokens) {
+            const Token& open = previous();
+            std::shared_ptr<BlockStmt> body = node<BlockStmt>();
+            size_t begin = (size_t)(open.text.data() - source->data());
+            size_t end = (size_t)(tokens[close].text.data() - source->data()) + 1;
+            body->lazy.reset(new LazyBody{source, arena, begin, end, open.line, ""});
+            deferredBodies++;
+            deferredBytes += end - begin;
+            current = close + 1;
+            return body;
+        }
+    }
+    return blockBody(err);
 }
-Token Parser::previous() {
-    return tokens[current - 1];
+
+// After `=>`: a block, or an expression the function returns
+std::shared_ptr<BlockStmt> Parser::arrowBody() {
+    if (match(TOK_LBRACE)) return functionBody("Expect '}'");
+    std::shared_ptr<BlockStmt> body = node<BlockStmt>();
+    nesting++;
+    body->statements.push_back(node<ReturnStmt>(expression()));
+    nesting--;
+    return body;
 }
-Token Parser::consume(TokenType t, std::string err) {
+
+const Token& Parser::consume(TokenType t, const char* err) {
     if (check(t)) return advance();
     Debugger::parseError(err, peek().text, peek().line);
     throw std::runtime_error(err);
@@ -7,14 +7,46 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <algorithm>
+#include <cstdint>
 #include "lexer.h"
+#include "atom.h"
+#include "value.h"
+#include "shape.h"
+#include "ast_arena.h"
+
+struct Chunk; // bytecode.h
+
+// Node kinds, so the interpreter can dispatch with a switch instead of RTTI casts
+enum class ExprKind : uint8_t {
+    Literal, Var, Call, Member, Object, Array, Spread, This, Super, New,
+    Unary, Binary, Ternary, Jsx, Function
+};
+
+enum class StmtKind : uint8_t {
+    Block, VarDecl, If, While, Switch, FuncDecl, Return, Import, Destructure,
+    Export, Expr, Class, Try, Throw, Break, Continue
+};
+
+// Operators, resolved from tokens at parse time
+enum class BinaryOp : uint8_t {
+    Assign, AddAssign, Or, And,
+    Eq, Ne, Lt, Gt, Le, Ge,
+    Add, Sub, Mul, Div
+};
+
+enum class UnaryOp : uint8_t { Not, Neg };
 
 // AST Base
 struct Stmt { 
+    const StmtKind kind;
+    explicit Stmt(StmtKind k) : kind(k) {}
     virtual ~Stmt() = default; 
     int line = 0;
 };
 struct Expr { 
+    const ExprKind kind;
+    explicit Expr(ExprKind k) : kind(k) {}
     virtual ~Expr() = default; 
     int line = 0;
 };
@@ -23,69 +55,97 @@ struct Expr {
 struct LiteralExpr : Expr {
     std::string value; // Store as string, interpret later
     bool isString;
-    LiteralExpr(std::string v, bool isStr) : value(v), isString(isStr) {}
+    Value constant;       // Pre-built runtime value (optimizer.cpp)
+    bool decoded = false;
+    LiteralExpr(std::string v, bool isStr) : Expr(ExprKind::Literal), value(std::move(v)), isString(isStr) {}
+    // Result of constant folding
+    LiteralExpr(Value v) : Expr(ExprKind::Literal), value(v.toString()), isString(!v.isNumber()), constant(v), decoded(true) {}
 };
 
 struct VarExpr : Expr {
     std::string name;
-    VarExpr(std::string n) : name(n) {}
+    Atom atom;
+    static const int Global = -2; // `depth` of a name no enclosing scope declares
+    int depth = -1; // Scope hops to the declaring frame (resolver.cpp); -1 = look up by name
+    int slot = -1;  // Global: read and written in the globals directly, past every frame
+    VarExpr(std::string n) : Expr(ExprKind::Var), name(std::move(n)), atom(intern(name)) {}
 };
 
 struct CallExpr : Expr {
     std::shared_ptr<Expr> callee; // Changed from string to Expr
     std::vector<std::shared_ptr<Expr>> args;
-    CallExpr(std::shared_ptr<Expr> c, std::vector<std::shared_ptr<Expr>> a) : callee(c), args(a) {}
+    CallExpr(std::shared_ptr<Expr> c, std::vector<std::shared_ptr<Expr>> a) : Expr(ExprKind::Call), callee(std::move(c)), args(std::move(a)) {}
 };
 
 struct MemberExpr : Expr {
     std::shared_ptr<Expr> object;
     std::shared_ptr<Expr> property;
     bool computed; // true for [], false for .
-    MemberExpr(std::shared_ptr<Expr> o, std::shared_ptr<Expr> p, bool c) : object(o), property(p), computed(c) {}
+    Atom key = 0;  // Property name when not computed
+    std::unique_ptr<InlineCache> cache; // Instance lookups at this site, created on first use
+    MemberExpr(std::shared_ptr<Expr> o, std::shared_ptr<Expr> p, bool c) : Expr(ExprKind::Member), object(std::move(o)), property(std::move(p)), computed(c) {
+        if (!computed && property->kind == ExprKind::Literal) key = intern(static_cast<LiteralExpr*>(property.get())->value);
+        else if (!computed && property->kind == ExprKind::Var) key = static_cast<VarExpr*>(property.get())->atom;
+    }
 };
 
 struct ObjectExpr : Expr {
-    std::map<std::string, std::shared_ptr<Expr>> properties;
-    ObjectExpr(std::map<std::string, std::shared_ptr<Expr>> p) : properties(p) {}
+    struct Property {
+        Atom key;
+        std::shared_ptr<Expr> value;
+        bool spread; // `...obj` entry, value is a SpreadExpr
+    };
+    std::vector<Property> properties; // In key order
+    // Entries in source order. A repeated key keeps its last value.
+    ObjectExpr(std::vector<std::pair<std::string, std::shared_ptr<Expr>>> entries) : Expr(ExprKind::Object) {
+        std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        properties.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first) continue;
+            auto& [key, value] = entries[i];
+            properties.push_back({intern(key), std::move(value), key.compare(0, 9, "__spread_") == 0});
+        }
+    }
 };
 
 struct ArrayExpr : Expr {
     std::vector<std::shared_ptr<Expr>> elements;
-    ArrayExpr(std::vector<std::shared_ptr<Expr>> e) : elements(e) {}
+    ArrayExpr(std::vector<std::shared_ptr<Expr>> e) : Expr(ExprKind::Array), elements(std::move(e)) {}
 };
 
 struct SpreadExpr : Expr {
     std::shared_ptr<Expr> argument;
-    SpreadExpr(std::shared_ptr<Expr> arg) : argument(arg) {}
+    SpreadExpr(std::shared_ptr<Expr> arg) : Expr(ExprKind::Spread), argument(std::move(arg)) {}
 };
 
 struct ThisExpr : Expr {
+    ThisExpr() : Expr(ExprKind::This) {}
     // keyword is 'this'
 };
 
 struct SuperExpr : Expr {
     Token keyword;
     std::shared_ptr<Expr> property; // for super.method()
-    SuperExpr(Token k, std::shared_ptr<Expr> p = nullptr) : keyword(k), property(p) {}
+    SuperExpr(Token k, std::shared_ptr<Expr> p = nullptr) : Expr(ExprKind::Super), keyword(k), property(std::move(p)) {}
 };
 
 struct NewExpr : Expr {
     std::string className;
     std::vector<std::shared_ptr<Expr>> args;
-    NewExpr(std::string name, std::vector<std::shared_ptr<Expr>> a) : className(name), args(a) {}
+    NewExpr(std::string name, std::vector<std::shared_ptr<Expr>> a) : Expr(ExprKind::New), className(std::move(name)), args(std::move(a)) {}
 };
 
 struct UnaryExpr : Expr {
-    std::string op;
+    UnaryOp op;
     std::shared_ptr<Expr> right;
-    UnaryExpr(std::string o, std::shared_ptr<Expr> r) : op(o), right(r) {}
+    UnaryExpr(UnaryOp o, std::shared_ptr<Expr> r) : Expr(ExprKind::Unary), op(o), right(std::move(r)) {}
 };
 
 struct BinaryExpr : Expr {
     std::shared_ptr<Expr> left;
-    std::string op;
+    BinaryOp op;
     std::shared_ptr<Expr> right;
-    BinaryExpr(std::shared_ptr<Expr> l, std::string o, std::shared_ptr<Expr> r) : left(l), op(o), right(r) {}
+    BinaryExpr(std::shared_ptr<Expr> l, BinaryOp o, std::shared_ptr<Expr> r) : Expr(ExprKind::Binary), left(std::move(l)), op(o), right(std::move(r)) {}
 };
 
 struct TernaryExpr : Expr {
@@ -93,18 +153,36 @@ struct TernaryExpr : Expr {
     std::shared_ptr<Expr> trueExpr;
     std::shared_ptr<Expr> falseExpr;
     TernaryExpr(std::shared_ptr<Expr> c, std::shared_ptr<Expr> t, std::shared_ptr<Expr> f) 
-        : condition(c), trueExpr(t), falseExpr(f) {}
+        : Expr(ExprKind::Ternary), condition(std::move(c)), trueExpr(std::move(t)), falseExpr(std::move(f)) {}
 };
 
 // Statements
+
+// Function body the parser only brace-matched (see Parser::functionBody). Its statements are
+// parsed from the module source when the function is first called (Interpreter::prepare).
+struct LazyBody {
+    std::shared_ptr<const std::string> source; // The whole module
+    AstArena* arena;  // The module's; the body's own node keeps it alive
+    size_t begin;     // Offset of the `{`
+    size_t end;       // Just past the `}`
+    int line;         // Of the `{`
+    std::string file; // Module path, set by the resolver (function names in traces)
+};
+
 struct BlockStmt : Stmt {
     std::vector<std::shared_ptr<Stmt>> statements;
+    std::shared_ptr<std::vector<Atom>> locals; // Slot names of this scope (resolver.cpp)
+    std::shared_ptr<Chunk> compiled; // Bytecode, filled on first run
+    std::unique_ptr<LazyBody> lazy;  // Set while `statements` are not parsed yet
+    BlockStmt() : Stmt(StmtKind::Block) {}
 };
 
 struct VarDeclStmt : Stmt {
     std::string name;
+    Atom atom;
     std::shared_ptr<Expr> initializer;
-    VarDeclStmt(std::string n, std::shared_ptr<Expr> i) : name(n), initializer(i) {}
+    int slot = -1; // Slot in the current frame; -1 = define by name (top level)
+    VarDeclStmt(std::string n, std::shared_ptr<Expr> i) : Stmt(StmtKind::VarDecl), name(std::move(n)), atom(intern(name)), initializer(std::move(i)) {}
 };
 
 struct IfStmt : Stmt {
@@ -112,13 +190,20 @@ struct IfStmt : Stmt {
     std::shared_ptr<Stmt> thenBranch;
     std::shared_ptr<Stmt> elseBranch;
     IfStmt(std::shared_ptr<Expr> c, std::shared_ptr<Stmt> t, std::shared_ptr<Stmt> e = nullptr) 
-        : condition(c), thenBranch(t), elseBranch(e) {}
+        : Stmt(StmtKind::If), condition(std::move(c)), thenBranch(std::move(t)), elseBranch(std::move(e)) {}
 };
 
 struct WhileStmt : Stmt {
     std::shared_ptr<Expr> condition;
     std::shared_ptr<Stmt> body;
-    WhileStmt(std::shared_ptr<Expr> c, std::shared_ptr<Stmt> b) : condition(c), body(b) {}
+    Atom label = NoAtom; // `name: while (...)`, targeted by `break name` / `continue name`
+    WhileStmt(std::shared_ptr<Expr> c, std::shared_ptr<Stmt> b) : Stmt(StmtKind::While), condition(std::move(c)), body(std::move(b)) {}
+};
+
+// `break` or `continue` (kind), optionally naming a labelled loop
+struct JumpStmt : Stmt {
+    Atom label = NoAtom; // NoAtom: the innermost loop (or switch, for break)
+    JumpStmt(StmtKind k, Atom l) : Stmt(k), label(l) {}
 };
 
 struct Case {
@@ -129,20 +214,48 @@ struct Case {
 struct SwitchStmt : Stmt {
     std::shared_ptr<Expr> condition;
     std::vector<Case> cases;
-    SwitchStmt(std::shared_ptr<Expr> c, std::vector<Case> cs) : condition(c), cases(cs) {}
+    SwitchStmt(std::shared_ptr<Expr> c, std::vector<Case> cs) : Stmt(StmtKind::Switch), condition(std::move(c)), cases(std::move(cs)) {}
+};
+
+// Declared parameter, built once by the parser: `a`, `a = 1`, `{a, b}`, `[a, b]` or `...rest`.
+// The resolver gives every bound name its frame slot, so a call binds arguments by index
+// (see Interpreter::bindParams).
+struct Param {
+    enum Kind : uint8_t { Name, Object, Array, Rest };
+    struct Binding {
+        std::string name; // Also the property key for object patterns
+        Atom atom;
+        int slot = -1;
+    };
+    Kind kind = Name;
+    std::vector<Binding> names;         // The parameter itself, or one per pattern property/element
+    std::shared_ptr<Expr> defaultValue; // Used when the argument is missing or undefined
+    
+    static Param named(const std::string& name) {
+        Param p;
+        p.names.push_back({name, intern(name)});
+        return p;
+    }
 };
 
+inline ParamList namedParams(const std::vector<std::string>& names) {
+    auto params = std::make_shared<std::vector<Param>>();
+    for (auto& n : names) params->push_back(Param::named(n));
+    return params;
+}
+
 struct FuncDeclStmt : Stmt {
     std::string name;
-    std::vector<std::string> params; // Added params
+    ParamList params;
     std::shared_ptr<BlockStmt> body;
-    FuncDeclStmt(std::string n, std::vector<std::string> p, std::shared_ptr<BlockStmt> b) : name(n), params(p), body(b) {}
-    FuncDeclStmt(std::string n, std::shared_ptr<BlockStmt> b) : name(n), body(b) {} // Legacy
+    FuncDeclStmt(std::string n, ParamList p, std::shared_ptr<BlockStmt> b) : Stmt(StmtKind::FuncDecl), name(std::move(n)), params(std::move(p)), body(std::move(b)) {}
+    FuncDeclStmt(std::string n, std::shared_ptr<BlockStmt> b) : Stmt(StmtKind::FuncDecl), name(n), params(namedParams({})), body(b) {} // Legacy
 };
 
 struct ReturnStmt : Stmt {
      std::shared_ptr<Expr> value;
-     ReturnStmt(std::shared_ptr<Expr> v) : value(v) {}
+     bool tailCall = false; // `return f(...)` whose call can reuse this frame (set by the resolver)
+     ReturnStmt(std::shared_ptr<Expr> v) : Stmt(StmtKind::Return), value(std::move(v)) {}
 };
 
 struct JsxExpr : Expr {
@@ -150,14 +263,14 @@ struct JsxExpr : Expr {
     std::map<std::string, std::shared_ptr<Expr>> attributes;
     std::vector<std::shared_ptr<Expr>> children;
     JsxExpr(std::string t, std::map<std::string, std::shared_ptr<Expr>> a, std::vector<std::shared_ptr<Expr>> c)
-      : tagName(t), attributes(a), children(c) {}
+      : Expr(ExprKind::Jsx), tagName(std::move(t)), attributes(std::move(a)), children(std::move(c)) {}
 };
 
 struct FunctionExpr : Expr {
-    std::vector<std::string> params; // Added params
+    ParamList params;
     std::shared_ptr<BlockStmt> body;
-    FunctionExpr(std::vector<std::string> p, std::shared_ptr<BlockStmt> b) : params(p), body(b) {}
-    FunctionExpr(std::shared_ptr<BlockStmt> b) : body(b) {} // Legacy
+    FunctionExpr(ParamList p, std::shared_ptr<BlockStmt> b) : Expr(ExprKind::Function), params(std::move(p)), body(std::move(b)) {}
+    FunctionExpr(std::shared_ptr<BlockStmt> b) : Expr(ExprKind::Function), params(namedParams({})), body(b) {} // Legacy
 };
 
 // Imports
@@ -165,29 +278,29 @@ struct ImportStmt : Stmt {
     std::string moduleName; // "app" or "gui"
     std::vector<std::string> symbols; // for { x, y }
     // If symbols is empty, it's import "mod" (run whole thing)
-    ImportStmt(std::string m, std::vector<std::string> s = {}) : moduleName(m), symbols(s) {}
+    ImportStmt(std::string m, std::vector<std::string> s = {}) : Stmt(StmtKind::Import), moduleName(std::move(m)), symbols(std::move(s)) {}
 };
 
 struct DestructureStmt : Stmt {
     std::vector<std::string> names;
     std::shared_ptr<Expr> initializer;
-    DestructureStmt(std::vector<std::string> n, std::shared_ptr<Expr> i) : names(n), initializer(i) {}
+    DestructureStmt(std::vector<std::string> n, std::shared_ptr<Expr> i) : Stmt(StmtKind::Destructure), names(std::move(n)), initializer(std::move(i)) {}
 };
 
 struct ExportStmt : Stmt {
     std::shared_ptr<Stmt> declaration;
-    ExportStmt(std::shared_ptr<Stmt> d) : declaration(d) {}
+    ExportStmt(std::shared_ptr<Stmt> d) : Stmt(StmtKind::Export), declaration(std::move(d)) {}
 };
 
 struct ExprStmt : Stmt {
     std::shared_ptr<Expr> expr;
-    ExprStmt(std::shared_ptr<Expr> e) : expr(e) {}
+    ExprStmt(std::shared_ptr<Expr> e) : Stmt(StmtKind::Expr), expr(std::move(e)) {}
 };
 
 struct ClassStmt : Stmt {
     struct Method {
         std::string name;
-        std::vector<std::string> params;
+        ParamList params;
         std::shared_ptr<BlockStmt> body;
         bool isStatic = false;
         bool isGetter = false;
@@ -207,7 +320,7 @@ struct ClassStmt : Stmt {
     std::vector<Method> methods;
     std::vector<Field> fields;
     
-    ClassStmt(std::string n, std::string s = "") : name(n), superclass(s) {}
+    ClassStmt(std::string n, std::string s = "") : Stmt(StmtKind::Class), name(std::move(n)), superclass(std::move(s)) {}
 };
 
 struct TryStmt : Stmt {
@@ -217,46 +330,77 @@ struct TryStmt : Stmt {
     std::string catchVar;
 
     TryStmt(std::shared_ptr<BlockStmt> tryB, std::shared_ptr<BlockStmt> catchB, std::shared_ptr<BlockStmt> finalB, std::string cVar)
-        : tryBlock(tryB), catchBlock(catchB), finallyBlock(finalB), catchVar(cVar) {}
+        : Stmt(StmtKind::Try), tryBlock(std::move(tryB)), catchBlock(std::move(catchB)), finallyBlock(std::move(finalB)), catchVar(std::move(cVar)) {}
 };
 
 struct ThrowStmt : Stmt {
     std::shared_ptr<Expr> expression;
-    ThrowStmt(std::shared_ptr<Expr> expr) : expression(expr) {}
+    ThrowStmt(std::shared_ptr<Expr> expr) : Stmt(StmtKind::Throw), expression(std::move(expr)) {}
 };
 
 class Parser {
     std::vector<Token> tokens;
     size_t current = 0;
+    AstArena* arena; // Nodes of this parse (ast_arena.h)
+    std::shared_ptr<const std::string> source; // Set when function bodies may be deferred
+    // Blocks, function bodies and parameter lists open at the current token. Bodies are only
+    // deferred at 0 (the module's top level), where the resolver has no enclosing scope for them.
+    int nesting = 0;
 public:
-    Parser(const std::vector<Token>& t) : tokens(t) {}
+    Parser(std::vector<Token> t) : tokens(std::move(t)), arena(AstArena::create()) {}
+    // Parses top-level function, method and arrow bodies lazily (LazyBody): they are only
+    // brace-matched here. `src` is the text the tokens were read from.
+    Parser(std::vector<Token> t, std::shared_ptr<const std::string> src)
+        : tokens(std::move(t)), arena(AstArena::create()), source(std::move(src)) {}
+    Parser(const Parser&) = delete;
+    ~Parser() { arena->release(); }
     std::vector<std::shared_ptr<Stmt>> parse();
+
+    // Parses a body left lazy, in place; functions inside it are parsed with it.
+    // Throws, leaving the body lazy, on a syntax error.
+    static void parseDeferred(BlockStmt& body);
+
+    size_t deferredBodies = 0; // Bodies parse() left lazy
+    size_t deferredBytes = 0;  // Their length
 private:
+    Parser(std::vector<Token> t, AstArena* a) : tokens(std::move(t)), arena(a) { arena->retain(); }
+
+    template <class T, class... Args>
+    std::shared_ptr<T> node(Args&&... args) { return makeNode<T>(arena, std::forward<Args>(args)...); }
+
     std::shared_ptr<Stmt> declaration();
     std::shared_ptr<Stmt> statement();
     std::shared_ptr<Expr> expression();
     std::shared_ptr<Expr> assignment();
-    std::shared_ptr<Expr> logicalOr();
-    std::shared_ptr<Expr> logicalAnd();
-    std::shared_ptr<Expr> equality();
-    std::shared_ptr<Expr> comparison();
-    std::shared_ptr<Expr> term();
-    std::shared_ptr<Expr> factor();
+    std::shared_ptr<Expr> binary(int minPrecedence); // Binary operators binding at least this tightly
     std::shared_ptr<Expr> unary();
     std::shared_ptr<Expr> call(); // Added
     std::shared_ptr<Expr> primary();
     
-    bool match(TokenType t);
-    Token consume(TokenType t, std::string err);
+    const Token& consume(TokenType t, const char* err);
     std::shared_ptr<CallExpr> finishCall(std::string name);
-    Token peek();
-    Token peekNext();
-    bool isAtEnd();
+    ParamList parameters(); // `(` consumed; parses through `)`
+    // Statements through the closing `}`, the `{` consumed. functionBody() may defer them.
+    std::shared_ptr<BlockStmt> blockBody(const char* err);
+    std::shared_ptr<BlockStmt> functionBody(const char* err);
+    std::shared_ptr<BlockStmt> arrowBody();
+    void statementsInto(BlockStmt& block, const char* err);
     
-    // Missing helpers
-    bool check(TokenType t);
-    Token advance();
-    Token previous();
+    // Token cursor; inline, since every parse function tests tokens with these
+    const Token& peek() const { return tokens[current]; }
+    const Token& previous() const { return tokens[current - 1]; }
+    const Token& peekNext() const { return isAtEnd() ? peek() : tokens[current + 1]; }
+    bool isAtEnd() const { return peek().type == TOK_EOF; }
+    bool check(TokenType t) const { return !isAtEnd() && peek().type == t; }
+    const Token& advance() {
+        if (!isAtEnd()) current++;
+        return previous();
+    }
+    bool match(TokenType t) {
+        if (!check(t)) return false;
+        advance();
+        return true;
+    }
 };
 
 #endif
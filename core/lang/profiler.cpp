@@ -0,0 +1,217 @@
+#include "profiler.h"
+#include "debugger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+namespace {
+
+// Samples as the signal handler writes them: a frame count, then that many function pointers,
+// outermost first. Single producer (the handler) and single consumer (drain()), both on the
+// interpreter thread, so the two indexes only need to be atomic against the interruption.
+const size_t RingWords = 1 << 20;
+std::vector<uintptr_t> ring;
+std::atomic<uint64_t> ringHead{0};
+std::atomic<uint64_t> ringTail{0};
+std::atomic<uint64_t> dropped{0}; // Ring full
+thread_local bool sampledThread = false;
+volatile std::sig_atomic_t reportRequested = 0;
+
+bool running = false;
+double cpuStartMs = 0;
+std::string rootFrame;
+uint64_t sampleCount = 0;
+std::map<std::vector<const void*>, uint64_t> stacks;
+std::unordered_map<const void*, uint64_t> calls;
+
+void drain() {
+    uint64_t head = ringHead.load(std::memory_order_acquire);
+    uint64_t tail = ringTail.load(std::memory_order_relaxed);
+    std::vector<const void*> stack;
+    while (tail < head) {
+        size_t frames = ring[tail % RingWords];
+        stack.clear();
+        for (size_t i = 1; i <= frames; i++) stack.push_back(reinterpret_cast<const void*>(ring[(tail + i) % RingWords]));
+        stacks[stack]++;
+        sampleCount++;
+        tail += frames + 1;
+    }
+    ringTail.store(tail, std::memory_order_release);
+}
+
+#ifndef _WIN32
+void onSample(int) {
+    if (!sampledThread) return; // Timer signals can land on any thread
+    size_t frames = (size_t)std::min(Debugger::callDepth, Debugger::MaxCallRecords);
+    uint64_t head = ringHead.load(std::memory_order_relaxed);
+    if (head + frames + 1 - ringTail.load(std::memory_order_acquire) > RingWords) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring[head % RingWords] = frames;
+    for (size_t i = 0; i < frames; i++) {
+        ring[(head + 1 + i) % RingWords] = reinterpret_cast<uintptr_t>(Debugger::callRecords[i].function);
+    }
+    ringHead.store(head + frames + 1, std::memory_order_release);
+}
+
+void onReportSignal(int) {
+    reportRequested = 1;
+}
+#endif
+
+// CPU time of the calling thread. The kernel may deliver the timer at a coarser rate than asked
+// for (its tick), so sample times are measured rather than assumed to be 1/hz each.
+double threadCpuMs() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+#else
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void report();
+
+void onCall(const void* function) {
+    calls[function]++;
+    if (reportRequested) {
+        reportRequested = 0;
+        report();
+    } else if (ringHead.load(std::memory_order_relaxed) - ringTail.load(std::memory_order_relaxed) > RingWords / 2) {
+        drain();
+    }
+}
+
+// "name (file:line)", from the last path component; ';' separates frames in folded stacks
+std::string frameName(const void* function) {
+    const Debugger::FunctionInfo* info = Debugger::functionInfo(function);
+    std::string frame = info ? info->name : "<anonymous>";
+    if (info && !info->file.empty()) {
+        size_t slash = info->file.find_last_of("/\\");
+        frame += " (" + (slash == std::string::npos ? info->file : info->file.substr(slash + 1));
+        frame += ":" + std::to_string(info->line) + ")";
+    }
+    std::replace(frame.begin(), frame.end(), ';', ',');
+    return frame;
+}
+
+void report() {
+    drain();
+    double cpuMs = threadCpuMs() - cpuStartMs;
+    double msPerSample = sampleCount ? cpuMs / sampleCount : 0;
+
+    std::ofstream out(Profiler::outputPath, std::ios::trunc);
+    std::unordered_map<const void*, std::string> names;
+    auto nameOf = [&](const void* function) -> const std::string& {
+        auto it = names.find(function);
+        if (it == names.end()) it = names.emplace(function, frameName(function)).first;
+        return it->second;
+    };
+
+    // Self: samples with the function innermost. Total: samples with it anywhere on the stack,
+    // once per sample however deep it recurses.
+    struct Times { uint64_t self = 0; uint64_t total = 0; };
+    std::unordered_map<const void*, Times> times;
+    uint64_t rootSelf = 0;
+    std::vector<const void*> seen;
+    for (auto& [stack, count] : stacks) {
+        std::string line = rootFrame;
+        for (const void* function : stack) line += ";" + nameOf(function);
+        if (out) out << line << " " << count << "\n";
+
+        if (stack.empty()) rootSelf += count;
+        else times[stack.back()].self += count;
+        seen.clear();
+        for (const void* function : stack) {
+            if (std::find(seen.begin(), seen.end(), function) != seen.end()) continue;
+            seen.push_back(function);
+            times[function].total += count;
+        }
+    }
+    for (auto& [function, count] : calls) times[function]; // Called but never sampled
+
+    std::vector<std::pair<const void*, Times>> rows(times.begin(), times.end());
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return a.second.self != b.second.self ? a.second.self > b.second.self : a.second.total > b.second.total;
+    });
+
+    char line[512];
+    double all = sampleCount ? (double)sampleCount : 1.0;
+    std::snprintf(line, sizeof(line), "Profile: %llu samples in %.1f ms of CPU time (%.0f Hz, %d asked)",
+                  (unsigned long long)sampleCount, cpuMs, cpuMs > 0 ? sampleCount * 1000.0 / cpuMs : 0.0, Profiler::hz);
+    std::cerr << line;
+    if (dropped) std::cerr << ", " << dropped.load() << " dropped";
+    std::cerr << "; folded stacks in " << Profiler::outputPath << (out ? "" : " (could not write)") << std::endl;
+    std::snprintf(line, sizeof(line), "  %7s %10s %7s %10s %10s  %s", "self%", "self ms", "total%", "total ms", "calls", "function");
+    std::cerr << line << std::endl;
+    std::snprintf(line, sizeof(line), "  %6.2f%% %10.1f %6.2f%% %10.1f %10s  %s", 100.0 * rootSelf / all, rootSelf * msPerSample,
+                  sampleCount ? 100.0 : 0.0, sampleCount * msPerSample, "", (rootFrame + " (top level)").c_str());
+    std::cerr << line << std::endl;
+    for (auto& [function, t] : rows) {
+        auto called = calls.find(function);
+        std::snprintf(line, sizeof(line), "  %6.2f%% %10.1f %6.2f%% %10.1f %10llu  %s", 100.0 * t.self / all, t.self * msPerSample,
+                      100.0 * t.total / all, t.total * msPerSample,
+                      (unsigned long long)(called != calls.end() ? called->second : 0), nameOf(function).c_str());
+        std::cerr << line << std::endl;
+    }
+}
+
+} // namespace
+
+void Profiler::start(const std::string& mainFile) {
+    if (hz <= 0 || running) return;
+#ifdef _WIN32
+    std::cerr << "[Profiler] --profile is not supported on Windows" << std::endl;
+    hz = 0;
+#else
+    size_t slash = mainFile.find_last_of("/\\");
+    rootFrame = slash == std::string::npos ? mainFile : mainFile.substr(slash + 1);
+    ring.assign(RingWords, 0);
+    sampledThread = true;
+    cpuStartMs = threadCpuMs();
+    Debugger::callHook = onCall;
+    Debugger::functionInfo(nullptr); // Build the name table first: it must outlive the atexit report
+    std::atexit(stop);
+
+    struct sigaction action = {};
+    action.sa_handler = onSample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+    action.sa_handler = onReportSignal;
+    sigaction(SIGUSR1, &action, nullptr);
+
+    struct itimerval timer = {};
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = std::max(1, 1000000 / hz);
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    running = true;
+#endif
+}
+
+void Profiler::stop() {
+    if (!running) return;
+    running = false;
+#ifndef _WIN32
+    struct itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    signal(SIGPROF, SIG_IGN);
+#endif
+    Debugger::callHook = nullptr;
+    report();
+}
@@ -0,0 +1,23 @@
+#ifndef ANIS_PROFILER_H
+#define ANIS_PROFILER_H
+
+#include <string>
+
+// Sampling profiler for scripts (--profile[=hz]). A CPU-time timer interrupts the interpreter
+// thread `hz` times a second and copies its script call stack (the Debugger's call records)
+// into a ring buffer; the interpreter thread folds the samples into per-stack counts between
+// calls, and counts the calls themselves. On exit, or at the next call after SIGUSR1, it writes
+// the folded stacks (one "root;caller;callee count" line per stack, the input format of
+// flamegraph.pl, speedscope and inferno) and prints each function's self and total time.
+class Profiler {
+public:
+    static inline int hz = 0;                            // 0: not profiling
+    static inline std::string outputPath = "anis.folded"; // --profile-out
+
+    // Start sampling the calling thread, the one about to run `mainFile`
+    static void start(const std::string& mainFile);
+    // Stop sampling and report; safe to call more than once (runs again from atexit)
+    static void stop();
+};
+
+#endif
@@ -0,0 +1,322 @@
+#include "resolver.h"
+#include "debugger.h"
+#include <algorithm>
+
+void Resolver::resolve(const std::vector<std::shared_ptr<Stmt>>& statements) {
+    scopes.clear();
+    functionStarts.clear();
+    jumpTargets.clear();
+    for (auto& s : statements) {
+        if (s) statement(s.get());
+    }
+}
+
+int Resolver::declare(Atom name) {
+    if (scopes.empty()) return -1; // Top level: globals are defined by name
+    auto& locals = *scopes.back().locals;
+    for (size_t i = 0; i < locals.size(); i++) {
+        if (locals[i] == name) return (int)i;
+    }
+    locals.push_back(name);
+    return (int)locals.size() - 1;
+}
+
+// Declarations are hoisted to the start of their scope, so closures created earlier
+// in the block still see them. Non-block bodies of if/while declare into this scope.
+// Until its statement runs, a hoisted name is pending: uses in the same function
+// skip it and see the enclosing binding, as they did when locals were defined by name.
+void Resolver::hoist(Stmt* stmt) {
+    if (!stmt) return;
+    switch (stmt->kind) {
+        case StmtKind::VarDecl:
+            declare(static_cast<VarDeclStmt*>(stmt)->atom);
+            break;
+        case StmtKind::Destructure:
+            for (auto& n : static_cast<DestructureStmt*>(stmt)->names) declare(intern(n));
+            break;
+        case StmtKind::Class:
+            declare(intern(static_cast<ClassStmt*>(stmt)->name));
+            break;
+        case StmtKind::Export:
+            hoist(static_cast<ExportStmt*>(stmt)->declaration.get());
+            break;
+        case StmtKind::If: {
+            auto* ifStmt = static_cast<IfStmt*>(stmt);
+            if (ifStmt->thenBranch && ifStmt->thenBranch->kind != StmtKind::Block) hoist(ifStmt->thenBranch.get());
+            if (ifStmt->elseBranch && ifStmt->elseBranch->kind != StmtKind::Block) hoist(ifStmt->elseBranch.get());
+            break;
+        }
+        case StmtKind::While: {
+            auto* whileStmt = static_cast<WhileStmt*>(stmt);
+            if (whileStmt->body && whileStmt->body->kind != StmtKind::Block) hoist(whileStmt->body.get());
+            break;
+        }
+        default:
+            // Function declarations always bind in globals
+            break;
+    }
+}
+
+void Resolver::block(BlockStmt* block, const std::vector<Atom>& preset) {
+    block->locals = std::make_shared<std::vector<Atom>>(preset);
+    scopes.push_back({block->locals.get(), {}});
+    for (auto& s : block->statements) hoist(s.get());
+    auto& locals = *block->locals;
+    scopes.back().pending.assign(locals.begin() + preset.size(), locals.end());
+    for (auto& s : block->statements) {
+        if (s) statement(s.get());
+    }
+    scopes.pop_back();
+}
+
+void Resolver::settle(Atom name) {
+    if (scopes.empty()) return;
+    auto& pending = scopes.back().pending;
+    pending.erase(std::remove(pending.begin(), pending.end(), name), pending.end());
+}
+
+void Resolver::name(const std::shared_ptr<BlockStmt>& body, const std::string& name, int line) {
+    if (body) Debugger::nameFunction(body.get(), name, file, line);
+}
+
+// Parameters and the body's top-level declarations share one frame (see Interpreter::callClosure).
+// Each parameter name takes the next slot; defaults are resolved inside that frame.
+void Resolver::function(const ParamList& params, BlockStmt* body) {
+    if (!body) return;
+    if (body->lazy) {
+        // Resolved as a top-level function once parsed. The parser defers no body with an
+        // enclosing scope; should one get here, it is parsed now.
+        if (scopes.empty()) {
+            body->lazy->file = file;
+            return;
+        }
+        Parser::parseDeferred(*body);
+    }
+    std::vector<Atom> names;
+    if (params) {
+        for (auto& p : *params) {
+            for (auto& b : p.names) {
+                auto it = std::find(names.begin(), names.end(), b.atom);
+                b.slot = (int)(it - names.begin());
+                if (it == names.end()) names.push_back(b.atom);
+            }
+        }
+        scopes.push_back({&names, {}});
+        for (auto& p : *params) {
+            if (p.defaultValue) expression(p.defaultValue.get());
+        }
+        scopes.pop_back();
+    }
+    tryDepths.push_back(0);
+    std::vector<JumpTarget> outer;
+    outer.swap(jumpTargets); // break/continue never cross a function boundary
+    functionStarts.push_back(scopes.size());
+    block(body, names);
+    functionStarts.pop_back();
+    jumpTargets.swap(outer);
+    tryDepths.pop_back();
+}
+
+void Resolver::jump(JumpStmt* stmt) {
+    bool isBreak = stmt->kind == StmtKind::Break;
+    for (auto& target : jumpTargets) {
+        // Only loops carry labels; a plain continue skips switches
+        if (stmt->label != NoAtom ? target.label == stmt->label : (target.isLoop || isBreak)) return;
+    }
+    std::string keyword = isBreak ? "break" : "continue";
+    if (stmt->label != NoAtom) {
+        Debugger::parseError("Undefined loop label '" + atomName(stmt->label) + "' for " + keyword + ".", atomName(stmt->label), stmt->line);
+    } else {
+        Debugger::parseError("Illegal " + keyword + " statement: no surrounding " + (isBreak ? "loop or switch." : "loop."), keyword, stmt->line);
+    }
+}
+
+void Resolver::statement(Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::Block:
+            block(static_cast<BlockStmt*>(stmt));
+            break;
+        case StmtKind::VarDecl: {
+            auto* varDecl = static_cast<VarDeclStmt*>(stmt);
+            if (varDecl->initializer && varDecl->initializer->kind == ExprKind::Function) {
+                auto* func = static_cast<FunctionExpr*>(varDecl->initializer.get());
+                name(func->body, varDecl->name, varDecl->line);
+                function(func->params, func->body.get());
+            } else if (varDecl->initializer) {
+                expression(varDecl->initializer.get());
+            }
+            varDecl->slot = declare(varDecl->atom);
+            settle(varDecl->atom);
+            break;
+        }
+        case StmtKind::Destructure: {
+            auto* destructure = static_cast<DestructureStmt*>(stmt);
+            expression(destructure->initializer.get());
+            for (auto& n : destructure->names) settle(intern(n));
+            break;
+        }
+        case StmtKind::Export:
+            statement(static_cast<ExportStmt*>(stmt)->declaration.get());
+            break;
+        case StmtKind::Return: {
+            auto* ret = static_cast<ReturnStmt*>(stmt);
+            if (ret->value) expression(ret->value.get());
+            // A handler must stay on the stack for a call made inside try/catch/finally
+            ret->tailCall = ret->value && ret->value->kind == ExprKind::Call &&
+                            !tryDepths.empty() && tryDepths.back() == 0;
+            break;
+        }
+        case StmtKind::FuncDecl: {
+            auto* funcDecl = static_cast<FuncDeclStmt*>(stmt);
+            name(funcDecl->body, funcDecl->name, funcDecl->line);
+            function(funcDecl->params, funcDecl->body.get());
+            break;
+        }
+        case StmtKind::If: {
+            auto* ifStmt = static_cast<IfStmt*>(stmt);
+            expression(ifStmt->condition.get());
+            if (ifStmt->thenBranch) statement(ifStmt->thenBranch.get());
+            if (ifStmt->elseBranch) statement(ifStmt->elseBranch.get());
+            break;
+        }
+        case StmtKind::While: {
+            auto* whileStmt = static_cast<WhileStmt*>(stmt);
+            expression(whileStmt->condition.get());
+            jumpTargets.push_back({whileStmt->label, true});
+            if (whileStmt->body) statement(whileStmt->body.get());
+            jumpTargets.pop_back();
+            break;
+        }
+        case StmtKind::Switch: {
+            auto* switchStmt = static_cast<SwitchStmt*>(stmt);
+            expression(switchStmt->condition.get());
+            jumpTargets.push_back({NoAtom, false});
+            for (auto& cs : switchStmt->cases) {
+                if (cs.value) expression(cs.value.get());
+                if (cs.body) statement(cs.body.get());
+            }
+            jumpTargets.pop_back();
+            break;
+        }
+        case StmtKind::Class: {
+            auto* classStmt = static_cast<ClassStmt*>(stmt);
+            settle(intern(classStmt->name)); // Methods may refer to their own class
+            for (auto& m : classStmt->methods) {
+                name(m.body, classStmt->name + "." + m.name, classStmt->line);
+                function(m.params, m.body.get());
+            }
+            // Field initializers run in the scope of the 'new' expression, so resolve them on their own
+            std::vector<Scope> saved;
+            saved.swap(scopes);
+            for (auto& f : classStmt->fields) {
+                if (f.initializer) expression(f.initializer.get());
+            }
+            scopes.swap(saved);
+            break;
+        }
+        case StmtKind::Try: {
+            auto* tryStmt = static_cast<TryStmt*>(stmt);
+            if (!tryDepths.empty()) tryDepths.back()++;
+            if (tryStmt->tryBlock) block(tryStmt->tryBlock.get());
+            if (tryStmt->catchBlock) block(tryStmt->catchBlock.get(), {intern(tryStmt->catchVar)});
+            if (tryStmt->finallyBlock) block(tryStmt->finallyBlock.get());
+            if (!tryDepths.empty()) tryDepths.back()--;
+            break;
+        }
+        case StmtKind::Throw:
+            expression(static_cast<ThrowStmt*>(stmt)->expression.get());
+            break;
+        case StmtKind::Expr:
+            expression(static_cast<ExprStmt*>(stmt)->expr.get());
+            break;
+        case StmtKind::Break:
+        case StmtKind::Continue:
+            jump(static_cast<JumpStmt*>(stmt));
+            break;
+        case StmtKind::Import:
+            break;
+    }
+}
+
+void Resolver::expression(Expr* expr) {
+    if (!expr) return;
+    switch (expr->kind) {
+        case ExprKind::Var: {
+            auto* var = static_cast<VarExpr*>(expr);
+            // Scopes of this function (not of enclosing ones, whose closures run later) skip
+            // names declared further on
+            int start = functionStarts.empty() ? 0 : (int)functionStarts.back();
+            for (int i = (int)scopes.size() - 1; i >= 0; i--) {
+                auto& pending = scopes[i].pending;
+                if (i >= start && std::find(pending.begin(), pending.end(), var->atom) != pending.end()) continue;
+                auto& locals = *scopes[i].locals;
+                for (size_t j = 0; j < locals.size(); j++) {
+                    if (locals[j] == var->atom) {
+                        var->depth = (int)scopes.size() - 1 - i;
+                        var->slot = (int)j;
+                        return;
+                    }
+                }
+            }
+            // Inside a scope, a name none of them declares is a global or native. At the top
+            // level (and in field initializers) it stays a lookup by name.
+            if (!scopes.empty()) var->depth = VarExpr::Global;
+            break;
+        }
+        case ExprKind::Call: {
+            auto* call = static_cast<CallExpr*>(expr);
+            expression(call->callee.get());
+            for (auto& a : call->args) expression(a.get());
+            break;
+        }
+        case ExprKind::Member: {
+            auto* mem = static_cast<MemberExpr*>(expr);
+            expression(mem->object.get());
+            if (mem->computed) expression(mem->property.get()); // Otherwise the property is a name, not a variable
+            break;
+        }
+        case ExprKind::Object:
+            for (auto& prop : static_cast<ObjectExpr*>(expr)->properties) expression(prop.value.get());
+            break;
+        case ExprKind::Array:
+            for (auto& e : static_cast<ArrayExpr*>(expr)->elements) expression(e.get());
+            break;
+        case ExprKind::Spread:
+            expression(static_cast<SpreadExpr*>(expr)->argument.get());
+            break;
+        case ExprKind::New:
+            for (auto& a : static_cast<NewExpr*>(expr)->args) expression(a.get());
+            break;
+        case ExprKind::Unary:
+            expression(static_cast<UnaryExpr*>(expr)->right.get());
+            break;
+        case ExprKind::Binary: {
+            auto* bin = static_cast<BinaryExpr*>(expr);
+            expression(bin->left.get());
+            expression(bin->right.get());
+            break;
+        }
+        case ExprKind::Ternary: {
+            auto* ternary = static_cast<TernaryExpr*>(expr);
+            expression(ternary->condition.get());
+            expression(ternary->trueExpr.get());
+            expression(ternary->falseExpr.get());
+            break;
+        }
+        case ExprKind::Jsx: {
+            auto* jsx = static_cast<JsxExpr*>(expr);
+            for (auto& attr : jsx->attributes) expression(attr.second.get());
+            for (auto& c : jsx->children) expression(c.get());
+            break;
+        }
+        case ExprKind::Function: {
+            auto* func = static_cast<FunctionExpr*>(expr);
+            name(func->body, "<anonymous>", func->line);
+            function(func->params, func->body.get());
+            break;
+        }
+        default:
+            // Literals, this, super: nothing to resolve
+            break;
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef ANIS_RESOLVER_H
+#define ANIS_RESOLVER_H
+
+#include "parser.h"
+#include <vector>
+#include <string>
+
+// Static scope analysis, run once on parsed statements before execution.
+// Every block gets a table of local slot names, and each VarExpr/VarDeclStmt that refers to a
+// local is annotated with (depth, slot) so the interpreter indexes a flat frame instead of
+// searching maps by name. Globals and natives used inside a scope are marked to be read from
+// the globals directly; top-level code and 'this'/'super' stay dynamic (slot -1).
+class Resolver {
+public:
+    explicit Resolver(std::string file = "") : file(std::move(file)) {}
+    void resolve(const std::vector<std::shared_ptr<Stmt>>& statements);
+    // A function of the module's top level. A body the parser left lazy is skipped here, and
+    // resolved by this once it has been parsed (Interpreter::prepare).
+    void function(const ParamList& params, BlockStmt* body);
+    
+private:
+    std::string file; // Module being resolved, for function names in traces and profiles
+
+    struct Scope {
+        std::vector<Atom>* locals;
+        std::vector<Atom> pending; // Hoisted locals whose declaring statement is still ahead
+    };
+    std::vector<Scope> scopes; // Innermost last; empty at top level
+    std::vector<size_t> functionStarts; // Per enclosing function: index of its first scope
+    std::vector<int> tryDepths; // Per enclosing function: open try statements (no tail calls inside)
+    
+    // Loops and switches enclosing the current statement within its function, innermost last;
+    // break/continue are checked against them
+    struct JumpTarget {
+        Atom label;
+        bool isLoop;
+    };
+    std::vector<JumpTarget> jumpTargets;
+    
+    void statement(Stmt* stmt);
+    void expression(Expr* expr);
+    void block(BlockStmt* block, const std::vector<Atom>& preset = {});
+    void name(const std::shared_ptr<BlockStmt>& body, const std::string& name, int line);
+    void hoist(Stmt* stmt);
+    int declare(Atom name);
+    void settle(Atom name);
+    void jump(JumpStmt* stmt);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef ANIS_SHAPE_H
+#define ANIS_SHAPE_H
+
+#include "value.h"
+#include "atom.h"
+#include <vector>
+#include <unordered_map>
+
+// Hidden class of an Instance: the field names it has, in the order they were added.
+// Every class owns a root (empty) shape; adding a field follows a cached transition, so
+// instances built the same way share one Shape and store their fields in a flat slot array.
+// A shape therefore also identifies the class, which is what inline caches key on.
+struct Shape : Object {
+    std::vector<Atom> keys; // Field name of each slot
+    
+    int slotOf(Atom name) const {
+        auto it = index.find(name);
+        return it != index.end() ? it->second : -1;
+    }
+    
+    // Shape with `name` appended
+    Shape* withField(Atom name) {
+        auto it = transitions.find(name);
+        if (it != transitions.end()) return it->second.get();
+        Ref<Shape> next = new Shape();
+        next->keys = keys;
+        next->keys.push_back(name);
+        next->index = index;
+        next->index[name] = (int)keys.size();
+        transitions[name] = next;
+        return next.get();
+    }
+    
+private:
+    std::unordered_map<Atom, int> index;
+    std::unordered_map<Atom, Ref<Shape>> transitions;
+};
+
+// Per-site cache for `obj.name` on instances (see Interpreter::getMemberCached).
+// Remembers what the name resolved to for up to four shapes (polymorphic). A call site
+// also keeps the method binding of its last call, so repeated `obj.method()` calls reuse
+// one; between calls it binds no receiver (Interpreter::releaseBinding).
+struct InlineCache {
+    enum Kind : uint8_t { Field, Method, Getter, Setter, Missing, AddField };
+    
+    struct Entry {
+        Ref<Shape> shape;
+        Kind kind = Missing;
+        int slot = -1;
+        const Value* member = nullptr; // Method/getter/setter in its class's tables, which
+                                       // outlive every instance of `shape`
+        Ref<Shape> nextShape;  // AddField: shape after the store
+    };
+    
+    static const int Size = 4;
+    Entry entries[Size];
+    int count = 0;
+    
+    Value binding; // Method closure over a scope for 'this' and 'super'
+    Value* bindingThis = nullptr;  // Their entries in that scope
+    Value* bindingSuper = nullptr; // (null without a superclass)
+    
+    Entry* find(Shape* shape) {
+        for (int i = 0; i < count; i++) {
+            if (entries[i].shape.get() == shape) return &entries[i];
+        }
+        return nullptr;
+    }
+    
+    // New entry for `shape`, or nullptr once the site has gone megamorphic
+    Entry* add(Shape* shape) {
+        if (count == Size) return nullptr;
+        Entry& e = entries[count++];
+        e.shape = shape;
+        return &e;
+    }
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define ANIS_TOKEN_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
 
 enum TokenType {
@@ -23,15 +24,20 @@ enum TokenType {
     TOK_PRIVATE_IDENTIFIER, // #field
 
     // Exception Handling
-    TOK_TRY, TOK_CATCH, TOK_FINALLY, TOK_THROW
+    TOK_TRY, TOK_CATCH, TOK_FINALLY, TOK_THROW,
+    
+    // Loop control
+    TOK_BREAK, TOK_CONTINUE
 };
 
+// Text is a slice of the lexed source (identifiers, numbers, strings) or static text (keywords,
+// operators), so tokens are cheap to copy; whatever the AST keeps is copied out of them.
 struct Token {
     TokenType type;
-    std::string text;
+    std::string_view text;
     int line = 0;
     
-    Token(TokenType t, std::string txt, int l = 0) : type(t), text(txt), line(l) {}
+    Token(TokenType t, std::string_view txt, int l = 0) : type(t), text(txt), line(l) {}
     Token() : type(TOK_EOF), text(""), line(0) {}
 };
 
@@ -0,0 +1,320 @@
+#ifndef ANIS_VALUE_H
+#define ANIS_VALUE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include "gc.h"
+
+// Forward Decl
+struct Stmt;
+struct Environment;
+struct Class;
+struct Instance;
+class Interpreter;
+class NativeArgs;
+struct Param;
+using ParamList = std::shared_ptr<std::vector<Param>>; // Declared parameters (parser.h)
+
+// Heap payload of a Value (strings, lists, maps, functions, classes, instances).
+// Reference counted intrusively so a Value stays one pointer wide. Not thread-safe,
+// like the interpreter itself.
+struct Object {
+    uint32_t refCount = 0;
+    virtual ~Object() = default;
+};
+
+// Object that can hold references to other objects, and so be part of a cycle (gc.h)
+struct TrackedObject : Object, GcObject {
+    long gcRefCount() const override { return refCount; }
+    std::shared_ptr<void> gcPin() override {
+        refCount++;
+        return std::shared_ptr<void>(static_cast<Object*>(this), [](void* p) {
+            Object* o = static_cast<Object*>(p);
+            if (--o->refCount == 0) delete o;
+        });
+    }
+};
+
+// Owning pointer to an Object subclass, for Object references held outside a Value
+template<typename T>
+class Ref {
+    T* ptr = nullptr;
+public:
+    Ref() = default;
+    Ref(T* p) : ptr(p) { if (ptr) ptr->refCount++; }
+    Ref(const Ref& other) : Ref(other.ptr) {}
+    Ref(Ref&& other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+    ~Ref() { if (ptr && --ptr->refCount == 0) delete ptr; }
+    Ref& operator=(Ref other) { std::swap(ptr, other.ptr); return *this; }
+
+    T* get() const { return ptr; }
+    T* operator->() const { return ptr; }
+    T& operator*() const { return *ptr; }
+    explicit operator bool() const { return ptr != nullptr; }
+};
+
+enum class ValueType : uint8_t {
+    Undefined, Null, Bool, Int, Double, String, List, Map, Closure, Native, Class, Instance
+};
+
+// 16-byte tagged value: an immediate (int64, double, bool, null, undefined) or a pointer to a
+// reference-counted Object. Copies only bump a counter; lists and maps keep reference semantics.
+struct Value {
+    // Native functions see their arguments in place, without a copy (see NativeArgs)
+    using NativeCall = std::function<Value(Interpreter&, NativeArgs)>;
+    // Legacy signature taking a copied vector; still accepted and adapted to NativeCall
+    using NativeFunc = std::function<Value(std::vector<Value>)>;
+
+    Value(std::string s, int i, bool isI);
+    Value(std::shared_ptr<Stmt> body, std::shared_ptr<Environment> env = nullptr, ParamList params = nullptr);
+    Value(std::vector<Value> list);
+    Value(std::map<std::string, Value> map);
+    Value(NativeCall func);
+    Value(NativeCall func, std::string nativeId);
+    Value(NativeFunc func);
+    Value(NativeFunc func, std::string nativeId);
+    Value(Class* c);
+    Value(Instance* i);
+    Value() : type(ValueType::String) { as.obj = nullptr; } // Empty string
+
+    Value(const Value& other) : as(other.as), type(other.type), flags(other.flags) { retain(); }
+    Value(Value&& other) noexcept : as(other.as), type(other.type), flags(other.flags) {
+        other.type = ValueType::Undefined;
+    }
+    Value& operator=(const Value& other) {
+        if (this != &other) {
+            Value copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        swap(other);
+        return *this;
+    }
+    ~Value() { release(); }
+
+    // Fast constructors for the interpreter hot paths
+    static Value number(int64_t i) { Value v(ValueType::Int); v.as.i = i; return v; }
+    static Value real(double d) { Value v(ValueType::Double); v.as.d = d; return v; }
+    static Value boolean(bool b) { Value v(ValueType::Bool); v.as.i = b ? 1 : 0; return v; }
+    static Value undefined() { return Value(ValueType::Undefined); }
+    static Value null() { return Value(ValueType::Null); }
+    // Numeric literal text: an Int unless it has a fraction, an exponent or overflows int64
+    static Value parseNumber(const std::string& text);
+    // String concatenation (`+` with a string operand). Long results share both operands in a
+    // rope node instead of copying them, so building a string in a loop stays linear.
+    static Value concat(const Value& l, const Value& r);
+
+    ValueType getType() const { return type; }
+
+    // Booleans are numbers that print their name in strVal() (as in `true == 1` being false)
+    bool isInt() const { return type == ValueType::Int || type == ValueType::Bool; }
+    int64_t intVal() const { return isInt() ? as.i : isDouble() ? (int64_t)as.d : 0; } // Doubles truncate
+    bool isDouble() const { return type == ValueType::Double; }
+    double doubleVal() const { return isDouble() ? as.d : isInt() ? (double)as.i : 0.0; }
+    bool isNumber() const { return isInt() || isDouble(); }
+    const std::string& strVal() const;
+    size_t stringLength() const; // Length of toString(), without flattening a rope
+
+    bool isList() const { return type == ValueType::List; }
+    std::vector<Value>* listVal() const;
+    bool isMap() const { return type == ValueType::Map; }
+    std::map<std::string, Value>* mapVal() const;
+
+    bool isClosure() const { return type == ValueType::Closure; }
+    const std::shared_ptr<Stmt>& closureBody() const;
+    const std::shared_ptr<Environment>& closureEnv() const;
+    const ParamList& closureParams() const; // May be null for a closure without parameters
+    Value withEnv(std::shared_ptr<Environment> env) const; // Same function, different captured scope
+
+    bool isNative() const { return type == ValueType::Native; }
+    const NativeCall& nativeFunc() const;
+    const std::string& nativeId() const; // Stable identification for native closures
+
+    bool isClass() const { return type == ValueType::Class; }
+    Class* classVal() const;
+    bool isInstance() const { return type == ValueType::Instance; }
+    Instance* instanceVal() const;
+
+    // Getter/Setter tagging
+    bool isGetter() const { return flags & FLAG_GETTER; }
+    bool isSetter() const { return flags & FLAG_SETTER; }
+    void markGetter() { flags |= FLAG_GETTER; }
+    void markSetter() { flags |= FLAG_SETTER; }
+
+    std::string toString() const;
+    std::string toJson() const;
+    void appendString(std::string& out) const; // toString() into an existing buffer
+    void appendJson(std::string& out) const;
+
+    // Type safety helper methods
+    std::string getTypeName() const {
+        if (isNumber()) return "number";
+        if (isList()) return "array";
+        if (isMap()) return "object";
+        if (isClosure()) return "function";
+        if (isNative()) return "native function";
+        if (isClass()) return "class";
+        if (isInstance()) return "instance";
+        if (isGetter()) return "getter";
+        if (isSetter()) return "setter";
+        return "string";
+    }
+
+    // Tracked object this value references, for the cycle collector (nullptr for immediates,
+    // strings and natives)
+    GcObject* gcObject() const;
+    
+    // Same heap object (or same immediate), as opposed to equal contents
+    bool isSame(const Value& other) const { return type == other.type && as.i == other.as.i; } // Bitwise for doubles
+
+    bool isCallable() const {
+        return isClosure() || isNative();
+    }
+
+    bool isTruthy() const {
+        if (isInt()) return intVal() != 0;
+        if (isDouble()) return as.d != 0.0 && as.d == as.d; // NaN is falsy
+        if (type == ValueType::Null || type == ValueType::Undefined) return false;
+        if (strVal() == "false") return false;
+        if (isList()) return !listVal()->empty();
+        if (isMap()) return !mapVal()->empty();
+        return !strVal().empty() || isClosure() || isNative() || isClass() || isInstance();
+    }
+
+    bool isNullOrUndefined() const {
+        return type == ValueType::Null || type == ValueType::Undefined;
+    }
+
+    // Safe accessors with defaults
+    int safeGetInt(int defaultVal = 0) const {
+        return isInt() ? intVal() : defaultVal;
+    }
+
+    std::string safeGetString(const std::string& defaultVal = "") const {
+        return !isInt() ? strVal() : defaultVal;
+    }
+
+    // Safe list access
+    Value safeGetListItem(size_t index, const Value& defaultVal = Value("undefined", 0, false)) const;
+
+    // Safe map access
+    Value safeGetMapValue(const std::string& key, const Value& defaultVal = Value("undefined", 0, false)) const;
+
+    // Check if value is a specific type
+    bool checkType(const std::string& expectedType) const {
+        return getTypeName() == expectedType;
+    }
+
+private:
+    enum : uint8_t { FLAG_GETTER = 1, FLAG_SETTER = 2 };
+
+    union {
+        int64_t i;
+        double d;
+        Object* obj;
+    } as;
+    ValueType type;
+    uint8_t flags = 0;
+
+    explicit Value(ValueType t) : type(t) { as.i = 0; }
+    static Value text(std::string s); // String value, even for "null"/"undefined"
+    const std::string& immediateString() const; // strVal() of everything but non-empty strings
+
+    bool isHeap() const { return type >= ValueType::String && as.obj; }
+    void retain() { if (isHeap()) as.obj->refCount++; }
+    void release() { if (isHeap() && --as.obj->refCount == 0) delete as.obj; }
+    void setObject(Object* o) { as.obj = o; o->refCount++; }
+    void swap(Value& other) {
+        std::swap(as, other.as);
+        std::swap(type, other.type);
+        std::swap(flags, other.flags);
+    }
+};
+
+static_assert(sizeof(Value) == 16, "Value must stay two words");
+
+// Read-only view of a native call's arguments (std::span<const Value> until we move past C++17).
+// Only valid for the duration of the call; copy out whatever has to outlive it.
+class NativeArgs {
+    const Value* first = nullptr;
+    size_t count = 0;
+public:
+    NativeArgs() = default;
+    NativeArgs(const Value* data, size_t size) : first(data), count(size) {}
+    NativeArgs(const std::vector<Value>& args) : first(args.data()), count(args.size()) {}
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Value& operator[](size_t i) const { return first[i]; }
+    const Value* begin() const { return first; }
+    const Value* end() const { return first + count; }
+    std::vector<Value> toVector() const { return std::vector<Value>(begin(), end()); }
+};
+
+// Flat text, or a rope node: the pending concatenation of two strings, flattened into `value`
+// (and the children dropped) on first read.
+struct StringObject : Object {
+    StringObject(std::string s) : length(s.size()), value(std::move(s)) {}
+    StringObject(StringObject* l, StringObject* r);
+    ~StringObject() override;
+    const std::string& text() { return left ? flatten() : value; }
+
+    size_t length;
+private:
+    std::string value;
+    StringObject* left = nullptr; // Owned references; both set or both null
+    StringObject* right = nullptr;
+    const std::string& flatten();
+    void releaseChildren();
+};
+
+struct ListObject : TrackedObject {
+    std::vector<Value> items;
+    ListObject(std::vector<Value> list) : items(std::move(list)) {}
+    size_t gcTraverse(GcVisitor visit, void* ctx) override;
+    void gcClear() override;
+};
+
+struct MapObject : TrackedObject {
+    std::map<std::string, Value> entries;
+    MapObject(std::map<std::string, Value> map) : entries(std::move(map)) {}
+    size_t gcTraverse(GcVisitor visit, void* ctx) override;
+    void gcClear() override;
+};
+
+struct ClosureObject : TrackedObject {
+    std::shared_ptr<Stmt> body;
+    std::shared_ptr<Environment> env; // Captured scope
+    ParamList params; // Shared with the declaring AST node
+    ClosureObject(std::shared_ptr<Stmt> b, std::shared_ptr<Environment> e, ParamList p)
+        : body(std::move(b)), env(std::move(e)), params(std::move(p)) {}
+    size_t gcTraverse(GcVisitor visit, void* ctx) override;
+    void gcClear() override;
+};
+
+struct NativeObject : Object {
+    Value::NativeCall func;
+    std::string id;
+    NativeObject(Value::NativeCall f, std::string i) : func(std::move(f)), id(std::move(i)) {}
+};
+
+inline const std::string& Value::strVal() const {
+    if (type == ValueType::String && as.obj) return static_cast<StringObject*>(as.obj)->text();
+    return immediateString();
+}
+
+inline std::vector<Value>* Value::listVal() const {
+    return isList() ? &static_cast<ListObject*>(as.obj)->items : nullptr;
+}
+
+inline std::map<std::string, Value>* Value::mapVal() const {
+    return isMap() ? &static_cast<MapObject*>(as.obj)->entries : nullptr;
+}
+
+#endif
@@ -1,144 +1,496 @@
-
 #include "interpreter.h"
 #include <iostream>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
 
 // Value Implementation
-Value::Value(std::string s, int i, bool isI) : strVal(s), intVal(i), isInt(isI) {}
+Value::Value(std::string s, int i, bool isI) {
+    as.i = 0;
+    if (isI) {
+        // Booleans are numbers tagged with their name
+        if (s == "true" || s == "false") type = ValueType::Bool;
+        else type = ValueType::Int;
+        as.i = i;
+    } else if (s == "undefined") {
+        type = ValueType::Undefined;
+    } else if (s == "null") {
+        type = ValueType::Null;
+    } else {
+        type = ValueType::String;
+        as.obj = nullptr;
+        if (!s.empty()) setObject(new StringObject(std::move(s)));
+    }
+}
+
+Value::Value(std::shared_ptr<Stmt> body, std::shared_ptr<Environment> env, ParamList params) 
+    : type(ValueType::Closure) {
+    setObject(new ClosureObject(std::move(body), std::move(env), std::move(params)));
+}
+
+Value::Value(std::vector<Value> list) : type(ValueType::List) {
+    setObject(new ListObject(std::move(list)));
+}
+
+Value::Value(std::map<std::string, Value> map) : type(ValueType::Map) {
+    setObject(new MapObject(std::move(map)));
+}
+
+Value::Value(NativeCall func) : type(ValueType::Native) {
+    setObject(new NativeObject(std::move(func), ""));
+}
+
+Value::Value(NativeCall func, std::string nativeId) : type(ValueType::Native) {
+    setObject(new NativeObject(std::move(func), std::move(nativeId)));
+}
 
-Value::Value(std::shared_ptr<Stmt> body, std::shared_ptr<Environment> env, std::vector<std::string> params) 
-    : strVal("function"), intVal(0), isInt(false), isClosure(true), closureBody(body), closureEnv(env), closureParams(params) {}
+// Legacy natives get their own copy of the arguments, as before
+static Value::NativeCall adaptNative(Value::NativeFunc func) {
+    return [func = std::move(func)](Interpreter&, NativeArgs args) { return func(args.toVector()); };
+}
+
+Value::Value(NativeFunc func) : Value(adaptNative(std::move(func))) {}
+
+Value::Value(NativeFunc func, std::string nativeId) : Value(adaptNative(std::move(func)), std::move(nativeId)) {}
+
+Value::Value(Class* c) : type(ValueType::Class) {
+    setObject(c);
+}
+
+Value::Value(Instance* i) : type(ValueType::Instance) {
+    setObject(i);
+}
 
-Value::Value(std::vector<Value> list) : strVal(""), intVal(0), isInt(false), isList(true) {
-    listVal = std::make_shared<std::vector<Value>>(list);
+const std::string& Value::immediateString() const {
+    static const std::string empty = "";
+    static const std::string trueStr = "true";
+    static const std::string falseStr = "false";
+    static const std::string nullStr = "null";
+    static const std::string undefinedStr = "undefined";
+    static const std::string functionStr = "function";
+    static const std::string nativeStr = "native";
+    static const std::string classStr = "class";
+    static const std::string instanceStr = "instance";
+    
+    switch (type) {
+        case ValueType::Undefined: return undefinedStr;
+        case ValueType::Null: return nullStr;
+        case ValueType::Bool: return as.i ? trueStr : falseStr;
+        case ValueType::Closure: return functionStr;
+        case ValueType::Native: return nativeStr;
+        case ValueType::Class: return classStr;
+        case ValueType::Instance: return instanceStr;
+        default: return empty;
+    }
 }
 
-Value::Value(std::map<std::string, Value> map) : strVal(""), intVal(0), isInt(false), isMap(true) {
-    mapVal = std::make_shared<std::map<std::string, Value>>(map);
+const std::shared_ptr<Stmt>& Value::closureBody() const {
+    static const std::shared_ptr<Stmt> none;
+    return isClosure() ? static_cast<ClosureObject*>(as.obj)->body : none;
 }
 
-Value::Value(NativeFunc func) : strVal("native"), intVal(0), isInt(false), nativeFunc(func), isNative(true) {}
+const std::shared_ptr<Environment>& Value::closureEnv() const {
+    static const std::shared_ptr<Environment> none;
+    return isClosure() ? static_cast<ClosureObject*>(as.obj)->env : none;
+}
 
-Value::Value(std::shared_ptr<Class> c) : strVal("class"), intVal(0), isInt(false), isClass(true), classVal(c) {}
+const ParamList& Value::closureParams() const {
+    static const ParamList none;
+    return isClosure() ? static_cast<ClosureObject*>(as.obj)->params : none;
+}
 
-Value::Value(std::shared_ptr<Instance> i) : strVal("instance"), intVal(0), isInt(false), isInstance(true), instanceVal(i) {}
+Value Value::withEnv(std::shared_ptr<Environment> env) const {
+    Value bound(closureBody(), std::move(env), closureParams());
+    bound.flags = flags;
+    return bound;
+}
 
-Value::Value() : strVal(""), intVal(0), isInt(false) {}
+const Value::NativeCall& Value::nativeFunc() const {
+    static const NativeCall none;
+    return isNative() ? static_cast<NativeObject*>(as.obj)->func : none;
+}
+
+const std::string& Value::nativeId() const {
+    static const std::string none;
+    return isNative() ? static_cast<NativeObject*>(as.obj)->id : none;
+}
+
+Value Value::safeGetListItem(size_t index, const Value& defaultVal) const {
+    if (isList() && index < listVal()->size()) {
+        return (*listVal())[index];
+    }
+    return defaultVal;
+}
+
+Value Value::safeGetMapValue(const std::string& key, const Value& defaultVal) const {
+    if (isMap()) {
+        auto it = mapVal()->find(key);
+        if (it != mapVal()->end()) {
+            return it->second;
+        }
+    }
+    return defaultVal;
+}
+
+// Shortest of %.15g/%.17g that reads back exactly; integral doubles print without a fraction
+static std::string formatDouble(double d) {
+    if (d != d) return "NaN";
+    if (d == std::numeric_limits<double>::infinity()) return "Infinity";
+    if (d == -std::numeric_limits<double>::infinity()) return "-Infinity";
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.15g", d);
+    if (std::strtod(buf, nullptr) != d) snprintf(buf, sizeof(buf), "%.17g", d);
+    return buf;
+}
+
+Value Value::parseNumber(const std::string& text) {
+    if (text.find_first_of(".eE") == std::string::npos) {
+        errno = 0;
+        char* end = nullptr;
+        long long i = std::strtoll(text.c_str(), &end, 10);
+        if (errno != ERANGE && end != text.c_str()) return number(i);
+    }
+    return real(std::strtod(text.c_str(), nullptr));
+}
 
 std::string Value::toString() const { 
-    if (isClosure) return "[Function]";
-    if (isNative) return "[Native Function]";
-    if (isList && listVal) {
-        std::string s = "[";
-        for(size_t i=0; i<listVal->size(); i++) {
-            s += (*listVal)[i].toString();
-            if (i < listVal->size()-1) s += ", ";
+    if (type == ValueType::String) return strVal();
+    std::string out;
+    appendString(out);
+    return out;
+}
+
+// Writers append to one buffer, so nested lists and maps print in linear time
+void Value::appendString(std::string& out) const {
+    if (isClosure()) { out += "[Function]"; return; }
+    if (isNative()) { out += "[Native Function]"; return; }
+    if (isList()) {
+        auto& list = *listVal();
+        out += '[';
+        for (size_t i = 0; i < list.size(); i++) {
+            if (i > 0) out += ", ";
+            list[i].appendString(out);
         }
-        s += "]";
-        return s;
+        out += ']';
+        return;
     }
-    if (isMap && mapVal) {
-        std::string s = "{";
-         for(auto const& pair : *mapVal) {
-             s += pair.first + ": " + pair.second.toString() + ", ";
-         }
-         if (mapVal->size() > 0) s = s.substr(0, s.length()-2);
-        s += "}";
-        return s;
+    if (isMap()) {
+        out += '{';
+        bool first = true;
+        for (auto const& pair : *mapVal()) {
+            if (!first) out += ", ";
+            first = false;
+            out += pair.first;
+            out += ": ";
+            pair.second.appendString(out);
+        }
+        out += '}';
+        return;
     }
-    if (isClass && classVal) return "[Class " + classVal->name + "]";
-    if (isInstance && instanceVal) return "[Instance of " + instanceVal->klass->name + "]";
-    return isInt ? std::to_string(intVal) : strVal; 
+    if (isClass()) { out += "[Class " + classVal()->name + "]"; return; }
+    if (isInstance()) { out += "[Instance of " + instanceVal()->klass->name + "]"; return; }
+    if (isDouble()) { out += formatDouble(as.d); return; }
+    if (isInt()) { out += std::to_string(intVal()); return; }
+    out += strVal();
 }
 
 std::string Value::toJson() const {
-    if (isInt) {
-        if (strVal == "true") return "true";
-        if (strVal == "false") return "false";
-        return std::to_string(intVal);
-    }
-    if (isList && listVal) {
-        // ...
-        std::string s = "[";
-        for (size_t i = 0; i < listVal->size(); i++) {
-            s += (*listVal)[i].toJson();
-            if (i < listVal->size() - 1) s += ",";
+    std::string out;
+    appendJson(out);
+    return out;
+}
+
+void Value::appendJson(std::string& out) const {
+    if (isInt()) {
+        if (type == ValueType::Bool) out += strVal();
+        else out += std::to_string(intVal());
+        return;
+    }
+    if (isDouble()) { out += std::isfinite(as.d) ? formatDouble(as.d) : "null"; return; }
+    if (isList()) {
+        auto& list = *listVal();
+        out += '[';
+        for (size_t i = 0; i < list.size(); i++) {
+            if (i > 0) out += ',';
+            list[i].appendJson(out);
         }
-        s += "]";
-        return s;
-    }
-    if (isMap && mapVal) {
-        std::string s = "{";
-        size_t i = 0;
-        for (auto const& pair : *mapVal) {
-            s += "\"" + pair.first + "\":" + pair.second.toJson();
-            if (++i < mapVal->size()) s += ",";
+        out += ']';
+        return;
+    }
+    if (isMap()) {
+        out += '{';
+        bool first = true;
+        for (auto const& pair : *mapVal()) {
+            if (!first) out += ',';
+            first = false;
+            out += '"';
+            out += pair.first;
+            out += "\":";
+            pair.second.appendJson(out);
         }
-        s += "}";
-        return s;
-    }
-    if (isInstance && instanceVal) {
-        std::string s = "{";
-        size_t i = 0;
-        for (auto const& pair : instanceVal->fields) {
-            if (pair.first.find("#") != 0) { // Don't serialize private fields to JSON
-                s += "\"" + pair.first + "\":" + pair.second.toJson();
-                if (++i < instanceVal->fields.size()) s += ",";
-            }
+        out += '}';
+        return;
+    }
+    if (isInstance()) {
+        // Fields in name order, like a map
+        Instance* inst = instanceVal();
+        std::map<std::string, const Value*> fields;
+        for (size_t slot = 0; slot < inst->slots.size(); slot++) {
+            const std::string& name = atomName(inst->shape->keys[slot]);
+            if (name.find("#") != 0) fields[name] = &inst->slots[slot]; // Don't serialize private fields to JSON
         }
-        // Remove trailing comma if any
-        if (s.back() == ',') s.pop_back();
-        s += "}";
-        return s;
+        out += '{';
+        bool first = true;
+        for (auto const& pair : fields) {
+            if (!first) out += ',';
+            first = false;
+            out += '"';
+            out += pair.first;
+            out += "\":";
+            pair.second->appendJson(out);
+        }
+        out += '}';
+        return;
     }
     
-    if (strVal == "null" || strVal == "undefined") return "null";
-    if (isClosure || isNative) return "null";
+    if (isNullOrUndefined() || isClosure() || isNative()) { out += "null"; return; }
     
     // Default: string with quotes
     // Basic escaping
-    std::string escaped = strVal;
-    size_t pos = 0;
-    while ((pos = escaped.find("\"", pos)) != std::string::npos) {
-        escaped.replace(pos, 1, "\\\"");
-        pos += 2;
+    out += '"';
+    for (char c : strVal()) {
+        if (c == '"') out += "\\\"";
+        else out += c;
     }
-    return "\"" + escaped + "\"";
+    out += '"';
 }
 
-Value Class::findMethod(const std::string& name) {
-    if (methods.count(name)) return methods[name];
-    if (superclass) return superclass->findMethod(name);
-    return Value("undefined", 0, false);
+// Concatenations shorter than this are copied flat; longer ones become rope nodes
+static const size_t RopeMinLength = 256;
+
+Value Value::concat(const Value& l, const Value& r) {
+    if (l.type != ValueType::String || r.type != ValueType::String) {
+        // Print non-string operands once, then join as strings
+        return concat(l.type == ValueType::String ? l : text(l.toString()),
+                      r.type == ValueType::String ? r : text(r.toString()));
+    }
+    size_t total = l.stringLength() + r.stringLength();
+    if (total < RopeMinLength) return {l.strVal() + r.strVal(), 0, false};
+    if (!l.as.obj) return r;
+    if (!r.as.obj) return l;
+    Value v(ValueType::String);
+    v.setObject(new StringObject(static_cast<StringObject*>(l.as.obj), static_cast<StringObject*>(r.as.obj)));
+    return v;
 }
 
-Value Class::findGetter(const std::string& name) {
-    if (getters.count(name)) return getters[name];
-    if (superclass) return superclass->findGetter(name);
-    return Value("undefined", 0, false);
+Value Value::text(std::string s) {
+    Value v(ValueType::String);
+    if (!s.empty()) v.setObject(new StringObject(std::move(s)));
+    return v;
 }
 
-Value Class::findSetter(const std::string& name) {
-    if (setters.count(name)) return setters[name];
-    if (superclass) return superclass->findSetter(name);
-    return Value("undefined", 0, false);
+size_t Value::stringLength() const {
+    if (type == ValueType::String) return as.obj ? static_cast<StringObject*>(as.obj)->length : 0;
+    return toString().size();
 }
 
-Value Instance::get(const std::string& name) {
-    if (fields.count(name)) return fields[name];
-    if (privateFields.count(name)) return privateFields[name];
+StringObject::StringObject(StringObject* l, StringObject* r)
+    : length(l->length + r->length), left(l), right(r) {
+    left->refCount++;
+    right->refCount++;
+}
+
+StringObject::~StringObject() {
+    releaseChildren();
+}
+
+// Concatenates the leaves left to right with an explicit stack (ropes built by a loop are as
+// deep as the loop was long), then keeps only the flat text
+const std::string& StringObject::flatten() {
+    std::string out;
+    out.reserve(length);
+    std::vector<const StringObject*> pending{right, left};
+    while (!pending.empty()) {
+        const StringObject* node = pending.back();
+        pending.pop_back();
+        if (node->left) {
+            pending.push_back(node->right);
+            pending.push_back(node->left);
+        } else {
+            out += node->value;
+        }
+    }
+    value = std::move(out);
+    releaseChildren();
+    return value;
+}
+
+// Iterative for the same reason as flatten(): recursive destructors would overflow the stack
+void StringObject::releaseChildren() {
+    std::vector<StringObject*> dead;
+    auto drop = [&dead](StringObject* node) {
+        if (node && --node->refCount == 0) dead.push_back(node);
+    };
+    drop(left);
+    drop(right);
+    left = right = nullptr;
+    while (!dead.empty()) {
+        StringObject* node = dead.back();
+        dead.pop_back();
+        drop(node->left);
+        drop(node->right);
+        node->left = node->right = nullptr;
+        delete node;
+    }
+}
+
+Value Class::findMethod(Atom name) {
+    const Value* method = methodRef(name);
+    return method ? *method : Value::undefined();
+}
+
+Value Class::findGetter(Atom name) {
+    const Value* getter = getterRef(name);
+    return getter ? *getter : Value::undefined();
+}
+
+Value Class::findSetter(Atom name) {
+    const Value* setter = setterRef(name);
+    return setter ? *setter : Value::undefined();
+}
+
+const Value* Class::methodRef(Atom name) {
+    auto it = methods.find(name);
+    if (it != methods.end()) return &it->second;
+    return superclass ? superclass->methodRef(name) : nullptr;
+}
+
+const Value* Class::getterRef(Atom name) {
+    auto it = getters.find(name);
+    if (it != getters.end()) return &it->second;
+    return superclass ? superclass->getterRef(name) : nullptr;
+}
+
+const Value* Class::setterRef(Atom name) {
+    auto it = setters.find(name);
+    if (it != setters.end()) return &it->second;
+    return superclass ? superclass->setterRef(name) : nullptr;
+}
+
+Value Instance::get(Atom name) {
+    int slot = shape->slotOf(name);
+    if (slot >= 0) return slots[slot];
     
     Value method = klass->findMethod(name);
-    if (!method.strVal.empty() && method.isClosure) {
+    if (method.isClosure()) {
         return method; // This will be bound by evaluate(MemberExpr) or CallExpr
     }
     
     return Value("undefined", 0, false);
 }
 
-void Instance::set(const std::string& name, Value value) {
-    if (name.find("#") == 0) {
-        privateFields[name] = value;
-    } else {
-        fields[name] = value;
+void Instance::set(Atom name, Value value) {
+    int slot = shape->slotOf(name);
+    if (slot >= 0) slots[slot] = std::move(value);
+    else addField(shape->withField(name), std::move(value));
+}
+
+// Cycle collection (gc.h): each tracked type visits the tracked objects it references and can
+// drop those references. Clearing swaps the contents out first so no container is modified
+// while its elements are being destroyed.
+
+GcObject* Value::gcObject() const {
+    switch (type) {
+        case ValueType::List: return static_cast<ListObject*>(as.obj);
+        case ValueType::Map: return static_cast<MapObject*>(as.obj);
+        case ValueType::Closure: return static_cast<ClosureObject*>(as.obj);
+        case ValueType::Class: return static_cast<Class*>(as.obj);
+        case ValueType::Instance: return static_cast<Instance*>(as.obj);
+        default: return nullptr;
     }
 }
+
+static void visitValue(const Value& v, GcVisitor visit, void* ctx) {
+    if (GcObject* o = v.gcObject()) visit(o, ctx);
+}
+
+template<typename Table>
+static size_t visitTable(const Table& table, GcVisitor visit, void* ctx) {
+    for (auto& entry : table) visitValue(entry.second, visit, ctx);
+    return table.size();
+}
+
+size_t ListObject::gcTraverse(GcVisitor visit, void* ctx) {
+    for (auto& v : items) visitValue(v, visit, ctx);
+    return items.size();
+}
+
+void ListObject::gcClear() {
+    std::vector<Value> dropped;
+    dropped.swap(items);
+}
+
+size_t MapObject::gcTraverse(GcVisitor visit, void* ctx) {
+    return visitTable(entries, visit, ctx);
+}
+
+void MapObject::gcClear() {
+    std::map<std::string, Value> dropped;
+    dropped.swap(entries);
+}
+
+size_t ClosureObject::gcTraverse(GcVisitor visit, void* ctx) {
+    if (env) visit(env.get(), ctx);
+    return 1;
+}
+
+void ClosureObject::gcClear() {
+    std::shared_ptr<Environment> dropped;
+    dropped.swap(env);
+}
+
+size_t Class::gcTraverse(GcVisitor visit, void* ctx) {
+    if (superclass) visit(superclass.get(), ctx);
+    return 1 + visitTable(methods, visit, ctx) + visitTable(getters, visit, ctx)
+             + visitTable(setters, visit, ctx) + visitTable(staticFields, visit, ctx);
+}
+
+void Class::gcClear() {
+    Ref<Class> droppedSuper;
+    std::swap(droppedSuper, superclass);
+    std::unordered_map<Atom, Value> dropped[4];
+    dropped[0].swap(methods);
+    dropped[1].swap(getters);
+    dropped[2].swap(setters);
+    dropped[3].swap(staticFields);
+}
+
+size_t Instance::gcTraverse(GcVisitor visit, void* ctx) {
+    if (klass) visit(klass.get(), ctx);
+    for (auto& v : slots) visitValue(v, visit, ctx);
+    return 1 + slots.size();
+}
+
+void Instance::gcClear() {
+    // The class stays (instances always have one); if it is garbage too it clears itself
+    std::vector<Value> dropped;
+    dropped.swap(slots);
+    shape = klass->rootShape;
+}
+
+size_t Environment::gcTraverse(GcVisitor visit, void* ctx) {
+    if (enclosing) visit(enclosing.get(), ctx);
+    for (auto& v : slots) visitValue(v, visit, ctx);
+    return 1 + slots.size() + visitTable(values, visit, ctx);
+}
+
+void Environment::gcClear() {
+    std::shared_ptr<Environment> droppedEnclosing;
+    droppedEnclosing.swap(enclosing);
+    std::vector<Value, FrameAllocator<Value>> droppedSlots;
+    droppedSlots.swap(slots);
+    decltype(values) droppedValues;
+    droppedValues.swap(values);
+}
@@ -0,0 +1,325 @@
+#include "interpreter.h"
+#include "bytecode.h"
+#include "builtins.h"
+#include <algorithm>
+
+namespace {
+
+// Arguments of a native call, moved off the shared operand stack before the call: the callee
+// may re-enter run() and grow the stack. Common arities stay here, without a heap allocation.
+struct NativeCallArgs {
+    static const int InlineCount = 8;
+    Value inlineArgs[InlineCount];
+    std::vector<Value> spilled;
+    NativeArgs view;
+    
+    NativeCallArgs(std::vector<Value>& stack, int argc) {
+        auto first = stack.end() - argc;
+        if (argc <= InlineCount) {
+            std::move(first, stack.end(), inlineArgs);
+            view = NativeArgs(inlineArgs, argc);
+        } else {
+            spilled.assign(std::make_move_iterator(first), std::make_move_iterator(stack.end()));
+            view = NativeArgs(spilled);
+        }
+        stack.resize(stack.size() - argc);
+    }
+};
+
+// Where a break/continue that left a tree-walked statement (OP_EXEC) resumes: the target
+// loop's end or condition, after closing the scopes opened since the loop. -1 when the loop
+// is outside this chunk. Kept out of line, off the dispatch loop.
+__attribute__((noinline))
+int loopTarget(const Chunk& chunk, const Chunk::ExecSite& site, Completion c, Atom label, std::shared_ptr<Environment>& environment) {
+    int loop = chunk.findLoop(site.loop, label);
+    if (loop < 0) return -1;
+    for (int depth = site.depth; depth > chunk.loops[loop].depth; depth--) {
+        environment = environment->enclosing;
+    }
+    return c == Completion::Break ? chunk.loops[loop].breakTarget : chunk.loops[loop].continueTarget;
+}
+
+} // namespace
+
+Completion Interpreter::run(Chunk& chunk) {
+    // Nested runs (calls, fallbacks) share the operand stack above this base
+    size_t base = stack.size();
+    std::shared_ptr<Environment> entry = environment;
+    const Instruction* code = chunk.code.data();
+    size_t count = chunk.code.size();
+    size_t ip = 0;
+    Completion completion = Completion::Normal;
+    
+    auto pop = [this]() {
+        Value v = std::move(stack.back());
+        stack.pop_back();
+        return v;
+    };
+    
+    try {
+        while (ip < count) {
+            const Instruction& ins = code[ip++];
+            
+            switch (ins.op) {
+                case OP_CONST:
+                    stack.push_back(chunk.constants[ins.a]);
+                    break;
+                case OP_GET_VAR:
+                    stack.push_back(environment->get(chunk.names[ins.a]));
+                    break;
+                case OP_SET_VAR:
+                    environment->assign(chunk.names[ins.a], stack.back());
+                    break;
+                case OP_DEFINE_VAR:
+                    environment->define(chunk.names[ins.a], pop());
+                    break;
+                case OP_ADD_ASSIGN:
+                case OP_ADD_ASSIGN_GLOBAL: {
+                    Environment* scope = ins.op == OP_ADD_ASSIGN_GLOBAL ? globals.get() : environment.get();
+                    Value r = pop();
+                    Value l = scope->get(chunk.names[ins.a]);
+                    if (l.isNumber() && r.isNumber()) {
+                        Value newVal = binaryOp(OP_ADD, l, r);
+                        scope->assign(chunk.names[ins.a], newVal);
+                        stack.push_back(newVal);
+                    } else {
+                        stack.push_back(Value::number(0));
+                    }
+                    break;
+                }
+                case OP_GET_GLOBAL:
+                    stack.push_back(globals->get(chunk.names[ins.a]));
+                    break;
+                case OP_SET_GLOBAL:
+                    globals->assign(chunk.names[ins.a], stack.back());
+                    break;
+                case OP_GET_LOCAL:
+                    stack.push_back(environment->ancestor(ins.b)->slots[ins.a]);
+                    break;
+                case OP_SET_LOCAL:
+                    environment->ancestor(ins.b)->slots[ins.a] = stack.back();
+                    break;
+                case OP_DEFINE_LOCAL:
+                    environment->slots[ins.a] = pop();
+                    break;
+                case OP_ADD_ASSIGN_LOCAL: {
+                    Value r = pop();
+                    Value& l = environment->ancestor(ins.b)->slots[ins.a];
+                    if (l.getType() == ValueType::Int && r.getType() == ValueType::Int &&
+                        intBinaryOp(OP_ADD, l.intVal(), r.intVal(), l)) {
+                        stack.push_back(l);
+                    } else if (l.isNumber() && r.isNumber()) {
+                        l = binaryOp(OP_ADD, l, r);
+                        stack.push_back(l);
+                    } else {
+                        stack.push_back(Value::number(0));
+                    }
+                    break;
+                }
+                case OP_POP:
+                    stack.pop_back();
+                    break;
+                    
+                case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+                case OP_EQ: case OP_NE: case OP_LT: case OP_GT: case OP_LE: case OP_GE: {
+                    Value r = pop();
+                    Value& l = stack.back();
+                    if (l.getType() == ValueType::Int && r.getType() == ValueType::Int &&
+                        intBinaryOp(ins.op, l.intVal(), r.intVal(), l)) break;
+                    l = binaryOp(ins.op, l, r);
+                    break;
+                }
+                case OP_NOT:
+                    stack.back() = Value::number(!isTrue(stack.back()) ? 1 : 0);
+                    break;
+                case OP_NEG:
+                    stack.back() = negate(stack.back());
+                    break;
+                    
+                case OP_JUMP:
+                    ip = ins.a;
+                    break;
+                case OP_JUMP_IF_FALSE:
+                    if (!isTrue(pop())) ip = ins.a;
+                    break;
+                case OP_AND:
+                    if (!isTrue(stack.back())) ip = ins.a;
+                    else stack.pop_back();
+                    break;
+                case OP_OR:
+                    if (isTrue(stack.back())) ip = ins.a;
+                    else stack.pop_back();
+                    break;
+                    
+                case OP_GET_MEMBER: {
+                    Value obj = pop();
+                    stack.push_back(getMemberCached(obj, static_cast<MemberExpr*>(chunk.exprs[ins.a])));
+                    break;
+                }
+                case OP_GET_INDEX: {
+                    std::string key = pop().toString();
+                    Value obj = pop();
+                    stack.push_back(getMember(obj, key, lookupAtom(key)));
+                    break;
+                }
+                case OP_SET_MEMBER: {
+                    Value obj = pop();
+                    Value val = pop();
+                    stack.push_back(setMemberCached(obj, static_cast<MemberExpr*>(chunk.exprs[ins.a]), val, ins.line));
+                    break;
+                }
+                case OP_SET_INDEX: {
+                    std::string key = pop().toString();
+                    Value obj = pop();
+                    Value val = pop();
+                    stack.push_back(setMember(obj, key, lookupAtom(key), val, ins.line));
+                    break;
+                }
+                case OP_ARRAY: {
+                    std::vector<Value> list(std::make_move_iterator(stack.end() - ins.a), std::make_move_iterator(stack.end()));
+                    stack.resize(stack.size() - ins.a);
+                    stack.push_back(Value(list));
+                    break;
+                }
+                case OP_OBJECT: {
+                    std::map<std::string, Value> map;
+                    size_t first = stack.size() - ins.b;
+                    for (int i = 0; i < ins.b; i++) {
+                        map[atomName(chunk.names[ins.a + i])] = std::move(stack[first + i]);
+                    }
+                    stack.resize(first);
+                    stack.push_back(Value(map));
+                    break;
+                }
+                case OP_CLOSURE: {
+                    auto* func = static_cast<FunctionExpr*>(chunk.exprs[ins.a]);
+                    stack.push_back(Value(func->body, environment, func->params));
+                    break;
+                }
+                    
+                case OP_TAIL_CALL:
+                    currentLine = ins.line;
+                    if (stack[stack.size() - ins.a - 1].isClosure()) {
+                        tailArgs.assign(std::make_move_iterator(stack.end() - ins.a), std::make_move_iterator(stack.end()));
+                        stack.resize(stack.size() - ins.a);
+                        tailCallee = pop();
+                        hasTailCall = true;
+                        completion = Completion::Return;
+                        ip = count;
+                        break;
+                    }
+                    [[fallthrough]];
+                case OP_CALL: {
+                    currentLine = ins.line; // Call records and errors report the line of the call
+                    if (stack[stack.size() - ins.a - 1].isNative()) {
+                        NativeCallArgs args(stack, ins.a);
+                        Value callee = pop();
+                        stack.push_back(callee.nativeFunc()(*this, args.view));
+                        break;
+                    }
+                    std::vector<Value> args(std::make_move_iterator(stack.end() - ins.a), std::make_move_iterator(stack.end()));
+                    stack.resize(stack.size() - ins.a);
+                    Value callee = pop();
+                    static const std::string anonymous;
+                    stack.push_back(callValue(callee, args, ins.b >= 0 ? atomName(chunk.names[ins.b]) : anonymous));
+                    break;
+                }
+                case OP_GET_METHOD: {
+                    auto* site = static_cast<MemberExpr*>(chunk.exprs[ins.a]);
+                    Value obj = pop();
+                    if (findBuiltinMethod(obj, site->key)) {
+                        stack.push_back(std::move(obj));
+                        stack.push_back(Value::boolean(true));
+                    } else {
+                        stack.push_back(getMemberCached(obj, site, true));
+                        stack.push_back(Value::undefined());
+                    }
+                    break;
+                }
+                case OP_TAIL_INVOKE:
+                    currentLine = ins.line;
+                    if (!stack[stack.size() - ins.a - 1].isInt() && stack[stack.size() - ins.a - 2].isClosure()) {
+                        tailArgs.assign(std::make_move_iterator(stack.end() - ins.a), std::make_move_iterator(stack.end()));
+                        stack.resize(stack.size() - ins.a);
+                        pop();
+                        tailCallee = pop();
+                        if (InlineCache* cache = static_cast<MemberExpr*>(chunk.exprs[ins.b])->cache.get()) releaseBinding(*cache);
+                        hasTailCall = true;
+                        completion = Completion::Return;
+                        ip = count;
+                        break;
+                    }
+                    [[fallthrough]];
+                case OP_INVOKE: {
+                    currentLine = ins.line;
+                    if (stack[stack.size() - ins.a - 1].isInt()) {
+                        NativeCallArgs args(stack, ins.a);
+                        pop();
+                        Value target = pop();
+                        BuiltinMethod method = findBuiltinMethod(target, static_cast<MemberExpr*>(chunk.exprs[ins.b])->key);
+                        stack.push_back(method(*this, target, args.view));
+                        break;
+                    }
+                    BindingRelease release{static_cast<MemberExpr*>(chunk.exprs[ins.b])->cache.get()};
+                    std::vector<Value> args(std::make_move_iterator(stack.end() - ins.a), std::make_move_iterator(stack.end()));
+                    stack.resize(stack.size() - ins.a);
+                    pop();
+                    Value target = pop();
+                    static const std::string anonymous;
+                    stack.push_back(callValue(target, args, anonymous));
+                    break;
+                }
+                case OP_RETURN:
+                    lastReturnValue = pop();
+                    completion = Completion::Return;
+                    ip = count;
+                    break;
+                case OP_BREAK:
+                case OP_CONTINUE:
+                    completionLabel = ins.b >= 0 ? chunk.names[ins.b] : NoAtom;
+                    completion = ins.op == OP_BREAK ? Completion::Break : Completion::Continue;
+                    ip = count;
+                    break;
+                    
+                case OP_PUSH_SCOPE:
+                    Gc::maybeCollect();
+                    environment = Environment::make(environment, static_cast<BlockStmt*>(chunk.stmts[ins.a])->locals);
+                    break;
+                case OP_POP_SCOPE:
+                    environment = environment->enclosing;
+                    break;
+                    
+                case OP_EXPR_RESULT:
+                    lastExpressionValue = pop();
+                    hasLastExpressionValue = true;
+                    break;
+                    
+                case OP_EVAL:
+                    stack.push_back(evaluate(chunk.exprs[ins.a]));
+                    break;
+                case OP_EXEC: {
+                    Completion c = execute(chunk.stmts[ins.a]);
+                    if (c == Completion::Normal) break;
+                    if (c != Completion::Return && ins.b > 0) {
+                        int target = loopTarget(chunk, chunk.execSites[ins.b - 1], c, completionLabel, environment);
+                        if (target >= 0) {
+                            ip = target;
+                            break;
+                        }
+                    }
+                    completion = c;
+                    ip = count;
+                    break;
+                }
+            }
+        }
+    } catch (...) {
+        stack.resize(base);
+        environment = entry;
+        throw;
+    }
+    
+    stack.resize(base);
+    environment = entry;
+    return completion;
+}
@@ -2,48 +2,48 @@
 #include <algorithm>
 
 // push(arr, item) -> modified array
-Value array_push(std::vector<Value> args) {
-    if (args.size() < 2 || !args[0].isList) return Value(std::vector<Value>{});
+Value array_push(Interpreter&, NativeArgs args) {
+    if (args.size() < 2 || !args[0].isList()) return Value(std::vector<Value>{});
     
-    args[0].listVal->push_back(args[1]);
+    args[0].listVal()->push_back(args[1]);
     return args[0];
 }
 
 // pop(arr) -> removed item
-Value array_pop(std::vector<Value> args) {
-    if (args.empty() || !args[0].isList || args[0].listVal->empty()) 
+Value array_pop(Interpreter&, NativeArgs args) {
+    if (args.empty() || !args[0].isList() || args[0].listVal()->empty()) 
         return Value("", 0, false);
     
-    Value last = args[0].listVal->back();
-    args[0].listVal->pop_back();
+    Value last = args[0].listVal()->back();
+    args[0].listVal()->pop_back();
     return last;
 }
 
 // shift(arr) -> removed item
-Value array_shift(std::vector<Value> args) {
-    if (args.empty() || !args[0].isList || args[0].listVal->empty()) 
+Value array_shift(Interpreter&, NativeArgs args) {
+    if (args.empty() || !args[0].isList() || args[0].listVal()->empty()) 
         return Value("", 0, false);
     
-    Value first = args[0].listVal->front();
-    args[0].listVal->erase(args[0].listVal->begin());
+    Value first = args[0].listVal()->front();
+    args[0].listVal()->erase(args[0].listVal()->begin());
     return first;
 }
 
 // unshift(arr, item) -> modified array
-Value array_unshift(std::vector<Value> args) {
-    if (args.size() < 2 || !args[0].isList) return Value(std::vector<Value>{});
+Value array_unshift(Interpreter&, NativeArgs args) {
+    if (args.size() < 2 || !args[0].isList()) return Value(std::vector<Value>{});
     
-    args[0].listVal->insert(args[0].listVal->begin(), args[1]);
+    args[0].listVal()->insert(args[0].listVal()->begin(), args[1]);
     return args[0];
 }
 
 // slice(arr, start, end) -> new array
-Value array_slice(std::vector<Value> args) {
-    if (args.empty() || !args[0].isList) return Value(std::vector<Value>{});
+Value array_slice(Interpreter&, NativeArgs args) {
+    if (args.empty() || !args[0].isList()) return Value(std::vector<Value>{});
     
-    auto& list = *args[0].listVal;
-    int start = (args.size() > 1 && args[1].isInt) ? args[1].intVal : 0;
-    int end = (args.size() > 2 && args[2].isInt) ? args[2].intVal : list.size();
+    auto& list = *args[0].listVal();
+    int start = (args.size() > 1 && args[1].isInt()) ? args[1].intVal() : 0;
+    int end = (args.size() > 2 && args[2].isInt()) ? args[2].intVal() : list.size();
     
     if (start < 0) start = 0;
     if (end > (int)list.size()) end = list.size();
@@ -54,41 +54,42 @@ Value array_slice(std::vector<Value> args) {
 }
 
 // concat(arr1, arr2) -> new array
-Value array_concat(std::vector<Value> args) {
-    if (args.size() < 2 || !args[0].isList || !args[1].isList) 
+Value array_concat(Interpreter&, NativeArgs args) {
+    if (args.size() < 2 || !args[0].isList() || !args[1].isList()) 
         return Value(std::vector<Value>{});
     
-    std::vector<Value> result = *args[0].listVal;
-    result.insert(result.end(), args[1].listVal->begin(), args[1].listVal->end());
+    std::vector<Value> result = *args[0].listVal();
+    result.insert(result.end(), args[1].listVal()->begin(), args[1].listVal()->end());
     return Value(result);
 }
 
 // reverse(arr) -> modified array
-Value array_reverse(std::vector<Value> args) {
-    if (args.empty() || !args[0].isList) return Value(std::vector<Value>{});
+Value array_reverse(Interpreter&, NativeArgs args) {
+    if (args.empty() || !args[0].isList()) return Value(std::vector<Value>{});
     
-    std::reverse(args[0].listVal->begin(), args[0].listVal->end());
+    std::reverse(args[0].listVal()->begin(), args[0].listVal()->end());
     return args[0];
 }
 
 // sort(arr) -> modified array
-Value array_sort(std::vector<Value> args) {
-    if (args.empty() || !args[0].isList) return Value(std::vector<Value>{});
+Value array_sort(Interpreter&, NativeArgs args) {
+    if (args.empty() || !args[0].isList()) return Value(std::vector<Value>{});
     
-    std::sort(args[0].listVal->begin(), args[0].listVal->end(), 
+    std::sort(args[0].listVal()->begin(), args[0].listVal()->end(), 
         [](const Value& a, const Value& b) {
-            if (a.isInt && b.isInt) return a.intVal < b.intVal;
+            if (a.isInt() && b.isInt()) return a.intVal() < b.intVal();
+            if (a.isNumber() && b.isNumber()) return a.doubleVal() < b.doubleVal();
             return a.toString() < b.toString();
         });
     return args[0];
 }
 
 // includes(arr, item) -> boolean
-Value array_includes(std::vector<Value> args) {
-    if (args.size() < 2 || !args[0].isList) return Value("", 0, true);
+Value array_includes(Interpreter&, NativeArgs args) {
+    if (args.size() < 2 || !args[0].isList()) return Value("", 0, true);
     
-    for (const auto& item : *args[0].listVal) {
-        if (item.isInt && args[1].isInt && item.intVal == args[1].intVal) 
+    for (const auto& item : *args[0].listVal()) {
+        if (item.isInt() && args[1].isInt() && item.intVal() == args[1].intVal()) 
             return Value("", 1, true);
         if (item.toString() == args[1].toString()) 
             return Value("", 1, true);
@@ -97,12 +98,12 @@ Value array_includes(std::vector<Value> args) {
 }
 
 // indexOf(arr, item) -> int
-Value array_indexOf(std::vector<Value> args) {
-    if (args.size() < 2 || !args[0].isList) return Value("", -1, true);
+Value array_indexOf(Interpreter&, NativeArgs args) {
+    if (args.size() < 2 || !args[0].isList()) return Value("", -1, true);
     
-    auto& list = *args[0].listVal;
+    auto& list = *args[0].listVal();
     for (size_t i = 0; i < list.size(); i++) {
-        if (list[i].isInt && args[1].isInt && list[i].intVal == args[1].intVal) 
+        if (list[i].isInt() && args[1].isInt() && list[i].intVal() == args[1].intVal()) 
             return Value("", (int)i, true);
         if (list[i].toString() == args[1].toString()) 
             return Value("", (int)i, true);
@@ -111,13 +112,13 @@ Value array_indexOf(std::vector<Value> args) {
 }
 
 // join(arr, separator) -> string (alias for string.join)
-Value array_join(std::vector<Value> args) {
-    if (args.empty() || !args[0].isList) return Value("", 0, false);
+Value array_join(Interpreter&, NativeArgs args) {
+    if (args.empty() || !args[0].isList()) return Value("", 0, false);
     
     std::string separator = (args.size() > 1) ? args[1].toString() : ",";
     std::string result;
     
-    auto& list = *args[0].listVal;
+    auto& list = *args[0].listVal();
     for (size_t i = 0; i < list.size(); i++) {
         result += list[i].toString();
         if (i < list.size() - 1) result += separator;
@@ -5,17 +5,17 @@
 #include <vector>
 
 // Array manipulation functions
-Value array_push(std::vector<Value> args);
-Value array_pop(std::vector<Value> args);
-Value array_shift(std::vector<Value> args);
-Value array_unshift(std::vector<Value> args);
-Value array_slice(std::vector<Value> args);
-Value array_concat(std::vector<Value> args);
-Value array_reverse(std::vector<Value> args);
-Value array_sort(std::vector<Value> args);
-Value array_includes(std::vector<Value> args);
-Value array_indexOf(std::vector<Value> args);
-Value array_join(std::vector<Value> args);
+Value array_push(Interpreter&, NativeArgs args);
+Value array_pop(Interpreter&, NativeArgs args);
+Value array_shift(Interpreter&, NativeArgs args);
+Value array_unshift(Interpreter&, NativeArgs args);
+Value array_slice(Interpreter&, NativeArgs args);
+Value array_concat(Interpreter&, NativeArgs args);
+Value array_reverse(Interpreter&, NativeArgs args);
+Value array_sort(Interpreter&, NativeArgs args);
+Value array_includes(Interpreter&, NativeArgs args);
+Value array_indexOf(Interpreter&, NativeArgs args);
+Value array_join(Interpreter&, NativeArgs args);
 
 // Registration function
 void register_array_lib(Interpreter& interp);
@@ -59,10 +59,10 @@ static std::shared_ptr<DatabaseManager> g_dbManager = std::make_shared<DatabaseM
 
 void register_db(Interpreter& interpreter) {
     // connect(url)
-    interpreter.registerNative("db_connect", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("db_connect", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("", 0, false);
         try {
-            bool ok = g_dbManager->connect(args[0].strVal);
+            bool ok = g_dbManager->connect(args[0].strVal());
             return Value("", ok ? 1 : 0, true);
         } catch (const std::exception& e) {
             std::cerr << "DB Error: " << e.what() << std::endl;
@@ -71,13 +71,13 @@ void register_db(Interpreter& interpreter) {
     });
 
     // query(sql, params)
-    interpreter.registerNative("db_query", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("db_query", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value(std::vector<Value>{});
         
-        std::string sql = args[0].strVal;
+        std::string sql = args[0].strVal();
         std::vector<Value> params;
-        if (args.size() > 1 && args[1].isList && args[1].listVal) {
-            params = *args[1].listVal;
+        if (args.size() > 1 && args[1].isList() && args[1].listVal()) {
+            params = *args[1].listVal();
         }
 
         try {
@@ -89,13 +89,13 @@ void register_db(Interpreter& interpreter) {
     });
 
     // execute(sql, params)
-    interpreter.registerNative("db_execute", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("db_execute", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("", 0, true);
         
-        std::string sql = args[0].strVal;
+        std::string sql = args[0].strVal();
         std::vector<Value> params;
-        if (args.size() > 1 && args[1].isList && args[1].listVal) {
-            params = *args[1].listVal;
+        if (args.size() > 1 && args[1].isList() && args[1].listVal()) {
+            params = *args[1].listVal();
         }
 
         try {
@@ -108,13 +108,13 @@ void register_db(Interpreter& interpreter) {
     });
 
     // close()
-    interpreter.registerNative("db_close", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("db_close", [](Interpreter&, NativeArgs args) -> Value {
         g_dbManager->close();
         return Value("", 1, true);
     });
 
     // error()
-    interpreter.registerNative("db_error", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("db_error", [](Interpreter&, NativeArgs args) -> Value {
         return Value(g_dbManager->getError(), 0, false);
     });
 }
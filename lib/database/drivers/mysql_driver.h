@@ -92,10 +92,12 @@ public:
 
         // We need to keep strings alive until mysql_stmt_execute
         std::vector<std::string> strValues;
+        std::vector<long long> intValues(params.size());
         for (size_t i = 0; i < params.size(); i++) {
-            if (params[i].isInt) {
-                bind[i].buffer_type = MYSQL_TYPE_LONG;
-                bind[i].buffer = (char*)&params[i].intVal;
+            if (params[i].isInt()) {
+                bind[i].buffer_type = MYSQL_TYPE_LONGLONG;
+                intValues[i] = params[i].intVal();
+                bind[i].buffer = (char*)&intValues[i];
             } else {
                 strValues.push_back(params[i].toString());
                 bind[i].buffer_type = MYSQL_TYPE_STRING;
@@ -194,10 +196,12 @@ public:
         memset(bind.data(), 0, sizeof(MYSQL_BIND) * params.size());
 
         std::vector<std::string> strValues;
+        std::vector<long long> intValues(params.size());
         for (size_t i = 0; i < params.size(); i++) {
-            if (params[i].isInt) {
-                bind[i].buffer_type = MYSQL_TYPE_LONG;
-                bind[i].buffer = (char*)&params[i].intVal;
+            if (params[i].isInt()) {
+                bind[i].buffer_type = MYSQL_TYPE_LONGLONG;
+                intValues[i] = params[i].intVal();
+                bind[i].buffer = (char*)&intValues[i];
             } else {
                 strValues.push_back(params[i].toString());
                 bind[i].buffer_type = MYSQL_TYPE_STRING;
@@ -80,7 +80,9 @@ public:
                 int type = sqlite3_column_type(stmt, i);
                 
                 if (type == SQLITE_INTEGER) {
-                    row[name] = Value("", sqlite3_column_int(stmt, i), true);
+                    row[name] = Value::number(sqlite3_column_int64(stmt, i));
+                } else if (type == SQLITE_FLOAT) {
+                    row[name] = Value::real(sqlite3_column_double(stmt, i));
                 } else if (type == SQLITE_NULL) {
                     row[name] = Value("null", 0, false);
                 } else {
@@ -108,10 +110,12 @@ private:
         for (size_t i = 0; i < params.size(); i++) {
             const Value& v = params[i];
             int idx = i + 1;
-            if (v.isInt) {
-                sqlite3_bind_int(stmt, idx, v.intVal);
+            if (v.isInt()) {
+                sqlite3_bind_int64(stmt, idx, v.intVal());
+            } else if (v.isDouble()) {
+                sqlite3_bind_double(stmt, idx, v.doubleVal());
             } else {
-                sqlite3_bind_text(stmt, idx, v.strVal.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(stmt, idx, v.strVal().c_str(), -1, SQLITE_TRANSIENT);
             }
         }
     }
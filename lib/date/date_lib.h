@@ -7,11 +7,11 @@
 struct DateLib {
     static void register_date(Interpreter& interpreter) {
         // DateNow() - returns milliseconds since epoch
-        auto dateNow = [](std::vector<Value> args) {
+        auto dateNow = [](Interpreter&, NativeArgs args) {
             auto now = std::chrono::system_clock::now();
             auto duration = now.time_since_epoch();
             auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
-            return Value("", static_cast<int>(millis), true);
+            return Value::number(static_cast<int64_t>(millis));
         };
         interpreter.globals->define("DateNow", Value(dateNow));
         interpreter.natives["DateNow"] = dateNow;
@@ -13,9 +13,9 @@
 namespace ExecLib {
 
 // exec(command) -> string (output)
-Value exec_run(std::vector<Value> args) {
+Value exec_run(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, false);
-    std::string cmd = args[0].strVal;
+    std::string cmd = args[0].strVal();
     
     std::array<char, 128> buffer;
     std::string result;
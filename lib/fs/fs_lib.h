@@ -12,9 +12,9 @@ namespace fs = std::filesystem;
 namespace FSLib {
 
 // readFile(path) -> string
-Value fs_readFile(std::vector<Value> args) {
+Value fs_readFile(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, false);
-    std::string path = args[0].strVal;
+    std::string path = args[0].strVal();
     
     std::ifstream file(path);
     if (!file.is_open()) return Value("undefined", 0, false);
@@ -25,9 +25,9 @@ Value fs_readFile(std::vector<Value> args) {
 }
 
 // writeFile(path, content) -> bool
-Value fs_writeFile(std::vector<Value> args) {
+Value fs_writeFile(Interpreter&, NativeArgs args) {
     if (args.size() < 2) return Value("", 0, true);
-    std::string path = args[0].strVal;
+    std::string path = args[0].strVal();
     std::string content = args[1].toString();
     
     std::ofstream file(path);
@@ -38,20 +38,20 @@ Value fs_writeFile(std::vector<Value> args) {
 }
 
 // exists(path) -> bool
-Value fs_exists(std::vector<Value> args) {
+Value fs_exists(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, true);
-    return Value("", fs::exists(args[0].strVal) ? 1 : 0, true);
+    return Value("", fs::exists(args[0].strVal()) ? 1 : 0, true);
 }
 
 // isDirectory(path) -> bool
-Value fs_isDirectory(std::vector<Value> args) {
+Value fs_isDirectory(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, true);
-    return Value("", fs::is_directory(args[0].strVal) ? 1 : 0, true);
+    return Value("", fs::is_directory(args[0].strVal()) ? 1 : 0, true);
 }
 
 // listDir(path) -> array of strings
-Value fs_listDir(std::vector<Value> args) {
-    std::string path = args.empty() ? "." : args[0].strVal;
+Value fs_listDir(Interpreter&, NativeArgs args) {
+    std::string path = args.empty() ? "." : args[0].strVal();
     std::vector<Value> result;
     
     try {
@@ -66,10 +66,10 @@ Value fs_listDir(std::vector<Value> args) {
 }
 
 // mkdir(path) -> bool
-Value fs_mkdir(std::vector<Value> args) {
+Value fs_mkdir(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, true);
     try {
-        bool ok = fs::create_directories(args[0].strVal);
+        bool ok = fs::create_directories(args[0].strVal());
         return Value("", ok ? 1 : 0, true);
     } catch (...) {
         return Value("", 0, true);
@@ -77,10 +77,10 @@ Value fs_mkdir(std::vector<Value> args) {
 }
 
 // remove(path) -> bool
-Value fs_remove(std::vector<Value> args) {
+Value fs_remove(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, true);
     try {
-        bool ok = fs::remove_all(args[0].strVal) > 0;
+        bool ok = fs::remove_all(args[0].strVal()) > 0;
         return Value("", ok ? 1 : 0, true);
     } catch (...) {
         return Value("", 0, true);
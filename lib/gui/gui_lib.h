@@ -5,9 +5,9 @@
 struct GuiLib {
     static void register_gui(Interpreter& interpreter) {
          // 1. Bind Click (Generic)
-         interpreter.registerNative("bind_native_click", [&](std::vector<Value> args) {
-              if (args.size() >= 2 && args[1].isClosure) {
-                  std::string id = args[0].strVal;
+         interpreter.registerNative("bind_native_click", [&](Interpreter&, NativeArgs args) {
+              if (args.size() >= 2 && args[1].isCallable()) {
+                  std::string id = args[0].strVal();
                   Value v = args[1]; // Capture Value
                   bind_click(id, [id, v, &interpreter]() { 
                       interpreter.executeClosure(v); 
@@ -18,9 +18,9 @@ struct GuiLib {
          });
          
          // 2. Update Hook Native
-         interpreter.registerNative("updateHook", [&](std::vector<Value> args) {
+         interpreter.registerNative("updateHook", [&](Interpreter&, NativeArgs args) {
              if (args.size() >= 2) {
-                 int idx = args[0].intVal;
+                 int idx = args[0].intVal();
                  Value newVal = args[1];
                  if (idx >= 0 && idx < interpreter.hooks.size()) {
                      interpreter.hooks[idx] = newVal;
@@ -31,9 +31,9 @@ struct GuiLib {
          });
          
          // 2b. Bind Input (for Textfield onInput with value parameter)
-         interpreter.registerNative("bind_native_input", [&](std::vector<Value> args) {
-              if (args.size() >= 2 && args[1].isClosure) {
-                  std::string id = args[0].strVal;
+         interpreter.registerNative("bind_native_input", [&](Interpreter&, NativeArgs args) {
+              if (args.size() >= 2 && args[1].isCallable()) {
+                  std::string id = args[0].strVal();
                   Value v = args[1]; // Capture closure
                   bind_change(id, [id, v, &interpreter](std::string newValue) { 
                       // Call closure with new value as parameter
@@ -46,7 +46,7 @@ struct GuiLib {
          });
          
          // 3. Bridge setState (Hooks Style)
-         interpreter.registerNative("setState", [&](std::vector<Value> args) {
+         interpreter.registerNative("setState", [&](Interpreter&, NativeArgs args) {
               int idx = interpreter.hookIndex++;
               if (idx >= interpreter.hooks.size()) {
                   if (args.empty()) {
@@ -57,17 +57,14 @@ struct GuiLib {
               }
               Value currentVal = interpreter.hooks[idx];
               
-              Value setterClosure(std::make_shared<BlockStmt>(), nullptr, std::vector<std::string>{"newVal"});
-              setterClosure.isClosure = true;
-              setterClosure.isNative = true;
-              setterClosure.nativeId = "hook_cb_" + std::to_string(idx); // Stable ID for hook setter
-              setterClosure.nativeFunc = [idx, &interpreter](std::vector<Value> innerArgs) {
+              // Stable ID for hook setter
+              Value setterClosure([idx, &interpreter](Interpreter&, NativeArgs innerArgs) {
                    if (innerArgs.size() > 0) {
                        interpreter.hooks[idx] = innerArgs[0];
                        request_rerender();
                    }
                    return Value("", 0, true);
-              };
+              }, "hook_cb_" + std::to_string(idx));
               
               // Return [value, setter]
               std::vector<Value> retList;
@@ -77,9 +74,9 @@ struct GuiLib {
          });
 
          // 4. Render GUI
-         interpreter.registerNative("render_gui", [&](std::vector<Value> args) {
+         interpreter.registerNative("render_gui", [&](Interpreter&, NativeArgs args) {
              std::cout << "Starting GUI from Anis..." << std::endl;
-             if (args.size() > 0 && args[0].isClosure) {
+             if (args.size() > 0 && args[0].isClosure()) {
                   Value component = args[0]; // The App function
                   
                   // Initialize Minigui with Main Loop
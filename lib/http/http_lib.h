@@ -32,6 +32,7 @@ static std::string fetch(const std::string& method, const std::string& url, cons
         curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
         curl_easy_setopt(curl, CURLOPT_USERAGENT, "Anis/1.0");
         curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // Also called on the module prefetch threads
 
         // Set Method
         if (method == "POST") {
@@ -81,10 +82,10 @@ static std::string fetch(const std::string& method, const std::string& url, cons
 // Helper to extract headers from options map
 static std::map<std::string, std::string> extract_headers(const Value& options) {
     std::map<std::string, std::string> headers;
-    if (options.isMap) {
-        auto it = options.mapVal->find("headers");
-        if (it != options.mapVal->end() && it->second.isMap) {
-            for (auto const& [key, val] : *it->second.mapVal) {
+    if (options.isMap()) {
+        auto it = options.mapVal()->find("headers");
+        if (it != options.mapVal()->end() && it->second.isMap()) {
+            for (auto const& [key, val] : *it->second.mapVal()) {
                 headers[key] = val.toString();
             }
         }
@@ -93,7 +94,7 @@ static std::map<std::string, std::string> extract_headers(const Value& options)
 }
 
 inline void register_http(Interpreter& interpreter) {
-    interpreter.registerNative("http_get", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("http_get", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("undefined", 0, false);
         std::string url = args[0].toString();
         std::map<std::string, std::string> headers;
@@ -103,7 +104,7 @@ inline void register_http(Interpreter& interpreter) {
         return Value(res, 0, false);
     });
 
-    interpreter.registerNative("http_post", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("http_post", [](Interpreter&, NativeArgs args) -> Value {
         if (args.size() < 2) return Value("undefined", 0, false);
         std::string url = args[0].toString();
         std::string body = args[1].toString();
@@ -114,7 +115,7 @@ inline void register_http(Interpreter& interpreter) {
         return Value(res, 0, false);
     });
 
-    interpreter.registerNative("http_put", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("http_put", [](Interpreter&, NativeArgs args) -> Value {
         if (args.size() < 2) return Value("undefined", 0, false);
         std::string url = args[0].toString();
         std::string body = args[1].toString();
@@ -125,7 +126,7 @@ inline void register_http(Interpreter& interpreter) {
         return Value(res, 0, false);
     });
 
-    interpreter.registerNative("http_patch", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("http_patch", [](Interpreter&, NativeArgs args) -> Value {
         if (args.size() < 2) return Value("undefined", 0, false);
         std::string url = args[0].toString();
         std::string body = args[1].toString();
@@ -136,14 +137,14 @@ inline void register_http(Interpreter& interpreter) {
         return Value(res, 0, false);
     });
 
-    interpreter.registerNative("http_delete", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("http_delete", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("undefined", 0, false);
         std::string url = args[0].toString();
         std::string body = "";
         std::map<std::string, std::string> headers;
         
         if (args.size() > 1) {
-            if (!args[1].isMap) {
+            if (!args[1].isMap()) {
                 body = args[1].toString();
                 if (args.size() > 2) headers = extract_headers(args[2]);
             } else {
@@ -155,24 +156,24 @@ inline void register_http(Interpreter& interpreter) {
         return Value(res, 0, false);
     });
 
-    interpreter.registerNative("http", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("http", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("undefined", 0, false);
         std::string url = args[0].toString();
         std::string method = "GET";
         std::string body = "";
         std::map<std::string, std::string> headers;
 
-        if (args.size() > 1 && args[1].isMap) {
+        if (args.size() > 1 && args[1].isMap()) {
             const Value& opts = args[1];
-            auto m_it = opts.mapVal->find("method");
-            if (m_it != opts.mapVal->end()) {
+            auto m_it = opts.mapVal()->find("method");
+            if (m_it != opts.mapVal()->end()) {
                 method = m_it->second.toString();
                 // Uppercase the method
                 std::transform(method.begin(), method.end(), method.begin(), ::toupper);
             }
 
-            auto b_it = opts.mapVal->find("body");
-            if (b_it != opts.mapVal->end()) {
+            auto b_it = opts.mapVal()->find("body");
+            if (b_it != opts.mapVal()->end()) {
                 body = b_it->second.toString();
             }
 
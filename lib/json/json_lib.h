@@ -51,7 +51,7 @@ class JsonParser {
             Value key = parseString();
             skipWhitespace();
             if (advance() != ':') break;
-            map[key.strVal] = parseValue();
+            map[key.strVal()] = parseValue();
             skipWhitespace();
             if (peek() == ',') advance();
         }
@@ -103,8 +103,12 @@ class JsonParser {
             advance();
             while (std::isdigit(peek())) advance();
         }
-        int val = std::stoi(source.substr(start, pos - start));
-        return Value("", val, true);
+        if (peek() == 'e' || peek() == 'E') {
+            advance();
+            if (peek() == '+' || peek() == '-') advance();
+            while (std::isdigit(peek())) advance();
+        }
+        return Value::parseNumber(source.substr(start, pos - start));
     }
 
 public:
@@ -113,7 +117,7 @@ public:
 };
 
 void register_json(Interpreter& interpreter) {
-    interpreter.registerNative("json_parse", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("json_parse", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("undefined", 0, false);
         JsonParser parser(args[0].toString());
         return parser.parse();
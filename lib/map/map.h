@@ -6,12 +6,12 @@
 #include <string>
 
 // Map/Object manipulation functions
-Value map_keys(std::vector<Value> args);
-Value map_values(std::vector<Value> args);
-Value map_entries(std::vector<Value> args);
-Value map_has(std::vector<Value> args);
-Value map_merge(std::vector<Value> args);
-Value map_clone(std::vector<Value> args);
+Value map_keys(Interpreter&, NativeArgs args);
+Value map_values(Interpreter&, NativeArgs args);
+Value map_entries(Interpreter&, NativeArgs args);
+Value map_has(Interpreter&, NativeArgs args);
+Value map_merge(Interpreter&, NativeArgs args);
+Value map_clone(Interpreter&, NativeArgs args);
 
 // Registration function
 void register_map_lib(Interpreter& interp);
@@ -16,26 +16,26 @@
 namespace OSLib {
 
 // getenv(name) -> string
-Value os_getenv(std::vector<Value> args) {
+Value os_getenv(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("undefined", 0, false);
-    char* val = std::getenv(args[0].strVal.c_str());
+    char* val = std::getenv(args[0].strVal().c_str());
     if (!val) return Value("undefined", 0, false);
     return Value(std::string(val), 0, false);
 }
 
 // setenv(name, value) -> bool
-Value os_setenv(std::vector<Value> args) {
+Value os_setenv(Interpreter&, NativeArgs args) {
     if (args.size() < 2) return Value("", 0, true);
 #ifdef _WIN32
-    int res = _putenv_s(args[0].strVal.c_str(), args[1].toString().c_str());
+    int res = _putenv_s(args[0].strVal().c_str(), args[1].toString().c_str());
 #else
-    int res = setenv(args[0].strVal.c_str(), args[1].toString().c_str(), 1);
+    int res = setenv(args[0].strVal().c_str(), args[1].toString().c_str(), 1);
 #endif
     return Value("", res == 0 ? 1 : 0, true);
 }
 
 // platform() -> string
-Value os_platform(std::vector<Value> args) {
+Value os_platform(Interpreter&, NativeArgs args) {
 #ifdef _WIN32
     return Value("windows", 0, false);
 #elif __APPLE__
@@ -46,7 +46,7 @@ Value os_platform(std::vector<Value> args) {
 }
 
 // cwd() -> string
-Value os_cwd(std::vector<Value> args) {
+Value os_cwd(Interpreter&, NativeArgs args) {
     char buf[1024];
     if (getcwd(buf, sizeof(buf))) {
         return Value(std::string(buf), 0, false);
@@ -9,7 +9,7 @@
 namespace RegexLib {
 
 // match(str, pattern) -> bool
-Value regex_match(std::vector<Value> args) {
+Value regex_match(Interpreter&, NativeArgs args) {
     if (args.size() < 2) return Value("", 0, true);
     std::string str = args[0].toString();
     std::string pattern = args[1].toString();
@@ -23,7 +23,7 @@ Value regex_match(std::vector<Value> args) {
 }
 
 // search(str, pattern) -> bool
-Value regex_search(std::vector<Value> args) {
+Value regex_search(Interpreter&, NativeArgs args) {
     if (args.size() < 2) return Value("", 0, true);
     std::string str = args[0].toString();
     std::string pattern = args[1].toString();
@@ -37,7 +37,7 @@ Value regex_search(std::vector<Value> args) {
 }
 
 // replace(str, pattern, replacement) -> string
-Value regex_replace(std::vector<Value> args) {
+Value regex_replace(Interpreter&, NativeArgs args) {
     if (args.size() < 3) return Value("", 0, false);
     std::string str = args[0].toString();
     std::string pattern = args[1].toString();
@@ -74,38 +74,52 @@ void register_std_libs(Interpreter& interpreter) {
     HTTPLib::register_http(interpreter);
 
     // Error Class
-    interpreter.registerNative("Error", [](std::vector<Value> args) -> Value {
-        std::map<std::string, Value> errorObj;
-        errorObj["message"] = args.empty() ? Value("", 0, false) : args[0];
-        errorObj["toString"] = Value([errorObj](std::vector<Value> a) -> Value {
-            return errorObj.at("message");
-        });
-        return Value(errorObj);
+    interpreter.registerNative("Error", [](Interpreter&, NativeArgs args) -> Value {
+        return Interpreter::errorValue("Error", args.empty() ? Value("", 0, false) : args[0]);
+    });
+    // Thrown by the interpreter when the call depth limit is reached
+    interpreter.registerNative("RangeError", [](Interpreter&, NativeArgs args) -> Value {
+        return Interpreter::errorValue("RangeError", args.empty() ? Value("", 0, false) : args[0]);
     });
 
     // logger Object
     std::map<std::string, Value> logger;
-    logger["info"] = Value([](std::vector<Value> args) -> Value {
+    logger["info"] = Value([](Interpreter&, NativeArgs args) -> Value {
         for (const auto& arg : args) std::cout << arg.toString() << " ";
         std::cout << std::endl;
         return Value("", 0, false);
     });
-    logger["error"] = Value([](std::vector<Value> args) -> Value {
+    logger["error"] = Value([](Interpreter&, NativeArgs args) -> Value {
         std::cerr << COLOR_RED;
         for (const auto& arg : args) std::cerr << arg.toString() << " ";
         std::cerr << COLOR_RESET << std::endl;
+        return Value("", 0, false);
     });
     interpreter.globals->define("console", Value(logger));
 
     // Delay Builtin
-    interpreter.registerNative("delay", [](std::vector<Value> args) -> Value {
-        if (args.empty() || !args[0].isInt) return Value("", 0, false);
-        std::this_thread::sleep_for(std::chrono::milliseconds(args[0].intVal));
+    interpreter.registerNative("delay", [](Interpreter&, NativeArgs args) -> Value {
+        if (args.empty() || !args[0].isInt()) return Value("", 0, false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(args[0].intVal()));
         return Value("", 0, false);
     });
 
+    // gc_stats() - cycle collector and frame pool counters (pause times in microseconds)
+    interpreter.registerNative("gc_stats", [](Interpreter&, NativeArgs) -> Value {
+        const GcStats& gc = Gc::stats();
+        std::map<std::string, Value> stats;
+        stats["objects"] = Value::number((int64_t)gc.objects);
+        stats["frameBytes"] = Value::number((int64_t)framePool.reservedBytes());
+        stats["collections"] = Value::number((int64_t)gc.collections);
+        stats["freed"] = Value::number((int64_t)gc.freed);
+        stats["lastPauseUs"] = Value::number((int64_t)(gc.lastPauseMs * 1000));
+        stats["maxPauseUs"] = Value::number((int64_t)(gc.maxPauseMs * 1000));
+        stats["totalPauseUs"] = Value::number((int64_t)(gc.totalPauseMs * 1000));
+        return Value(stats);
+    });
+
     // Env Builtin
-    interpreter.registerNative("env", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("env", [](Interpreter&, NativeArgs args) -> Value {
         static std::map<std::string, std::string> envCache;
         static bool loaded = false;
 
@@ -124,8 +138,8 @@ void register_std_libs(Interpreter& interpreter) {
             loaded = true;
         }
 
-        if (args.empty() || !args[0].isInt == false) return Value("", 0, false); // Expect string
-        std::string key = args[0].strVal;
+        if (args.empty() || !args[0].isInt() == false) return Value("", 0, false); // Expect string
+        std::string key = args[0].strVal();
         
         if (envCache.count(key)) return Value(envCache[key], 0, false);
         
@@ -136,33 +150,34 @@ void register_std_libs(Interpreter& interpreter) {
     });
 
     // Number() - Convert to number
-    interpreter.registerNative("Number", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("Number", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("", 0, true); // Number() = 0
         
         Value v = args[0];
         
         // Already a number
-        if (v.isInt) return v;
+        if (v.isNumber()) return v;
         
         // Boolean to number
-        if (v.strVal == "true") return Value("", 1, true);
-        if (v.strVal == "false") return Value("", 0, true);
+        if (v.strVal() == "true") return Value("", 1, true);
+        if (v.strVal() == "false") return Value("", 0, true);
         
         // String to number
-        if (!v.isInt) {
-            try {
-                int num = std::stoi(v.strVal);
-                return Value("", num, true);
-            } catch (...) {
-                return Value("", 0, true); // NaN equivalent = 0
-            }
+        if (!v.isNumber()) {
+            const std::string& s = v.strVal();
+            size_t start = s.find_first_not_of(" \t\r\n");
+            if (start == std::string::npos) return Value("", 0, true);
+            char* end = nullptr;
+            std::strtod(s.c_str() + start, &end);
+            if (end == s.c_str() + start) return Value("", 0, true); // NaN equivalent = 0
+            return Value::parseNumber(s.substr(start, end - (s.c_str() + start)));
         }
         
         return Value("", 0, true);
     });
 
     // String() - Convert to string
-    interpreter.registerNative("String", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("String", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("", 0, false);
         
         Value v = args[0];
@@ -172,19 +187,19 @@ void register_std_libs(Interpreter& interpreter) {
     });
 
     // Boolean() - Convert to boolean
-    interpreter.registerNative("Boolean", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("Boolean", [](Interpreter&, NativeArgs args) -> Value {
         if (args.empty()) return Value("false", 0, false);
         
         Value v = args[0];
         
         // Number to boolean
-        if (v.isInt) {
-            return Value(v.intVal != 0 ? "true" : "false", 0, false);
+        if (v.isNumber()) {
+            return Value(v.isTruthy() ? "true" : "false", 0, false);
         }
         
         // String to boolean (empty string = false, others = true)
-        if (!v.isInt) {
-            bool isTruthy = !v.strVal.empty() && v.strVal != "false" && v.strVal != "0";
+        if (!v.isNumber()) {
+            bool isTruthy = !v.strVal().empty() && v.strVal() != "false" && v.strVal() != "0";
             return Value(isTruthy ? "true" : "false", 0, false);
         }
         
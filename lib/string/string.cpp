@@ -12,7 +12,7 @@ std::string trim_helper(const std::string& str) {
 }
 
 // split(str, delimiter) -> array
-Value string_split(std::vector<Value> args) {
+Value string_split(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value(std::vector<Value>{});
     
     std::string str = args[0].toString();
@@ -41,13 +41,13 @@ Value string_split(std::vector<Value> args) {
 }
 
 // join(array, separator) -> string
-Value string_join(std::vector<Value> args) {
-    if (args.empty() || !args[0].isList) return Value("", 0, false);
+Value string_join(Interpreter&, NativeArgs args) {
+    if (args.empty() || !args[0].isList()) return Value("", 0, false);
     
     std::string separator = (args.size() > 1) ? args[1].toString() : ",";
     std::string result;
     
-    auto& list = *args[0].listVal;
+    auto& list = *args[0].listVal();
     for (size_t i = 0; i < list.size(); i++) {
         result += list[i].toString();
         if (i < list.size() - 1) result += separator;
@@ -57,13 +57,13 @@ Value string_join(std::vector<Value> args) {
 }
 
 // trim(str) -> string
-Value string_trim(std::vector<Value> args) {
+Value string_trim(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, false);
     return Value(trim_helper(args[0].toString()), 0, false);
 }
 
 // replace(str, search, replace) -> string
-Value string_replace(std::vector<Value> args) {
+Value string_replace(Interpreter&, NativeArgs args) {
     if (args.size() < 3) return Value("", 0, false);
     
     std::string str = args[0].toString();
@@ -82,7 +82,7 @@ Value string_replace(std::vector<Value> args) {
 }
 
 // toUpperCase(str) -> string
-Value string_toUpperCase(std::vector<Value> args) {
+Value string_toUpperCase(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, false);
     
     std::string str = args[0].toString();
@@ -91,7 +91,7 @@ Value string_toUpperCase(std::vector<Value> args) {
 }
 
 // toLowerCase(str) -> string
-Value string_toLowerCase(std::vector<Value> args) {
+Value string_toLowerCase(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, false);
     
     std::string str = args[0].toString();
@@ -100,7 +100,7 @@ Value string_toLowerCase(std::vector<Value> args) {
 }
 
 // startsWith(str, prefix) -> boolean
-Value string_startsWith(std::vector<Value> args) {
+Value string_startsWith(Interpreter&, NativeArgs args) {
     if (args.size() < 2) return Value("", 0, true);
     
     std::string str = args[0].toString();
@@ -112,7 +112,7 @@ Value string_startsWith(std::vector<Value> args) {
 }
 
 // endsWith(str, suffix) -> boolean
-Value string_endsWith(std::vector<Value> args) {
+Value string_endsWith(Interpreter&, NativeArgs args) {
     if (args.size() < 2) return Value("", 0, true);
     
     std::string str = args[0].toString();
@@ -124,7 +124,7 @@ Value string_endsWith(std::vector<Value> args) {
 }
 
 // indexOf(str, search) -> int
-Value string_indexOf(std::vector<Value> args) {
+Value string_indexOf(Interpreter&, NativeArgs args) {
     if (args.size() < 2) return Value("", -1, true);
     
     std::string str = args[0].toString();
@@ -134,26 +134,26 @@ Value string_indexOf(std::vector<Value> args) {
     return Value("", (pos != std::string::npos) ? (int)pos : -1, true);
 }
 
-Value string_find(std::vector<Value> args) {
-    return string_indexOf(args);
+Value string_find(Interpreter& interp, NativeArgs args) {
+    return string_indexOf(interp, args);
 }
 
 // concat(str1, str2, ...) -> string
-Value string_concat(std::vector<Value> args) {
+Value string_concat(Interpreter&, NativeArgs args) {
     std::string result;
     for (auto& arg : args) {
-        result += arg.toString();
+        arg.appendString(result);
     }
     return Value(result, 0, false);
 }
 
 // substring(str, start, end) -> string
-Value string_substring(std::vector<Value> args) {
+Value string_substring(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, false);
     
     std::string str = args[0].toString();
-    int start = (args.size() > 1 && args[1].isInt) ? args[1].intVal : 0;
-    int end = (args.size() > 2 && args[2].isInt) ? args[2].intVal : str.length();
+    int start = (args.size() > 1 && args[1].isInt()) ? args[1].intVal() : 0;
+    int end = (args.size() > 2 && args[2].isInt()) ? args[2].intVal() : str.length();
     
     if (start < 0) start = 0;
     if (end > (int)str.length()) end = str.length();
@@ -163,9 +163,33 @@ Value string_substring(std::vector<Value> args) {
 }
 
 // length(str) -> int
-Value string_length(std::vector<Value> args) {
+Value string_length(Interpreter&, NativeArgs args) {
     if (args.empty()) return Value("", 0, true);
-    return Value("", (int)args[0].toString().length(), true);
+    return Value::number((int64_t)args[0].stringLength());
+}
+
+// StringBuilder(...values) -> { append(...values), toString(), length(), clear() }
+// Appends in place, for building large strings piece by piece
+Value string_builder(Interpreter&, NativeArgs args) {
+    auto buffer = std::make_shared<std::string>();
+    for (auto& arg : args) arg.appendString(*buffer);
+    
+    std::map<std::string, Value> builder;
+    builder["append"] = Value([buffer](Interpreter&, NativeArgs args) -> Value {
+        for (auto& arg : args) arg.appendString(*buffer);
+        return Value::number((int64_t)buffer->size());
+    });
+    builder["toString"] = Value([buffer](Interpreter&, NativeArgs) -> Value {
+        return Value(*buffer, 0, false);
+    });
+    builder["length"] = Value([buffer](Interpreter&, NativeArgs) -> Value {
+        return Value::number((int64_t)buffer->size());
+    });
+    builder["clear"] = Value([buffer](Interpreter&, NativeArgs) -> Value {
+        buffer->clear();
+        return Value::number(0);
+    });
+    return Value(builder);
 }
 
 // Register all string functions
@@ -183,4 +207,5 @@ void register_string_lib(Interpreter& interp) {
     interp.registerNative("concat", string_concat);
     interp.registerNative("substring", string_substring);
     interp.registerNative("str_length", string_length);
+    interp.registerNative("StringBuilder", string_builder);
 }
@@ -6,19 +6,20 @@
 #include <vector>
 
 // String manipulation functions
-Value string_split(std::vector<Value> args);
-Value string_join(std::vector<Value> args);
-Value string_trim(std::vector<Value> args);
-Value string_replace(std::vector<Value> args);
-Value string_toUpperCase(std::vector<Value> args);
-Value string_toLowerCase(std::vector<Value> args);
-Value string_startsWith(std::vector<Value> args);
-Value string_endsWith(std::vector<Value> args);
-Value string_indexOf(std::vector<Value> args);
-Value string_find(std::vector<Value> args); // Alias for indexOf
-Value string_concat(std::vector<Value> args);
-Value string_substring(std::vector<Value> args);
-Value string_length(std::vector<Value> args);
+Value string_split(Interpreter&, NativeArgs args);
+Value string_join(Interpreter&, NativeArgs args);
+Value string_trim(Interpreter&, NativeArgs args);
+Value string_replace(Interpreter&, NativeArgs args);
+Value string_toUpperCase(Interpreter&, NativeArgs args);
+Value string_toLowerCase(Interpreter&, NativeArgs args);
+Value string_startsWith(Interpreter&, NativeArgs args);
+Value string_endsWith(Interpreter&, NativeArgs args);
+Value string_indexOf(Interpreter&, NativeArgs args);
+Value string_find(Interpreter&, NativeArgs args); // Alias for indexOf
+Value string_concat(Interpreter&, NativeArgs args);
+Value string_substring(Interpreter&, NativeArgs args);
+Value string_length(Interpreter&, NativeArgs args);
+Value string_builder(Interpreter&, NativeArgs args);
 
 // Registration function
 void register_string_lib(Interpreter& interp);
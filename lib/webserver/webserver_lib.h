@@ -130,8 +130,8 @@ public:
                 
                 // Add next() function
                 // Requires direct access to mapVal shared_ptr
-                if (ctx.isMap && ctx.mapVal) {
-                     (*ctx.mapVal)["next"] = Value([&, i](std::vector<Value> args) -> Value {
+                if (ctx.isMap() && ctx.mapVal()) {
+                     (*ctx.mapVal())["next"] = Value([&, i](Interpreter&, NativeArgs args) -> Value {
                          dispatch(i + 1);
                          return Value("", 0, false);
                      });
@@ -161,9 +161,9 @@ public:
         req_map["path"] = Value(req.path, 0, false);
         req_map["method"] = Value(req.method, 0, false);
         req_map["body"] = Value(req.body, 0, false);
-        req_map["param"] = Value([params](std::vector<Value> args) -> Value {
+        req_map["param"] = Value([params](Interpreter&, NativeArgs args) -> Value {
             if (args.empty()) return Value("undefined", 0, false);
-            std::string p = args[0].strVal;
+            std::string p = args[0].strVal();
             if (params.count(p)) return Value(params.at(p), 0, false);
              return Value("undefined", 0, false);
         });
@@ -175,14 +175,14 @@ public:
         }
         req_map["params"] = Value(params_obj);
 
-        req_map["header"] = Value([req](std::vector<Value> args) -> Value {
+        req_map["header"] = Value([req](Interpreter&, NativeArgs args) -> Value {
              if (args.empty()) return Value("undefined", 0, false);
-             std::string h = args[0].strVal;
+             std::string h = args[0].strVal();
              // Headers are typically case-insensitive but for simplicity direct match
              if (req.headers.count(h)) return Value(req.headers.at(h), 0, false);
               return Value("undefined", 0, false);
         });
-        req_map["json"] = Value([req](std::vector<Value> args) -> Value {
+        req_map["json"] = Value([req](Interpreter&, NativeArgs args) -> Value {
              JSONLib::JsonParser parser(req.body);
              return parser.parse();
         });
@@ -195,25 +195,25 @@ public:
             }
         };
 
-        ctx_map["text"] = Value([send_res](std::vector<Value> args) -> Value {
+        ctx_map["text"] = Value([send_res](Interpreter&, NativeArgs args) -> Value {
             std::string body = args.empty() ? "" : args[0].toString();
             std::string res = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body;
             send_res(res);
             return Value(res, 0, false); // For chaining if needed, but mainly side-effect
         });
-        ctx_map["json"] = Value([send_res](std::vector<Value> args) -> Value {
+        ctx_map["json"] = Value([send_res](Interpreter&, NativeArgs args) -> Value {
              std::string body = args.empty() ? "{}" : args[0].toJson();
              std::string res = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body;
              send_res(res);
              return Value(res, 0, false);
         });
-        ctx_map["html"] = Value([send_res](std::vector<Value> args) -> Value {
+        ctx_map["html"] = Value([send_res](Interpreter&, NativeArgs args) -> Value {
              std::string body = args.empty() ? "" : args[0].toString();
              std::string res = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body;
              send_res(res);
              return Value(res, 0, false);
         });
-        ctx_map["status"] = Value([ctx_map](std::vector<Value> args) -> Value {
+        ctx_map["status"] = Value([ctx_map](Interpreter&, NativeArgs args) -> Value {
              // Mock status chaining
              return Value(ctx_map);
         });
@@ -227,22 +227,22 @@ static std::vector<std::shared_ptr<ServerInstance>> g_servers;
 void register_webserver(Interpreter& interpreter) {
     static Interpreter* s_interpreter = &interpreter; 
     
-    interpreter.registerNative("Webserver", [](std::vector<Value> args) -> Value {
+    interpreter.registerNative("Webserver", [](Interpreter&, NativeArgs args) -> Value {
         auto instance = std::make_shared<ServerInstance>();
         g_servers.push_back(instance);
         
         std::map<std::string, Value> server_obj;
         
-        server_obj["use"] = Value([instance](std::vector<Value> args) -> Value {
+        server_obj["use"] = Value([instance](Interpreter&, NativeArgs args) -> Value {
             if (args.empty()) return Value("", 0, false);
             instance->use(args[0]);
             return Value("", 1, true);
         });
 
         // Group Implementation
-        server_obj["group"] = Value([instance](std::vector<Value> args) -> Value {
+        server_obj["group"] = Value([instance](Interpreter&, NativeArgs args) -> Value {
              if (args.size() < 2) return Value("", 0, false);
-             std::string prefix = args[0].strVal;
+             std::string prefix = args[0].strVal();
              Value callback = args[1];
 
              std::string oldPrefix = instance->currentPrefix;
@@ -256,46 +256,46 @@ void register_webserver(Interpreter& interpreter) {
              return Value("", 1, true); 
         });
 
-        server_obj["get"] = Value([instance](std::vector<Value> args) -> Value {
+        server_obj["get"] = Value([instance](Interpreter&, NativeArgs args) -> Value {
             if (args.size() < 2) return Value("", 0, false);
-            instance->add_route("GET", args[0].strVal, args[1]);
+            instance->add_route("GET", args[0].strVal(), args[1]);
             return Value("", 1, true); 
         });
 
-        server_obj["post"] = Value([instance](std::vector<Value> args) -> Value {
+        server_obj["post"] = Value([instance](Interpreter&, NativeArgs args) -> Value {
             if (args.size() < 2) return Value("", 0, false);
-            instance->add_route("POST", args[0].strVal, args[1]);
+            instance->add_route("POST", args[0].strVal(), args[1]);
             return Value("", 1, true);
         });
 
-        server_obj["put"] = Value([instance](std::vector<Value> args) -> Value {
+        server_obj["put"] = Value([instance](Interpreter&, NativeArgs args) -> Value {
             if (args.size() < 2) return Value("", 0, false);
-            instance->add_route("PUT", args[0].strVal, args[1]);
+            instance->add_route("PUT", args[0].strVal(), args[1]);
             return Value("", 1, true);
         });
 
-        server_obj["delete"] = Value([instance](std::vector<Value> args) -> Value {
+        server_obj["delete"] = Value([instance](Interpreter&, NativeArgs args) -> Value {
             if (args.size() < 2) return Value("", 0, false);
-            instance->add_route("DELETE", args[0].strVal, args[1]);
+            instance->add_route("DELETE", args[0].strVal(), args[1]);
             return Value("", 1, true);
         });
 
-        server_obj["patch"] = Value([instance](std::vector<Value> args) -> Value {
+        server_obj["patch"] = Value([instance](Interpreter&, NativeArgs args) -> Value {
             if (args.size() < 2) return Value("", 0, false);
-            instance->add_route("PATCH", args[0].strVal, args[1]);
+            instance->add_route("PATCH", args[0].strVal(), args[1]);
             return Value("", 1, true);
         });
 
-        server_obj["listen"] = Value([instance](std::vector<Value> args) -> Value {
+        server_obj["listen"] = Value([instance](Interpreter&, NativeArgs args) -> Value {
             int port = 3000;
             std::string cert = "";
             std::string key = "";
             
-            if (!args.empty() && args[0].isMap) {
-                auto m = args[0].mapVal;
-                if (m->count("port") && (*m)["port"].isInt) port = (*m)["port"].intVal;
-                if (m->count("cert") && (*m)["cert"].isInt == false) cert = (*m)["cert"].strVal;
-                if (m->count("key") && (*m)["key"].isInt == false) key = (*m)["key"].strVal;
+            if (!args.empty() && args[0].isMap()) {
+                auto m = args[0].mapVal();
+                if (m->count("port") && (*m)["port"].isInt()) port = (*m)["port"].intVal();
+                if (m->count("cert") && (*m)["cert"].isInt() == false) cert = (*m)["cert"].strVal();
+                if (m->count("key") && (*m)["key"].isInt() == false) key = (*m)["key"].strVal();
             }
             instance->listen(port, *s_interpreter, cert, key);
             return Value("", 0, false);